@@ -0,0 +1,709 @@
+#include "analysis.h"
+
+#include "crisp8_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The index register is tracked as a value per block entry: one of these, or the known 16 bit value
+#define INDEX_UNVISITED -2
+#define INDEX_UNKNOWN   -1
+
+struct crisp8Analysis_s
+{
+    uint32_t memorySize;
+    uint32_t flags;
+
+    // enum crisp8AddressFlags per address
+    uint8_t* addressFlags;
+
+    struct crisp8BasicBlock* blocks;
+    uint32_t numBlocks;
+
+    uint16_t* callTargets;
+    uint32_t numCallTargets;
+
+    struct crisp8DataRegion* regions;
+    uint32_t numRegions;
+    uint32_t regionCapacity;
+};
+
+// How an instruction affects control flow
+enum flow
+{
+    // Execution goes on with the next instruction
+    FLOW_NEXT,
+    FLOW_JUMP,
+    FLOW_CALL,
+    FLOW_RETURN,
+    FLOW_SKIP,
+    FLOW_COMPUTED_JUMP,
+    FLOW_EXIT
+};
+
+// The state kept while analysing
+struct analyser
+{
+    struct crisp8Analysis_s* analysis;
+    const uint8_t* memory;
+    uint32_t memorySize;
+
+    // The index register on entry to every block (see INDEX_UNVISITED)
+    int32_t* entryIndex;
+};
+
+// Reads the instruction at an address
+static uint16_t readInstruction (const struct analyser* analyser, uint32_t address)
+{
+    uint32_t mask = analyser->memorySize - 1;
+    return (uint16_t)analyser->memory [address & mask] << 8 | analyser->memory [(address + 1) & mask];
+}
+
+// Returns the length of the instruction at an address: 4 for F000 NNNN, otherwise 2
+static uint32_t instructionLength (const struct analyser* analyser, uint32_t address)
+{
+    return readInstruction (analyser, address) == 0xF000 ? 4 : 2;
+}
+
+// Works out how an instruction affects control flow
+//
+// Parameters:
+//  instruction: the instruction
+//  target: set to the jump or call target
+static enum flow instructionFlow (uint16_t instruction, uint16_t* target)
+{
+    *target = instruction & 0x0FFF;
+
+    switch (instruction >> 12)
+    {
+        case 0x0:
+            return instruction == 0x00EE ? FLOW_RETURN : instruction == 0x00FD ? FLOW_EXIT : FLOW_NEXT;
+        case 0x1:
+            return FLOW_JUMP;
+        case 0x2:
+            return FLOW_CALL;
+        case 0x3:
+        case 0x4:
+        case 0x9:
+            return FLOW_SKIP;
+        case 0x5:
+            return (instruction & 0xF) == 0 ? FLOW_SKIP : FLOW_NEXT;
+        case 0xB:
+            return FLOW_COMPUTED_JUMP;
+        case 0xE:
+            return (instruction & 0xFF) == 0x9E || (instruction & 0xFF) == 0xA1 ? FLOW_SKIP : FLOW_NEXT;
+        default:
+            return FLOW_NEXT;
+    }
+}
+
+// Marks an address as the start of a block and queues it, if it hasn't been seen yet
+//
+// Parameters:
+//  analyser: the analyser
+//  address: the address
+//  queue: the addresses left to look at
+//  queued: the number of addresses in the queue
+static void addLeader (struct analyser* analyser, uint32_t address, uint16_t* queue, uint32_t* queued)
+{
+    uint8_t* flags = &analyser->analysis->addressFlags [address];
+
+    *flags |= CRISP8_ADDRESS_BLOCK_START;
+    if (!(*flags & CRISP8_ADDRESS_INSTRUCTION))
+    {
+        *flags |= CRISP8_ADDRESS_INSTRUCTION;
+        queue [(*queued)++] = address;
+    }
+}
+
+// Finds every reachable instruction and marks the addresses blocks start at
+//
+// Return value:
+//  Negative if memory could not be allocated
+static int findInstructions (struct analyser* analyser)
+{
+    uint8_t* addressFlags = analyser->analysis->addressFlags;
+
+    // Every address is queued at most once, when it's first marked as an instruction
+    uint16_t* queue = malloc (analyser->memorySize * sizeof (uint16_t));
+    if (!queue)
+    {
+        return -1;
+    }
+
+    uint32_t queued = 0;
+    addLeader (analyser, CRISP8_PROGRAM_START_ADDRESS, queue, &queued);
+
+    while (queued > 0)
+    {
+        uint32_t address = queue [--queued];
+        uint16_t instruction = readInstruction (analyser, address);
+        uint32_t next = address + instructionLength (analyser, address);
+        uint16_t target;
+        enum flow flow = instructionFlow (instruction, &target);
+
+        for (uint32_t i = address; i < next && i < analyser->memorySize; i++)
+        {
+            addressFlags [i] |= CRISP8_ADDRESS_CODE;
+        }
+
+        // Running off the end of memory is treated like an exit
+        bool nextInMemory = next < analyser->memorySize;
+
+        switch (flow)
+        {
+            case FLOW_NEXT:
+                if (nextInMemory && !(addressFlags [next] & CRISP8_ADDRESS_INSTRUCTION))
+                {
+                    addressFlags [next] |= CRISP8_ADDRESS_INSTRUCTION;
+                    queue [queued++] = next;
+                }
+                break;
+            case FLOW_JUMP:
+                addLeader (analyser, target, queue, &queued);
+                break;
+            case FLOW_CALL:
+                addLeader (analyser, target, queue, &queued);
+                if (nextInMemory)
+                {
+                    addLeader (analyser, next, queue, &queued);
+                }
+                break;
+            case FLOW_SKIP:
+                if (nextInMemory)
+                {
+                    addLeader (analyser, next, queue, &queued);
+
+                    uint32_t skipped = next + instructionLength (analyser, next);
+                    if (skipped < analyser->memorySize)
+                    {
+                        addLeader (analyser, skipped, queue, &queued);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    free (queue);
+    return 0;
+}
+
+// Orders blocks by start address
+static int compareBlocks (const void* a, const void* b)
+{
+    return (int)((const struct crisp8BasicBlock*)a)->start - (int)((const struct crisp8BasicBlock*)b)->start;
+}
+
+// Returns the address after the last instruction of a block. With 64 KiB of memory, a block running to the end of
+// memory has its end wrap to 0
+static uint32_t blockEnd (const struct crisp8BasicBlock* block)
+{
+    return block->end > block->start ? block->end : block->end + 0x10000;
+}
+
+// Builds a block starting at an address, following the instructions until one changes control flow or the next one
+// starts another block
+//
+// Parameters:
+//  analyser: the analyser
+//  start: the start address
+//  block: the block to fill in
+static void buildBlock (struct analyser* analyser, uint32_t start, struct crisp8BasicBlock* block)
+{
+    const uint8_t* addressFlags = analyser->analysis->addressFlags;
+    uint32_t address = start;
+
+    memset (block, 0, sizeof (*block));
+    block->start = start;
+
+    for (;;)
+    {
+        uint16_t instruction = readInstruction (analyser, address);
+        uint32_t next = address + instructionLength (analyser, address);
+        uint16_t target;
+        enum flow flow = instructionFlow (instruction, &target);
+
+        block->end = next;
+
+        if (next >= analyser->memorySize && flow != FLOW_JUMP && flow != FLOW_RETURN)
+        {
+            // The call or computed jump is still made; only the instruction after it is missing
+            block->flags |= CRISP8_BLOCK_ENDS_IN_EXIT;
+            block->flags |= flow == FLOW_CALL ? CRISP8_BLOCK_ENDS_IN_CALL : 0;
+            block->flags |= flow == FLOW_COMPUTED_JUMP ? CRISP8_BLOCK_ENDS_IN_COMPUTED_JUMP : 0;
+            block->callTarget = flow == FLOW_CALL ? target : 0;
+            return;
+        }
+
+        switch (flow)
+        {
+            case FLOW_NEXT:
+                if (addressFlags [next] & CRISP8_ADDRESS_BLOCK_START)
+                {
+                    block->successors [block->numSuccessors++] = next;
+                    return;
+                }
+
+                address = next;
+                break;
+            case FLOW_JUMP:
+                block->successors [block->numSuccessors++] = target;
+                return;
+            case FLOW_CALL:
+                block->successors [block->numSuccessors++] = next;
+                block->callTarget = target;
+                block->flags |= CRISP8_BLOCK_ENDS_IN_CALL;
+                return;
+            case FLOW_RETURN:
+                block->flags |= CRISP8_BLOCK_ENDS_IN_RETURN;
+                return;
+            case FLOW_SKIP:
+            {
+                block->successors [block->numSuccessors++] = next;
+
+                uint32_t skipped = next + instructionLength (analyser, next);
+                if (skipped < analyser->memorySize)
+                {
+                    block->successors [block->numSuccessors++] = skipped;
+                }
+                else
+                {
+                    block->flags |= CRISP8_BLOCK_ENDS_IN_EXIT;
+                }
+                return;
+            }
+            case FLOW_COMPUTED_JUMP:
+                block->flags |= CRISP8_BLOCK_ENDS_IN_COMPUTED_JUMP;
+                analyser->analysis->flags |= CRISP8_ANALYSIS_COMPUTED_JUMPS;
+                return;
+            case FLOW_EXIT:
+                block->flags |= CRISP8_BLOCK_ENDS_IN_EXIT;
+                return;
+        }
+    }
+}
+
+// Builds every block and the list of call targets
+//
+// Return value:
+//  Negative if memory could not be allocated
+static int buildBlocks (struct analyser* analyser)
+{
+    struct crisp8Analysis_s* analysis = analyser->analysis;
+    uint32_t numBlocks = 0;
+
+    for (uint32_t address = 0; address < analyser->memorySize; address++)
+    {
+        numBlocks += (analysis->addressFlags [address] & CRISP8_ADDRESS_BLOCK_START) != 0;
+    }
+
+    analysis->blocks = malloc (numBlocks * sizeof (struct crisp8BasicBlock));
+    analysis->callTargets = malloc (numBlocks * sizeof (uint16_t));
+    if (!analysis->blocks || !analysis->callTargets)
+    {
+        return -1;
+    }
+
+    // Blocks are built in address order, so they come out sorted
+    for (uint32_t address = 0; address < analyser->memorySize; address++)
+    {
+        if (analysis->addressFlags [address] & CRISP8_ADDRESS_BLOCK_START)
+        {
+            buildBlock (analyser, address, &analysis->blocks [analysis->numBlocks++]);
+        }
+    }
+
+    for (uint32_t i = 0; i < analysis->numBlocks; i++)
+    {
+        if (analysis->blocks [i].flags & CRISP8_BLOCK_ENDS_IN_CALL)
+        {
+            struct crisp8BasicBlock* callee = (struct crisp8BasicBlock*)crisp8AnalysisFindBlock (
+                analysis, analysis->blocks [i].callTarget);
+
+            if (callee)
+            {
+                callee->flags |= CRISP8_BLOCK_CALL_TARGET;
+            }
+        }
+    }
+
+    // Going through the blocks again lists every target once, in address order
+    for (uint32_t i = 0; i < analysis->numBlocks; i++)
+    {
+        if (analysis->blocks [i].flags & CRISP8_BLOCK_CALL_TARGET)
+        {
+            analysis->callTargets [analysis->numCallTargets++] = analysis->blocks [i].start;
+        }
+    }
+
+    return 0;
+}
+
+// Records an access to memory at a known address
+//
+// Return value:
+//  Negative if memory could not be allocated
+static int addRegion (struct crisp8Analysis_s* analysis, uint16_t start, uint16_t size, enum crisp8DataKind kind,
+                      uint16_t instruction)
+{
+    if (analysis->numRegions == analysis->regionCapacity)
+    {
+        uint32_t capacity = analysis->regionCapacity ? analysis->regionCapacity * 2 : 64;
+        struct crisp8DataRegion* grown = realloc (analysis->regions, capacity * sizeof (struct crisp8DataRegion));
+        if (!grown)
+        {
+            return -1;
+        }
+
+        analysis->regions = grown;
+        analysis->regionCapacity = capacity;
+    }
+
+    analysis->regions [analysis->numRegions++] = (struct crisp8DataRegion){start, size, kind, instruction};
+    return 0;
+}
+
+// Runs the instructions of a block on the index register. With record set, the memory accesses are recorded too
+//
+// Parameters:
+//  analyser: the analyser
+//  block: the block
+//  index: the index register on entry, or INDEX_UNKNOWN
+//  record: true to record the accesses
+//
+// Return value:
+//  The index register at the end of the block. INDEX_UNVISITED if recording ran out of memory
+static int32_t runBlock (struct analyser* analyser, const struct crisp8BasicBlock* block, int32_t index, bool record)
+{
+    struct crisp8Analysis_s* analysis = analyser->analysis;
+
+    for (uint32_t address = block->start; address < blockEnd (block); address += instructionLength (analyser, address))
+    {
+        uint16_t instruction = readInstruction (analyser, address);
+        uint8_t x = (instruction >> 8) & 0xF;
+        uint8_t y = (instruction >> 4) & 0xF;
+        uint16_t size = 0;
+        int kind = -1;
+
+        switch (instruction >> 12)
+        {
+            case 0x5:
+                if ((instruction & 0xF) == 2 || (instruction & 0xF) == 3)
+                {
+                    size = (x > y ? x - y : y - x) + 1;
+                    kind = (instruction & 0xF) == 2 ? CRISP8_DATA_WRITTEN : CRISP8_DATA_READ;
+                }
+                break;
+            case 0xA:
+                index = instruction & 0x0FFF;
+                break;
+            case 0xD:
+                size = (instruction & 0xF) ? instruction & 0xF : 32;
+                kind = CRISP8_DATA_SPRITE;
+                break;
+            case 0xF:
+                switch (instruction & 0xFF)
+                {
+                    case 0x00:
+                        index = instruction == 0xF000 ? readInstruction (analyser, address + 2) : index;
+                        break;
+                    case 0x1E:
+                    case 0x29:
+                    case 0x30:
+                        index = INDEX_UNKNOWN;
+                        break;
+                    case 0x33:
+                        size = 3;
+                        kind = CRISP8_DATA_WRITTEN;
+                        break;
+                    case 0x55:
+                    case 0x65:
+                        size = x + 1;
+                        kind = (instruction & 0xFF) == 0x55 ? CRISP8_DATA_WRITTEN : CRISP8_DATA_READ;
+                        break;
+                }
+                break;
+        }
+
+        if (record && kind >= 0)
+        {
+            if (index == INDEX_UNKNOWN)
+            {
+                analysis->flags |= kind == CRISP8_DATA_WRITTEN ? CRISP8_ANALYSIS_UNKNOWN_WRITES
+                                                              : CRISP8_ANALYSIS_UNKNOWN_READS;
+            }
+            else if (addRegion (analysis, index, size, kind, address) < 0)
+            {
+                return INDEX_UNVISITED;
+            }
+        }
+
+        // Whether FX55 and FX65 move the index register depends on the configuration
+        if ((instruction & 0xF0FF) == 0xF055 || (instruction & 0xF0FF) == 0xF065)
+        {
+            index = INDEX_UNKNOWN;
+        }
+    }
+
+    return index;
+}
+
+// Merges the index register flowing into a block with what's known about it already
+//
+// Parameters:
+//  analyser: the analyser
+//  address: the start address of the block
+//  index: the index register flowing in
+//  worklist: gets the block if its entry value changed
+//  pending: the number of blocks in the worklist
+//  queued: which blocks are in the worklist
+static void mergeIndex (struct analyser* analyser, uint16_t address, int32_t index, uint32_t* worklist,
+                        uint32_t* pending, bool* queued)
+{
+    const struct crisp8BasicBlock* block = crisp8AnalysisFindBlock (analyser->analysis, address);
+    if (!block)
+    {
+        return;
+    }
+
+    uint32_t i = block - analyser->analysis->blocks;
+    int32_t merged = analyser->entryIndex [i] == INDEX_UNVISITED || analyser->entryIndex [i] == index ? index
+                                                                                                       : INDEX_UNKNOWN;
+
+    if (merged != analyser->entryIndex [i])
+    {
+        analyser->entryIndex [i] = merged;
+        if (!queued [i])
+        {
+            queued [i] = true;
+            worklist [(*pending)++] = i;
+        }
+    }
+}
+
+// Works out the index register on entry to every block, then records the memory accesses
+//
+// Return value:
+//  Negative if memory could not be allocated
+static int trackIndex (struct analyser* analyser)
+{
+    struct crisp8Analysis_s* analysis = analyser->analysis;
+    uint32_t numBlocks = analysis->numBlocks;
+
+    analyser->entryIndex = malloc (numBlocks * sizeof (int32_t));
+    uint32_t* worklist = malloc (numBlocks * sizeof (uint32_t));
+    bool* queued = calloc (numBlocks, sizeof (bool));
+    int result = -1;
+
+    if (analyser->entryIndex && worklist && queued)
+    {
+        for (uint32_t i = 0; i < numBlocks; i++)
+        {
+            analyser->entryIndex [i] = INDEX_UNVISITED;
+        }
+
+        // The index register starts at 0. Every value only ever goes from unvisited to known to unknown, so this ends
+        uint32_t pending = 0;
+        mergeIndex (analyser, CRISP8_PROGRAM_START_ADDRESS, 0, worklist, &pending, queued);
+
+        while (pending > 0)
+        {
+            uint32_t i = worklist [--pending];
+            queued [i] = false;
+
+            const struct crisp8BasicBlock* block = &analysis->blocks [i];
+            int32_t index = runBlock (analyser, block, analyser->entryIndex [i], false);
+
+            if (block->flags & CRISP8_BLOCK_ENDS_IN_CALL)
+            {
+                // The subroutine may change the index register before it returns
+                mergeIndex (analyser, block->callTarget, index, worklist, &pending, queued);
+                if (block->numSuccessors > 0)
+                {
+                    mergeIndex (analyser, block->successors [0], INDEX_UNKNOWN, worklist, &pending, queued);
+                }
+            }
+            else
+            {
+                for (int successor = 0; successor < block->numSuccessors; successor++)
+                {
+                    mergeIndex (analyser, block->successors [successor], index, worklist, &pending, queued);
+                }
+            }
+        }
+
+        result = 0;
+        for (uint32_t i = 0; i < numBlocks && result == 0; i++)
+        {
+            int32_t entry = analyser->entryIndex [i] == INDEX_UNVISITED ? INDEX_UNKNOWN : analyser->entryIndex [i];
+            if (runBlock (analyser, &analysis->blocks [i], entry, true) == INDEX_UNVISITED)
+            {
+                result = -1;
+            }
+        }
+    }
+
+    free (analyser->entryIndex);
+    free (worklist);
+    free (queued);
+
+    return result;
+}
+
+// Orders regions by start address, then by the instruction making the access
+static int compareRegions (const void* a, const void* b)
+{
+    const struct crisp8DataRegion* first = a;
+    const struct crisp8DataRegion* second = b;
+
+    if (first->start != second->start)
+    {
+        return (int)first->start - (int)second->start;
+    }
+
+    return (int)first->instruction - (int)second->instruction;
+}
+
+// Sorts the regions, marks the addresses they cover and flags the blocks that may be overwritten
+static void markRegions (struct analyser* analyser)
+{
+    struct crisp8Analysis_s* analysis = analyser->analysis;
+    uint32_t mask = analyser->memorySize - 1;
+
+    if (analysis->numRegions > 0)
+    {
+        qsort (analysis->regions, analysis->numRegions, sizeof (struct crisp8DataRegion), compareRegions);
+    }
+
+    static const uint8_t kindFlags [] = {
+        [CRISP8_DATA_SPRITE] = CRISP8_ADDRESS_SPRITE,
+        [CRISP8_DATA_READ] = CRISP8_ADDRESS_READ,
+        [CRISP8_DATA_WRITTEN] = CRISP8_ADDRESS_WRITTEN,
+    };
+
+    for (uint32_t i = 0; i < analysis->numRegions; i++)
+    {
+        const struct crisp8DataRegion* region = &analysis->regions [i];
+        for (uint32_t offset = 0; offset < region->size; offset++)
+        {
+            uint8_t* flags = &analysis->addressFlags [(region->start + offset) & mask];
+            *flags |= kindFlags [region->kind];
+
+            if (region->kind == CRISP8_DATA_WRITTEN && (*flags & CRISP8_ADDRESS_CODE))
+            {
+                analysis->flags |= CRISP8_ANALYSIS_SELF_MODIFYING;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < analysis->numBlocks; i++)
+    {
+        struct crisp8BasicBlock* block = &analysis->blocks [i];
+        for (uint32_t address = block->start; address < blockEnd (block) && address < analyser->memorySize; address++)
+        {
+            if (analysis->addressFlags [address] & CRISP8_ADDRESS_WRITTEN)
+            {
+                block->flags |= CRISP8_BLOCK_WRITTEN;
+                break;
+            }
+        }
+    }
+}
+
+int8_t crisp8AnalysisCreate (crisp8Analysis* analysis, const uint8_t* program, uint32_t size, uint32_t memorySize)
+{
+    if (memorySize == 0)
+    {
+        memorySize = CRISP8_MEMORY_SIZE;
+        while (memorySize < CRISP8_XO_MEMORY_SIZE && size > memorySize - CRISP8_PROGRAM_START_ADDRESS)
+        {
+            memorySize <<= 1;
+        }
+    }
+
+    if (memorySize < CRISP8_MEMORY_SIZE || memorySize > CRISP8_XO_MEMORY_SIZE || (memorySize & (memorySize - 1)) ||
+        size > memorySize - CRISP8_PROGRAM_START_ADDRESS)
+    {
+        return -1;
+    }
+
+    *analysis = calloc (1, sizeof (**analysis));
+    uint8_t* memory = calloc (memorySize, 1);
+
+    if (!(*analysis) || !memory || !((*analysis)->addressFlags = calloc (memorySize, 1)))
+    {
+        free (memory);
+        crisp8AnalysisDestroy (analysis);
+        return -1;
+    }
+
+    crisp8LoadFont (memory);
+    memcpy (memory + CRISP8_PROGRAM_START_ADDRESS, program, size);
+
+    (*analysis)->memorySize = memorySize;
+
+    struct analyser analyser = {*analysis, memory, memorySize, NULL};
+    int result = findInstructions (&analyser);
+    result = result < 0 ? result : buildBlocks (&analyser);
+    result = result < 0 ? result : trackIndex (&analyser);
+
+    free (memory);
+
+    if (result < 0)
+    {
+        crisp8AnalysisDestroy (analysis);
+        return -1;
+    }
+
+    markRegions (&analyser);
+    return 0;
+}
+
+void crisp8AnalysisDestroy (crisp8Analysis* analysis)
+{
+    if (*analysis)
+    {
+        free ((*analysis)->addressFlags);
+        free ((*analysis)->blocks);
+        free ((*analysis)->callTargets);
+        free ((*analysis)->regions);
+        free (*analysis);
+        *analysis = NULL;
+    }
+}
+
+const struct crisp8BasicBlock* crisp8AnalysisGetBlocks (crisp8Analysis analysis, uint32_t* count)
+{
+    *count = analysis->numBlocks;
+    return analysis->blocks;
+}
+
+const struct crisp8BasicBlock* crisp8AnalysisFindBlock (crisp8Analysis analysis, uint16_t address)
+{
+    struct crisp8BasicBlock key = {.start = address};
+    return bsearch (&key, analysis->blocks, analysis->numBlocks, sizeof (struct crisp8BasicBlock), compareBlocks);
+}
+
+const uint16_t* crisp8AnalysisGetCallTargets (crisp8Analysis analysis, uint32_t* count)
+{
+    *count = analysis->numCallTargets;
+    return analysis->callTargets;
+}
+
+const struct crisp8DataRegion* crisp8AnalysisGetDataRegions (crisp8Analysis analysis, uint32_t* count)
+{
+    *count = analysis->numRegions;
+    return analysis->regions;
+}
+
+uint8_t crisp8AnalysisGetAddressFlags (crisp8Analysis analysis, uint16_t address)
+{
+    return analysis->addressFlags [address & (analysis->memorySize - 1)];
+}
+
+uint32_t crisp8AnalysisGetFlags (crisp8Analysis analysis)
+{
+    return analysis->flags;
+}
@@ -0,0 +1,183 @@
+#include "breakpoint.h"
+
+#include "breakpoint_private.h"
+#include "crisp8_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Allocates the breakpoint struct of an emulator if it doesn't have one yet
+//
+// Parameters:
+//  emulator: the emulator to allocate breakpoints for
+//
+// Return value:
+//  Negative if memory could not be allocated
+static int8_t allocateBreakpoints (chip8 emulator)
+{
+    if (emulator->breakpoints)
+    {
+        return 0;
+    }
+
+    emulator->breakpoints = calloc (1, sizeof (*emulator->breakpoints));
+    if (!emulator->breakpoints)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+// Frees the breakpoint struct of an emulator if it's no longer used, which brings the run functions back onto their
+// unchecked loops
+//
+// Parameters:
+//  emulator: the emulator to free breakpoints of
+static void releaseBreakpointsIfUnused (chip8 emulator)
+{
+    struct crisp8Breakpoints* breakpoints = emulator->breakpoints;
+    if (breakpoints && breakpoints->numBreakpoints == 0 && breakpoints->numWatchpoints == 0)
+    {
+        crisp8BreakpointClearAll (emulator);
+    }
+}
+
+int8_t crisp8BreakpointSet (chip8 emulator, uint16_t address)
+{
+    if (address >= emulator->memorySize || allocateBreakpoints (emulator) < 0)
+    {
+        return -1;
+    }
+
+    if (!crisp8BreakpointIsSet (emulator, address))
+    {
+        emulator->breakpoints->bitmap [address / 64] |= (uint64_t)1 << (address % 64);
+        emulator->breakpoints->numBreakpoints++;
+    }
+
+    return 0;
+}
+
+void crisp8BreakpointClear (chip8 emulator, uint16_t address)
+{
+    if (!crisp8BreakpointIsSet (emulator, address))
+    {
+        return;
+    }
+
+    emulator->breakpoints->bitmap [address / 64] &= ~((uint64_t)1 << (address % 64));
+    emulator->breakpoints->numBreakpoints--;
+
+    releaseBreakpointsIfUnused (emulator);
+}
+
+bool crisp8BreakpointIsSet (chip8 emulator, uint16_t address)
+{
+    if (!emulator->breakpoints)
+    {
+        return false;
+    }
+
+    return crisp8BreakpointHit (emulator->breakpoints, address);
+}
+
+int8_t crisp8WatchpointAdd (chip8 emulator, uint16_t start, uint16_t end, enum crisp8WatchType type)
+{
+    if (start > end || end >= emulator->memorySize || !(type & CRISP8_WATCH_READ_WRITE) ||
+        allocateBreakpoints (emulator) < 0)
+    {
+        return -1;
+    }
+
+    struct crisp8Breakpoints* breakpoints = emulator->breakpoints;
+    for (int8_t i = 0; i < CRISP8_MAX_WATCHPOINTS; i++)
+    {
+        if (breakpoints->watchpoints [i].type == 0)
+        {
+            breakpoints->watchpoints [i].start = start;
+            breakpoints->watchpoints [i].end = end;
+            breakpoints->watchpoints [i].type = type;
+            breakpoints->numWatchpoints++;
+
+            emulator->watching = true;
+            return i;
+        }
+    }
+
+    releaseBreakpointsIfUnused (emulator);
+    return -1;
+}
+
+void crisp8WatchpointRemove (chip8 emulator, int8_t id)
+{
+    struct crisp8Breakpoints* breakpoints = emulator->breakpoints;
+    if (!breakpoints || id < 0 || id >= CRISP8_MAX_WATCHPOINTS || breakpoints->watchpoints [id].type == 0)
+    {
+        return;
+    }
+
+    breakpoints->watchpoints [id].type = 0;
+    breakpoints->numWatchpoints--;
+    emulator->watching = breakpoints->numWatchpoints > 0;
+
+    releaseBreakpointsIfUnused (emulator);
+}
+
+void crisp8BreakpointClearAll (chip8 emulator)
+{
+    free (emulator->breakpoints);
+    emulator->breakpoints = NULL;
+    emulator->watching = false;
+}
+
+// Checks a range of addresses that doesn't wrap around the end of memory against the watchpoints
+//
+// Parameters:
+//  breakpoints: the breakpoints of the emulator making the access
+//  first: the first accessed address
+//  last: the last accessed address
+//  type: CRISP8_WATCH_READ or CRISP8_WATCH_WRITE
+static void checkRange (struct crisp8Breakpoints* breakpoints, uint32_t first, uint32_t last, enum crisp8WatchType type)
+{
+    for (int8_t i = 0; i < CRISP8_MAX_WATCHPOINTS; i++)
+    {
+        const struct crisp8Watchpoint* watchpoint = &breakpoints->watchpoints [i];
+        if ((watchpoint->type & type) && first <= watchpoint->end && last >= watchpoint->start)
+        {
+            breakpoints->watchpointHit = true;
+            breakpoints->hitWatchpoint = i;
+            breakpoints->hitAddress = first > watchpoint->start ? first : watchpoint->start;
+            breakpoints->hitType = type;
+            return;
+        }
+    }
+}
+
+void crisp8BreakpointCheckAccess (chip8 emulator, uint16_t address, uint16_t length, enum crisp8WatchType type)
+{
+    struct crisp8Breakpoints* breakpoints = emulator->breakpoints;
+
+    // Only the first triggered watchpoint of an instruction is reported
+    if (breakpoints->watchpointHit)
+    {
+        return;
+    }
+
+    // Accesses wrap around the end of memory the way MEMORY_AT does, so one running past it is checked as two ranges
+    uint32_t first = address & emulator->memoryMask;
+    uint32_t last = first + length - 1;
+
+    if (last > emulator->memoryMask)
+    {
+        checkRange (breakpoints, first, emulator->memoryMask, type);
+        if (!breakpoints->watchpointHit)
+        {
+            checkRange (breakpoints, 0, last & emulator->memoryMask, type);
+        }
+    }
+    else
+    {
+        checkRange (breakpoints, first, last, type);
+    }
+}
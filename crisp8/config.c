@@ -1,9 +1,11 @@
 #include "config.h"
 #include "crisp8_private.h"
+#include "instructions.h"
 
 void crisp8ConfigSetShift (enum crisp8ConfigValue value, chip8 emulator)
 {
     emulator->config.instructionShift = value;
+    selectDispatchVariant (emulator);
 }
 
 enum crisp8ConfigValue crisp8ConfigGetShift (chip8 emulator)
@@ -14,6 +16,7 @@ enum crisp8ConfigValue crisp8ConfigGetShift (chip8 emulator)
 void crisp8ConfigSetJumpOffset (enum crisp8ConfigValue value, chip8 emulator)
 {
     emulator->config.instructionJumpOffset = value;
+    selectDispatchVariant (emulator);
 }
 
 enum crisp8ConfigValue crisp8ConfigGetJumpOffset (chip8 emulator)
@@ -24,6 +27,7 @@ enum crisp8ConfigValue crisp8ConfigGetJumpOffset (chip8 emulator)
 void crisp8ConfigSetStoreLoadMemory (enum crisp8ConfigValue value, chip8 emulator)
 {
     emulator->config.instructionStoreLoadMemory = value;
+    selectDispatchVariant (emulator);
 }
 
 enum crisp8ConfigValue crisp8ConfigGetStoreLoadMemory (chip8 emulator)
@@ -0,0 +1,28 @@
+#include "counters.h"
+
+#include "crisp8_private.h"
+
+#include <string.h>
+
+void crisp8CountersGet (chip8 emulator, struct crisp8Counters* counters)
+{
+    const struct crisp8CounterBlock* block = &emulator->counters;
+
+    counters->instructions = emulator->cycleCount - block->baseCycle;
+    counters->frames = emulator->framerate ? counters->instructions * 60 / emulator->framerate : 0;
+    counters->draws = block->draws;
+    counters->pixelsFlipped = block->pixelsFlipped;
+    counters->collisions = block->collisions;
+    counters->idleCycles = block->idleCycles;
+    counters->keyWaitCycles = block->keyWaitCycles;
+    counters->faults = block->faults;
+    counters->fusedInstructions = block->fusedInstructions;
+    counters->stackHighWater = block->stackHighWater;
+}
+
+void crisp8CountersReset (chip8 emulator)
+{
+    memset (&emulator->counters, 0, sizeof (emulator->counters));
+    emulator->counters.baseCycle = emulator->cycleCount;
+    emulator->counters.stackHighWater = emulator->stack.stackPtr - emulator->stack.stack;
+}
@@ -1,17 +1,32 @@
 #include "crisp8_private.h"
 #include "crisp8.h"
 #include "instructions.h"
+#include "display.h"
+#include "trace.h"
+#include "breakpoint.h"
+#include "breakpoint_private.h"
+#include "drawcommands.h"
+#include "rom_private.h"
+#include "fusion.h"
+#include "fusion_private.h"
+#include "memory_private.h"
+#include "stack_private.h"
+
+#ifdef CRISP8_TRACE
+#include "trace_private.h"
+#endif
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
 
-// Loads the font of the chip-8 into its memory
-//
-// Parameters:
-//  emulator: the emulator to load the font into
-static void loadFont (chip8 emulator)
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+void crisp8LoadFont (uint8_t* memory)
 {
     // This is a commonly used font. I might design my own in the future
     const uint8_t font [] = {
@@ -33,7 +48,28 @@ static void loadFont (chip8 emulator)
         0xF0, 0x80, 0xF0, 0x80, 0x80  	// F
     };
 
-    memcpy (emulator->memory + CRISP8_FONT_START_ADDRESS, font, sizeof (font));
+    // The SUPER-CHIP's 8x10 font
+    const uint8_t bigFont [] = {
+        0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF,   // 0
+        0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF,   // 1
+        0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF,   // 2
+        0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,   // 3
+        0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03,   // 4
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,   // 5
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF,   // 6
+        0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18,   // 7
+        0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF,   // 8
+        0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,   // 9
+        0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3,   // A
+        0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC,   // B
+        0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C,   // C
+        0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC,   // D
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF,   // E
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0    // F
+    };
+
+    memcpy (memory + CRISP8_FONT_START_ADDRESS, font, sizeof (font));
+    memcpy (memory + CRISP8_BIG_FONT_START_ADDRESS, bigFont, sizeof (bigFont));
 }
 
 // Decrements the delay timer by the appropriate amount if it is greater than 0
@@ -47,7 +83,7 @@ static void decrementDelayTimer (chip8 emulator)
         return;
     }
 
-    emulator->delayTimerRemainder += (60.0f / emulator->framerate);
+    emulator->delayTimerRemainder += emulator->timerStep;
 
     if (emulator->delayTimerRemainder > 1)
     {
@@ -61,6 +97,7 @@ static void decrementDelayTimer (chip8 emulator)
         }
 
         emulator->delayTimerRemainder -= (uint8_t)emulator->delayTimerRemainder;
+        emulator->events |= CRISP8_EVENT_TIMER;
     }
 }
 
@@ -75,7 +112,7 @@ static void decrementSoundTimer (chip8 emulator)
         return;
     }
 
-    emulator->soundTimerRemainder += (60.0f / emulator->framerate);
+    emulator->soundTimerRemainder += emulator->timerStep;
 
     if (emulator->soundTimerRemainder > 1)
     {
@@ -89,6 +126,7 @@ static void decrementSoundTimer (chip8 emulator)
         }
 
         emulator->soundTimerRemainder -= (uint8_t)emulator->soundTimerRemainder;
+        emulator->events |= CRISP8_EVENT_TIMER;
     }
 }
 
@@ -102,22 +140,6 @@ static void decrementTimers (chip8 emulator)
     decrementSoundTimer (emulator);
 }
 
-// Decrement the alpha value of pixels in the framebuffer if they are turned off to give them an old monitor effect.
-// This is only called if crisp8 is compiled with CRISP8_DISPLAY_USE_ALPHA defined
-#ifdef CRISP8_DISPLAY_USE_ALPHA
-static void decrementDisplayAlpha (chip8 emulator)
-{
-    for (int i = 0; i < CRISP8_DISPLAY_WIDTH * CRISP8_DISPLAY_HEIGHT; i++)
-    {
-        // A pixel is deemed off if is not at full brightness. This just slowly decrements it.
-        if (emulator->display [i] < 0xFF && emulator->display [i] > 0)
-        {
-            emulator->display [i] -= 2;
-        }
-    }
-}
-#endif
-
 // Play a beep if the sound timer is greater than 0
 //
 // Parameters:
@@ -131,13 +153,15 @@ static void playSound (chip8 emulator)
             return;
         }
 
-        emulator->audioCb ();
+        emulator->audioCb (emulator->audioUserdata);
         emulator->soundPlaying = true;
+        emulator->events |= CRISP8_EVENT_SOUND;
     }
     else if (emulator->soundPlaying == true)
     {
-        emulator->audioCb ();
+        emulator->audioCb (emulator->audioUserdata);
         emulator->soundPlaying = false;
+        emulator->events |= CRISP8_EVENT_SOUND;
     }
 }
 
@@ -153,81 +177,584 @@ static void loadDefaultConfig (chip8 emulator)
     crisp8ConfigSetStoreLoadMemory (NEW, emulator);
 }
 
+struct chip8_s* crisp8AllocateEmulator (void)
+{
+#ifdef _WIN32
+    return _aligned_malloc (sizeof (struct chip8_s), alignof (struct chip8_s));
+#else
+    return aligned_alloc (alignof (struct chip8_s), sizeof (struct chip8_s));
+#endif
+}
+
+void crisp8FreeEmulator (struct chip8_s* emulator)
+{
+#ifdef _WIN32
+    _aligned_free (emulator);
+#else
+    free (emulator);
+#endif
+}
+
 void crisp8Init (chip8* emulator)
 {
-    *emulator = malloc (sizeof (**emulator));
-    if (!(*emulator))
+    if (crisp8InitWithMemorySize (emulator, CRISP8_MEMORY_SIZE) < 0)
     {
         fputs ("Out of memory in crisp8Init; aborting", stderr);
         abort ();
     }
+}
+
+int8_t crisp8InitWithMemorySize (chip8* emulator, uint32_t memorySize)
+{
+    // Sizes have to be powers of two that fit the 16 bit address space
+    if (memorySize < CRISP8_MEMORY_SIZE || memorySize > CRISP8_XO_MEMORY_SIZE || (memorySize & (memorySize - 1)))
+    {
+        return -1;
+    }
+
+    *emulator = crisp8AllocateEmulator ();
+    if (!(*emulator))
+    {
+        return -1;
+    }
 
     memset (*emulator, 0, sizeof (**emulator));
 
-    crisp8StackInit (&(*emulator)->stack);
+    (*emulator)->privateMemory = calloc (memorySize, 1);
+    if (!(*emulator)->privateMemory)
+    {
+        crisp8FreeEmulator (*emulator);
+        *emulator = NULL;
+        return -1;
+    }
+
+    (*emulator)->memory = (*emulator)->privateMemory;
+    (*emulator)->memorySize = memorySize;
+    (*emulator)->memoryMask = memorySize - 1;
+
+    crisp8StackReset (&(*emulator)->stack);
+
+    crisp8LoadFont ((*emulator)->memory);
 
-    loadFont (*emulator);
+    (*emulator)->selectedPlanes = 1;
+    (*emulator)->eventMask = CRISP8_EVENT_ALL;
+    crisp8SetRandomSeed (*emulator, (uint64_t)time (NULL) ^ (uintptr_t)*emulator);
+    crisp8DisplaySetHires (*emulator, false);
 
     loadDefaultConfig (*emulator);
+
+    return 0;
 }
 
 void crisp8Destroy (chip8* emulator)
 {
-    crisp8StackDestroy (&(*emulator)->stack);
-    free (*emulator);
+    crisp8TraceDisable (*emulator);
+    crisp8BreakpointClearAll (*emulator);
+    crisp8DrawCommandsDisable (*emulator);
+    crisp8FusionDisable (*emulator);
+    crisp8RomDetach (*emulator);
+    free ((*emulator)->privateMemory);
+    crisp8FreeEmulator (*emulator);
     *emulator = NULL;
 }
 
 void crisp8SetFramerate (chip8 emulator, uint16_t framerate)
 {
     emulator->framerate = framerate;
+    emulator->timerStep = 60.0f / framerate;
+}
+
+// Calls an audio callback that was set without user data
+//
+// Parameters:
+//  userdata: the emulator
+static void legacyAudioCallback (void* userdata)
+{
+    ((chip8)userdata)->legacyAudioCb ();
+}
+
+// Calls an input callback that was set without user data
+//
+// Parameters:
+//  userdata: the emulator
+static uint32_t legacyInputCallback (void* userdata)
+{
+    return ((chip8)userdata)->legacyInputCb ();
+}
+
+void crisp8SetAudioCallback (chip8 emulator, crisp8LegacyAudioCallback callback)
+{
+    emulator->legacyAudioCb = callback;
+    crisp8SetAudioCallbackWithData (emulator, legacyAudioCallback, emulator);
+}
+
+void crisp8SetInputCallback (chip8 emulator, crisp8LegacyInputCallback callback)
+{
+    emulator->legacyInputCb = callback;
+    crisp8SetInputCallbackWithData (emulator, legacyInputCallback, emulator);
 }
 
-void crisp8SetAudioCallback (chip8 emulator, crisp8AudioCallback callback)
+void crisp8SetAudioCallbackWithData (chip8 emulator, crisp8AudioCallback callback, void* userdata)
 {
     emulator->audioCb = callback;
+    emulator->audioUserdata = userdata;
 }
 
-void crisp8SetInputCallback (chip8 emulator, crisp8InputCallback callback)
+void crisp8SetInputCallbackWithData (chip8 emulator, crisp8InputCallback callback, void* userdata)
 {
     emulator->inputCb = callback;
+    emulator->inputUserdata = userdata;
+}
+
+void crisp8SetRandomSeed (chip8 emulator, uint64_t seed)
+{
+    // SplitMix64 spreads similar seeds (like consecutive integers) all over the state space
+    seed += 0x9E3779B97F4A7C15;
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EB;
+    seed ^= seed >> 31;
+
+    // xorshift gets stuck at zero
+    emulator->randomState = seed ? seed : 0x9E3779B97F4A7C15;
 }
 
-void crisp8InitializeProgram (chip8 emulator, uint8_t* program, uint16_t program_size)
+int8_t crisp8InitializeProgram (chip8 emulator, uint8_t* program, uint16_t program_size)
 {
+    if (program_size > emulator->memorySize - CRISP8_PROGRAM_START_ADDRESS)
+    {
+        return -1;
+    }
+
+    // A shared ROM image is about to be overwritten anyway, so there's no point in copying it first
+    if (emulator->memoryShared)
+    {
+        crisp8RomDetach (emulator);
+        crisp8LoadFont (emulator->memory);
+    }
+
     memcpy (emulator->memory + CRISP8_PROGRAM_START_ADDRESS, program, program_size);
     emulator->PC = CRISP8_PROGRAM_START_ADDRESS;
+    crisp8MemoryReplaced (emulator);
+
+    return 0;
 }
 
-void crisp8RunCycle (chip8 emulator)
+// The part of a cycle that comes before the instruction is fetched
+//
+// Parameters:
+//  emulator: the emulator to run
+static inline void beginCycle (chip8 emulator)
 {
+    emulator->events = 0;
+
     // Timer business
     decrementTimers (emulator);
     playSound (emulator);
 
     // Decrement the display alpha values if compiled with those
 #ifdef CRISP8_DISPLAY_USE_ALPHA
-    decrementDisplayAlpha (emulator);
+    if (!emulator->headless)
+    {
+        crisp8DisplayFade (emulator);
+    }
+#endif
+}
+
+// The part of a cycle that comes after the instruction was executed
+//
+// Parameters:
+//  emulator: the emulator to run
+static inline void endCycle (chip8 emulator)
+{
+    emulator->cycleCount++;
+
+    // Get the current keyState
+    emulator->lastKeyState = emulator->inputCb (emulator->inputUserdata);
+}
+
+// Executes a single cpu cycle/instruction. Shared by all run functions so they behave identically
+//
+// Parameters:
+//  emulator: the emulator to run
+static inline void runCycle (chip8 emulator)
+{
+    beginCycle (emulator);
+
+#ifdef CRISP8_TRACE
+    uint16_t tracedPC = emulator->PC;
+    uint8_t previousV [16];
+    memcpy (previousV, emulator->V, sizeof (previousV));
 #endif
 
     // Fetch
     uint16_t instruction = fetchInstruction (emulator);
     // Decode and execute
-    dispatchInstruction (instruction, emulator);
+    emulator->dispatch (instruction, emulator);
 
-    // Get the current keyState
-    emulator->lastKeyState = emulator->inputCb ();
+#ifdef CRISP8_TRACE
+    if (emulator->trace)
+    {
+        crisp8TraceWrite (emulator->trace, emulator->cycleCount, tracedPC, instruction, emulator->I, previousV,
+                          emulator->V);
+    }
+#endif
+
+    endCycle (emulator);
+}
+
+void crisp8RunCycle (chip8 emulator)
+{
+    runCycle (emulator);
+}
+
+// Returns true if runs of the emulator may use fused operations. Tracing needs every instruction to be fetched
+//
+// Parameters:
+//  emulator: the emulator to run
+static inline bool canFuse (chip8 emulator)
+{
+#ifdef CRISP8_TRACE
+    return emulator->fusion && !emulator->trace;
+#else
+    return emulator->fusion;
+#endif
+}
+
+// Runs one instruction of a fused operation as a cycle of its own: PC moves past the instruction as if it was fetched,
+// then effect is executed. The operation ends after a cycle that raised an event the run stops for
+#define FUSED_CYCLE(emulator, effect) \
+    do \
+    { \
+        beginCycle (emulator); \
+        (emulator)->PC += 2; \
+        effect; \
+        endCycle (emulator); \
+        executed++; \
+        if ((emulator)->events & stopEvents) \
+        { \
+            goto done; \
+        } \
+    } while (0)
+
+// Runs the fused operation starting at PC (see fusion.h), if it fits in the cycles left. The result is exactly that of
+// running its instructions one cycle at a time
+//
+// Parameters:
+//  emulator: an emulator with fusion enabled and no breakpoints
+//  operation: the fused operation at PC, not CRISP8_FUSED_NONE
+//  maxCycles: the maximum number of cycles to execute
+//  stopEvents: the events that end the operation after the cycle they happen in
+//
+// Return value:
+//  The number of cycles executed. 0 if the operation didn't fit and wasn't run
+static uint32_t runFused (chip8 emulator, uint8_t operation, uint32_t maxCycles, uint32_t stopEvents)
+{
+    uint16_t address = emulator->PC;
+    const uint8_t* code = emulator->memory + (address & emulator->memoryMask);
+    uint32_t executed = 0;
+
+    switch (operation)
+    {
+        case CRISP8_FUSED_IDLE:
+            while (executed < maxCycles)
+            {
+                FUSED_CYCLE (emulator, emulator->PC = address; emulator->counters.idleCycles++);
+            }
+            break;
+
+        case CRISP8_FUSED_POSITION_DRAW:
+            if (maxCycles < 4)
+            {
+                return 0;
+            }
+
+            FUSED_CYCLE (emulator, emulator->V [code [0] & 0x0F] = code [1]);
+            FUSED_CYCLE (emulator, emulator->V [code [2] & 0x0F] = code [3]);
+            FUSED_CYCLE (emulator, emulator->I = (uint16_t)(code [4] & 0x0F) << 8 | code [5]);
+            FUSED_CYCLE (emulator, emulator->dispatch ((uint16_t)code [6] << 8 | code [7], emulator));
+            break;
+
+        case CRISP8_FUSED_COUNTED_LOOP:
+        case CRISP8_FUSED_TIMER_POLL:
+        {
+            uint8_t* reg = &emulator->V [code [0] & 0x0F];
+            uint8_t step = code [1];
+            uint8_t limit = code [3];
+
+            // The loop ends when the skip jumps over the 1NNN
+            while (maxCycles - executed >= 3)
+            {
+                if (operation == CRISP8_FUSED_COUNTED_LOOP)
+                {
+                    FUSED_CYCLE (emulator, *reg += step);
+                }
+                else
+                {
+                    FUSED_CYCLE (emulator, *reg = emulator->delayTimer);
+                }
+
+                FUSED_CYCLE (emulator, emulator->PC += *reg == limit ? 2 : 0);
+
+                if (emulator->PC != address + 4)
+                {
+                    break;
+                }
+
+                FUSED_CYCLE (emulator, emulator->PC = address);
+            }
+            break;
+        }
+
+        default:
+            return 0;
+    }
+
+done:
+    emulator->counters.fusedInstructions += executed;
+    return executed;
+}
+
+#undef FUSED_CYCLE
+
+// Fills in a crisp8StopInfo if the caller asked for one
+//
+// Parameters:
+//  emulator: the emulator that stopped
+//  reason: the reason it stopped
+//  cyclesExecuted: the number of executed cycles
+//  info: the struct to fill in, may be NULL
+static enum crisp8StopReason reportStop (chip8 emulator, enum crisp8StopReason reason, uint32_t cyclesExecuted,
+                                         struct crisp8StopInfo* info)
+{
+    if (info)
+    {
+        info->reason = reason;
+        info->cyclesExecuted = cyclesExecuted;
+        info->PC = emulator->PC;
+        info->watchpoint = -1;
+        info->address = 0;
+        info->accessType = 0;
+
+        if (reason == CRISP8_STOP_WATCHPOINT)
+        {
+            info->watchpoint = emulator->breakpoints->hitWatchpoint;
+            info->address = emulator->breakpoints->hitAddress;
+            info->accessType = emulator->breakpoints->hitType;
+        }
+    }
+
+    return reason;
+}
+
+enum crisp8StopReason crisp8RunCycles (chip8 emulator, uint32_t maxCycles, struct crisp8StopInfo* info)
+{
+    uint32_t executed = 0;
+    emulator->faultStop = false;
+
+    // Without breakpoints, the only thing to check for is a fault (if the frontend asked to stop on them)
+    if (!emulator->breakpoints)
+    {
+        bool fusing = canFuse (emulator);
+
+        while (executed < maxCycles)
+        {
+            uint8_t operation = fusing ? crisp8FusionLookup (emulator, emulator->PC) : CRISP8_FUSED_NONE;
+            uint32_t fused = 0;
+
+            if (operation != CRISP8_FUSED_NONE)
+            {
+                fused = runFused (emulator, operation, maxCycles - executed, CRISP8_EVENT_NONE);
+            }
+
+            if (fused == 0)
+            {
+                runCycle (emulator);
+                fused = 1;
+            }
+
+            executed += fused;
+
+            if (emulator->faultStop)
+            {
+                return reportStop (emulator, CRISP8_STOP_FAULT, executed, info);
+            }
+        }
+
+        return reportStop (emulator, CRISP8_STOP_CYCLES, executed, info);
+    }
+
+    struct crisp8Breakpoints* breakpoints = emulator->breakpoints;
+    breakpoints->watchpointHit = false;
+
+    for (; executed < maxCycles; executed++)
+    {
+        // The first instruction is allowed to be at a breakpoint, otherwise we could never continue from one
+        if (executed > 0 && crisp8BreakpointHit (breakpoints, emulator->PC))
+        {
+            return reportStop (emulator, CRISP8_STOP_BREAKPOINT, executed, info);
+        }
+
+        runCycle (emulator);
+
+        if (breakpoints->watchpointHit)
+        {
+            return reportStop (emulator, CRISP8_STOP_WATCHPOINT, executed + 1, info);
+        }
+
+        if (emulator->faultStop)
+        {
+            return reportStop (emulator, CRISP8_STOP_FAULT, executed + 1, info);
+        }
+    }
+
+    return reportStop (emulator, CRISP8_STOP_CYCLES, executed, info);
+}
+
+// Runs until an event in emulator->eventMask happens. Inlined into crisp8RunUntilEvent once with and once without
+// breakpoint checks, so runs without breakpoints don't pay for them
+//
+// Parameters:
+//  emulator: the emulator to run
+//  maxCycles: the maximum number of cycles to execute
+//  checkBreakpoints: true if emulator->breakpoints is set
+//  executed: set to the number of executed cycles
+//
+// Return value:
+//  The events that happened during the last cycle, with CRISP8_EVENT_BREAKPOINT added if the run stopped at one
+static CRISP8_ALWAYS_INLINE uint32_t runUntilEvent (chip8 emulator, uint32_t maxCycles, bool checkBreakpoints,
+                                                    uint32_t* executed)
+{
+    uint32_t mask = emulator->eventMask;
+    bool fusing = !checkBreakpoints && canFuse (emulator);
+
+    for (*executed = 0; *executed < maxCycles;)
+    {
+        uint8_t operation = fusing ? crisp8FusionLookup (emulator, emulator->PC) : CRISP8_FUSED_NONE;
+        if (operation != CRISP8_FUSED_NONE)
+        {
+            uint32_t fused = runFused (emulator, operation, maxCycles - *executed, mask);
+            if (fused)
+            {
+                *executed += fused;
+
+                if (emulator->events & mask)
+                {
+                    return emulator->events;
+                }
+
+                continue;
+            }
+        }
+
+        // The first instruction is allowed to be at a breakpoint, otherwise we could never continue from one
+        if (checkBreakpoints && *executed > 0 && crisp8BreakpointHit (emulator->breakpoints, emulator->PC))
+        {
+            if (mask & CRISP8_EVENT_BREAKPOINT)
+            {
+                return emulator->events | CRISP8_EVENT_BREAKPOINT;
+            }
+        }
+
+        runCycle (emulator);
+        (*executed)++;
+
+        if (checkBreakpoints && emulator->breakpoints->watchpointHit)
+        {
+            emulator->breakpoints->watchpointHit = false;
+            emulator->events |= CRISP8_EVENT_WATCHPOINT;
+        }
+
+        if (emulator->events & mask)
+        {
+            return emulator->events;
+        }
+    }
+
+    return CRISP8_EVENT_NONE;
+}
+
+enum crisp8EventType crisp8RunUntilEvent (chip8 emulator, uint32_t maxCycles, struct crisp8Event* event)
+{
+    uint32_t executed;
+    uint32_t events;
+
+    if (emulator->breakpoints)
+    {
+        emulator->breakpoints->watchpointHit = false;
+        events = runUntilEvent (emulator, maxCycles, true, &executed);
+    }
+    else
+    {
+        events = runUntilEvent (emulator, maxCycles, false, &executed);
+    }
+
+    // The lowest bit of the events we stop for is the most important one
+    uint32_t stopping = events & emulator->eventMask;
+    enum crisp8EventType type = (enum crisp8EventType)(stopping & -stopping);
+
+    if (event)
+    {
+        event->type = type;
+        event->events = events;
+        event->cyclesExecuted = executed;
+        event->PC = emulator->PC;
+        event->soundPlaying = emulator->soundPlaying;
+    }
+
+    return type;
+}
+
+void crisp8SetEventMask (chip8 emulator, uint32_t mask)
+{
+    emulator->eventMask = mask & CRISP8_EVENT_ALL;
 }
 
 const uint8_t* const crisp8GetFramebuffer (chip8 emulator)
 {
+    crisp8DisplaySyncFramebuffer (emulator);
     return emulator->display;
 }
 
+const uint64_t* crisp8GetPackedFramebuffer (chip8 emulator)
+{
+    return &emulator->displayRows [0][0][0];
+}
+
+void crisp8SetHeadless (chip8 emulator, bool headless)
+{
+    emulator->headless = headless;
+}
+
+uint8_t crisp8GetDisplayWidth (chip8 emulator)
+{
+    return emulator->displayWidth;
+}
+
+uint8_t crisp8GetDisplayHeight (chip8 emulator)
+{
+    return emulator->displayHeight;
+}
+
+uint32_t crisp8GetMemorySize (chip8 emulator)
+{
+    return emulator->memorySize;
+}
+
+bool crisp8HasExited (chip8 emulator)
+{
+    return emulator->exited;
+}
+
 void crisp8InitDebugStruct (struct crisp8Debug* debugStruct, chip8 emulator)
 {
+    // The debug struct allows writing to memory behind the emulator's back, so it can't be handed a shared image
+    if (emulator->memoryShared)
+    {
+        crisp8RomPrivatizeMemory (emulator);
+    }
+
     debugStruct->memory = emulator->memory;
-    debugStruct->stack = emulator->stack;
+    debugStruct->stack = &emulator->stack;
 
     debugStruct->PC = &emulator->PC;
     debugStruct->I = &emulator->I;
@@ -0,0 +1,257 @@
+#include "disassemble.h"
+
+#include <string.h>
+
+static const char hexDigits [] = "0123456789ABCDEF";
+
+// Appends a string
+//
+// Parameters:
+//  out: where to write
+//  string: the string
+//
+// Return value:
+//  The position after the string
+static char* appendString (char* out, const char* string)
+{
+    while (*string)
+    {
+        *out++ = *string++;
+    }
+
+    return out;
+}
+
+// Appends a value as hexadecimal digits, without a prefix
+//
+// Parameters:
+//  out: where to write
+//  value: the value
+//  digits: the number of digits to write
+//
+// Return value:
+//  The position after the digits
+static char* appendHex (char* out, uint32_t value, int digits)
+{
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        *out++ = hexDigits [(value >> (i * 4)) & 0xF];
+    }
+
+    return out;
+}
+
+// Appends a register name, VX
+static char* appendRegister (char* out, uint8_t reg)
+{
+    *out++ = 'V';
+    *out++ = hexDigits [reg & 0xF];
+    return out;
+}
+
+// Appends an immediate value with a 0x prefix
+static char* appendImmediate (char* out, uint32_t value, int digits)
+{
+    return appendHex (appendString (out, "0x"), value, digits);
+}
+
+// Appends "MNEMONIC VX, VY"
+static char* appendRegisters (char* out, const char* mnemonic, uint8_t x, uint8_t y)
+{
+    out = appendString (out, mnemonic);
+    out = appendRegister (out, x);
+    out = appendString (out, ", ");
+    return appendRegister (out, y);
+}
+
+// Disassembles an instruction that isn't LD I, long
+//
+// Parameters:
+//  instruction: the instruction
+//  out: where to write
+//
+// Return value:
+//  The position after the text
+static char* disassembleInstruction (uint16_t instruction, char* out)
+{
+    uint8_t x = (instruction >> 8) & 0xF;
+    uint8_t y = (instruction >> 4) & 0xF;
+    uint8_t n = instruction & 0xF;
+    uint8_t nn = instruction & 0xFF;
+    uint16_t nnn = instruction & 0xFFF;
+
+    switch (instruction >> 12)
+    {
+        case 0x0:
+            switch (instruction)
+            {
+                case 0x00E0:
+                    return appendString (out, "CLS");
+                case 0x00EE:
+                    return appendString (out, "RET");
+                case 0x00FB:
+                    return appendString (out, "SCR");
+                case 0x00FC:
+                    return appendString (out, "SCL");
+                case 0x00FD:
+                    return appendString (out, "EXIT");
+                case 0x00FE:
+                    return appendString (out, "LOW");
+                case 0x00FF:
+                    return appendString (out, "HIGH");
+            }
+
+            if ((instruction & 0xFFF0) == 0x00C0 || (instruction & 0xFFF0) == 0x00D0)
+            {
+                out = appendString (out, (instruction & 0xFFF0) == 0x00C0 ? "SCD " : "SCU ");
+                return appendImmediate (out, n, 1);
+            }
+            break;
+        case 0x1:
+            return appendImmediate (appendString (out, "JP "), nnn, 3);
+        case 0x2:
+            return appendImmediate (appendString (out, "CALL "), nnn, 3);
+        case 0x3:
+        case 0x4:
+        case 0x6:
+        case 0x7:
+        case 0xC:
+        {
+            static const char* mnemonics [] = {[0x3] = "SE ", [0x4] = "SNE ", [0x6] = "LD ", [0x7] = "ADD ",
+                                               [0xC] = "RND "};
+            out = appendRegister (appendString (out, mnemonics [instruction >> 12]), x);
+            return appendImmediate (appendString (out, ", "), nn, 2);
+        }
+        case 0x5:
+            if (n == 0)
+            {
+                return appendRegisters (out, "SE ", x, y);
+            }
+            else if (n == 2 || n == 3)
+            {
+                out = appendRegister (appendString (out, n == 2 ? "SAVE " : "LOAD "), x);
+                return appendRegister (appendString (out, " - "), y);
+            }
+            break;
+        case 0x8:
+        {
+            static const char* mnemonics [16] = {"LD ", "OR ", "AND ", "XOR ", "ADD ", "SUB ", "SHR ", "SUBN ",
+                                                 [0xE] = "SHL "};
+            if (mnemonics [n])
+            {
+                return appendRegisters (out, mnemonics [n], x, y);
+            }
+            break;
+        }
+        case 0x9:
+            return appendRegisters (out, "SNE ", x, y);
+        case 0xA:
+            return appendImmediate (appendString (out, "LD I, "), nnn, 3);
+        case 0xB:
+            return appendImmediate (appendString (out, "JP V0, "), nnn, 3);
+        case 0xD:
+            out = appendRegisters (out, "DRW ", x, y);
+            return appendImmediate (appendString (out, ", "), n, 1);
+        case 0xE:
+            if (nn == 0x9E || nn == 0xA1)
+            {
+                return appendRegister (appendString (out, nn == 0x9E ? "SKP " : "SKNP "), x);
+            }
+            break;
+        case 0xF:
+            switch (nn)
+            {
+                case 0x01:
+                    return appendImmediate (appendString (out, "PLANE "), x, 1);
+                case 0x07:
+                    return appendString (appendRegister (appendString (out, "LD "), x), ", DT");
+                case 0x0A:
+                    return appendString (appendRegister (appendString (out, "LD "), x), ", K");
+                case 0x15:
+                    return appendRegister (appendString (out, "LD DT, "), x);
+                case 0x18:
+                    return appendRegister (appendString (out, "LD ST, "), x);
+                case 0x1E:
+                    return appendRegister (appendString (out, "ADD I, "), x);
+                case 0x29:
+                    return appendRegister (appendString (out, "LD F, "), x);
+                case 0x30:
+                    return appendRegister (appendString (out, "LD HF, "), x);
+                case 0x33:
+                    return appendRegister (appendString (out, "LD B, "), x);
+                case 0x55:
+                    return appendRegister (appendString (out, "LD [I], "), x);
+                case 0x65:
+                    return appendString (appendRegister (appendString (out, "LD "), x), ", [I]");
+                case 0x75:
+                    return appendRegister (appendString (out, "LD R, "), x);
+                case 0x85:
+                    return appendString (appendRegister (appendString (out, "LD "), x), ", R");
+            }
+            break;
+    }
+
+    // Anything the emulator would fault on
+    return appendImmediate (appendString (out, "DW "), instruction, 4);
+}
+
+// Disassembles an instruction into out, without a terminating null character
+//
+// Return value:
+//  The length of the instruction in bytes, 0 if size is less than 2
+static uint8_t disassemble (const uint8_t* code, uint32_t size, char** out)
+{
+    if (size < 2)
+    {
+        return 0;
+    }
+
+    uint16_t instruction = (uint16_t)code [0] << 8 | code [1];
+
+    if (instruction == 0xF000 && size >= 4)
+    {
+        *out = appendImmediate (appendString (*out, "LD I, long "), (uint16_t)code [2] << 8 | code [3], 4);
+        return 4;
+    }
+
+    *out = disassembleInstruction (instruction, *out);
+    return 2;
+}
+
+uint8_t crisp8Disassemble (const uint8_t* code, uint32_t size, char* text)
+{
+    char* out = text;
+    uint8_t length = disassemble (code, size, &out);
+    *out = '\0';
+
+    return length;
+}
+
+size_t crisp8DisassembleRange (const uint8_t* code, uint32_t size, uint16_t address, char* out, size_t outSize,
+                               uint32_t* consumed)
+{
+    char* line = out;
+    uint32_t offset = 0;
+
+    while (offset + 2 <= size && (size_t)(line - out) + CRISP8_DISASSEMBLY_MAX_LINE <= outSize)
+    {
+        // The text goes after the address and opcode, which are filled in once the length is known
+        char* text = line + 16;
+        uint8_t length = disassemble (code + offset, size - offset, &text);
+
+        memset (line, ' ', 16);
+        appendHex (line, (uint16_t)(address + offset), 4);
+        appendHex (line + 6, (uint32_t)code [offset] << 8 | code [offset + 1], 4);
+        if (length == 4)
+        {
+            appendHex (line + 10, (uint32_t)code [offset + 2] << 8 | code [offset + 3], 4);
+        }
+
+        *text++ = '\n';
+        line = text;
+        offset += length;
+    }
+
+    *consumed = offset;
+    return line - out;
+}
@@ -0,0 +1,296 @@
+#include "display.h"
+
+#include "crisp8_private.h"
+#include "drawcommands_private.h"
+#include "hash_private.h"
+
+#include <string.h>
+
+// Loops over the planes selected by FN01. Use "plane" as the index of the plane in the loop body
+#define FOR_EACH_SELECTED_PLANE(emulator, plane) \
+    for (int plane = 0; plane < CRISP8_DISPLAY_PLANES; plane++) \
+        if ((emulator)->selectedPlanes & (1 << plane))
+
+void crisp8DisplayClear (chip8 emulator)
+{
+    if (emulator->drawCommands)
+    {
+        crisp8DrawCommandRecord (emulator, CRISP8_DRAW_CLEAR, 0, 0, 0, 0, false, NULL, 0);
+    }
+
+    FOR_EACH_SELECTED_PLANE (emulator, plane)
+    {
+        memset (emulator->displayRows [plane], 0, sizeof (emulator->displayRows [plane]));
+    }
+
+    emulator->framebufferDirty = true;
+    emulator->events |= CRISP8_EVENT_FRAME;
+    crisp8HashDisplayChanged (emulator);
+
+#ifdef CRISP8_DISPLAY_USE_ALPHA
+    // Clearing the screen turns pixels off instantly instead of fading them. This only works out if every plane is
+    // being cleared, otherwise the remaining pixels are left to the sync
+    if (emulator->selectedPlanes == (1 << CRISP8_DISPLAY_PLANES) - 1)
+    {
+        memset (emulator->display, 0, sizeof (emulator->display));
+        emulator->framebufferDirty = false;
+    }
+#endif
+}
+
+void crisp8DisplaySetHires (chip8 emulator, bool hires)
+{
+    if (emulator->drawCommands)
+    {
+        crisp8DrawCommandRecord (emulator, CRISP8_DRAW_RESOLUTION, hires, 0, 0, 0, false, NULL, 0);
+    }
+
+    emulator->displayWidth = hires ? CRISP8_DISPLAY_HIRES_WIDTH : CRISP8_DISPLAY_WIDTH;
+    emulator->displayHeight = hires ? CRISP8_DISPLAY_HIRES_HEIGHT : CRISP8_DISPLAY_HEIGHT;
+
+    // The framebuffer's stride changes with the resolution, so the old contents would be garbage anyway. A resolution
+    // change clears all planes, regardless of which are selected
+    memset (emulator->displayRows, 0, sizeof (emulator->displayRows));
+    memset (emulator->display, 0, sizeof (emulator->display));
+    emulator->framebufferDirty = false;
+    emulator->displayHash = 0;
+    emulator->events |= CRISP8_EVENT_FRAME;
+}
+
+// Xors one plane's worth of sprite data onto a plane
+//
+// Parameters:
+//  emulator: the emulator to draw on
+//  plane: the index of the plane
+//  x: the column of the sprite's left edge, already wrapped
+//  y: the row of the sprite's top edge, already wrapped
+//  sprite: the sprite data
+//  width: 8 or 16
+//  height: the number of rows in the sprite
+//
+// Return value:
+//  Non zero if any pixel was turned off
+static uint64_t drawPlane (chip8 emulator, int plane, uint8_t x, uint8_t y, const uint8_t* sprite, uint8_t width,
+                           uint8_t height)
+{
+    uint64_t collision = 0;
+    uint64_t flipped = 0;
+
+    for (int j = 0; j < height && y + j < emulator->displayHeight; j++)
+    {
+        // Left justify the sprite row in a word, then shift it into place. Pixels that end up past the last word fall
+        // off, which is the clipping at the right edge. In low resolution the second word is past the edge.
+        uint64_t spriteRow = width == 16 ? ((uint64_t)sprite [j * 2] << 8) | sprite [j * 2 + 1] : sprite [j];
+        spriteRow <<= 64 - width;
+
+        uint64_t left;
+        uint64_t right;
+        if (x < 64)
+        {
+            left = spriteRow >> x;
+            right = x && emulator->displayWidth > 64 ? spriteRow << (64 - x) : 0;
+        }
+        else
+        {
+            left = 0;
+            right = spriteRow >> (x - 64);
+        }
+
+        uint64_t* row = emulator->displayRows [plane][y + j];
+        collision |= (row [0] & left) | (row [1] & right);
+        flipped += crisp8PopCount (left) + crisp8PopCount (right);
+        crisp8HashWriteDisplay (emulator, &row [0], row [0] ^ left);
+        crisp8HashWriteDisplay (emulator, &row [1], row [1] ^ right);
+    }
+
+    emulator->counters.pixelsFlipped += flipped;
+
+    return collision;
+}
+
+bool crisp8DisplayDrawSprite (chip8 emulator, uint8_t x, uint8_t y, const uint8_t* sprite, uint8_t width,
+                              uint8_t height)
+{
+    uint64_t collision = 0;
+    const uint8_t* spriteStart = sprite;
+    uint8_t recordedX = x;
+    uint8_t recordedY = y;
+
+    x %= emulator->displayWidth;
+    y %= emulator->displayHeight;
+
+    // With several planes selected, each plane's sprite data follows the previous plane's
+    FOR_EACH_SELECTED_PLANE (emulator, plane)
+    {
+        collision |= drawPlane (emulator, plane, x, y, sprite, width, height);
+        sprite += height * (width / 8);
+    }
+
+    emulator->counters.draws++;
+    emulator->counters.collisions += collision != 0;
+
+    if (emulator->drawCommands)
+    {
+        crisp8DrawCommandRecord (emulator, CRISP8_DRAW_SPRITE, recordedX, recordedY, width, height, collision != 0,
+                                 spriteStart, sprite - spriteStart);
+    }
+
+    emulator->framebufferDirty = true;
+    emulator->events |= CRISP8_EVENT_FRAME;
+    return collision != 0;
+}
+
+void crisp8DisplayScrollDown (chip8 emulator, uint8_t rows)
+{
+    if (emulator->drawCommands)
+    {
+        crisp8DrawCommandRecord (emulator, CRISP8_DRAW_SCROLL_DOWN, rows, 0, 0, 0, false, NULL, 0);
+    }
+
+    uint8_t height = emulator->displayHeight;
+    if (rows > height)
+    {
+        rows = height;
+    }
+
+    FOR_EACH_SELECTED_PLANE (emulator, plane)
+    {
+        memmove (emulator->displayRows [plane][rows], emulator->displayRows [plane][0],
+                 sizeof (emulator->displayRows [plane][0]) * (height - rows));
+        memset (emulator->displayRows [plane][0], 0, sizeof (emulator->displayRows [plane][0]) * rows);
+    }
+
+    emulator->framebufferDirty = true;
+    emulator->events |= CRISP8_EVENT_FRAME;
+    crisp8HashDisplayChanged (emulator);
+}
+
+void crisp8DisplayScrollUp (chip8 emulator, uint8_t rows)
+{
+    if (emulator->drawCommands)
+    {
+        crisp8DrawCommandRecord (emulator, CRISP8_DRAW_SCROLL_UP, rows, 0, 0, 0, false, NULL, 0);
+    }
+
+    uint8_t height = emulator->displayHeight;
+    if (rows > height)
+    {
+        rows = height;
+    }
+
+    FOR_EACH_SELECTED_PLANE (emulator, plane)
+    {
+        memmove (emulator->displayRows [plane][0], emulator->displayRows [plane][rows],
+                 sizeof (emulator->displayRows [plane][0]) * (height - rows));
+        memset (emulator->displayRows [plane][height - rows], 0, sizeof (emulator->displayRows [plane][0]) * rows);
+    }
+
+    emulator->framebufferDirty = true;
+    emulator->events |= CRISP8_EVENT_FRAME;
+    crisp8HashDisplayChanged (emulator);
+}
+
+void crisp8DisplayScrollRight (chip8 emulator)
+{
+    if (emulator->drawCommands)
+    {
+        crisp8DrawCommandRecord (emulator, CRISP8_DRAW_SCROLL_RIGHT, 0, 0, 0, 0, false, NULL, 0);
+    }
+
+    FOR_EACH_SELECTED_PLANE (emulator, plane)
+    {
+        for (int j = 0; j < emulator->displayHeight; j++)
+        {
+            uint64_t* row = emulator->displayRows [plane][j];
+            row [1] = (row [1] >> 4) | (row [0] << 60);
+            row [0] >>= 4;
+
+            // Pixels pushed past the right edge in low resolution must not come back when scrolling left again
+            if (emulator->displayWidth == CRISP8_DISPLAY_WIDTH)
+            {
+                row [1] = 0;
+            }
+        }
+    }
+
+    emulator->framebufferDirty = true;
+    emulator->events |= CRISP8_EVENT_FRAME;
+    crisp8HashDisplayChanged (emulator);
+}
+
+void crisp8DisplayScrollLeft (chip8 emulator)
+{
+    if (emulator->drawCommands)
+    {
+        crisp8DrawCommandRecord (emulator, CRISP8_DRAW_SCROLL_LEFT, 0, 0, 0, 0, false, NULL, 0);
+    }
+
+    FOR_EACH_SELECTED_PLANE (emulator, plane)
+    {
+        for (int j = 0; j < emulator->displayHeight; j++)
+        {
+            uint64_t* row = emulator->displayRows [plane][j];
+            row [0] = (row [0] << 4) | (row [1] >> 60);
+            row [1] <<= 4;
+        }
+    }
+
+    emulator->framebufferDirty = true;
+    emulator->events |= CRISP8_EVENT_FRAME;
+    crisp8HashDisplayChanged (emulator);
+}
+
+void crisp8DisplaySyncFramebuffer (chip8 emulator)
+{
+    if (!emulator->framebufferDirty)
+    {
+        return;
+    }
+
+    uint8_t* pixel = emulator->display;
+
+    for (int j = 0; j < emulator->displayHeight; j++)
+    {
+        for (int word = 0; word < emulator->displayWidth / 64; word++)
+        {
+            uint64_t plane0 = emulator->displayRows [0][j][word];
+            uint64_t plane1 = emulator->displayRows [1][j][word];
+
+            for (int i = 63; i >= 0; i--, pixel++)
+            {
+                uint8_t color = ((plane0 >> i) & 1) | (((plane1 >> i) & 1) << 1);
+#ifdef CRISP8_DISPLAY_USE_ALPHA
+                // Pixels that were just turned off start fading from just below full brightness
+                if (color)
+                {
+                    *pixel = 0xFF;
+                }
+                else if (*pixel == 0xFF)
+                {
+                    *pixel = 0xFE;
+                }
+#else
+                *pixel = color;
+#endif
+            }
+        }
+    }
+
+    emulator->framebufferDirty = false;
+}
+
+#ifdef CRISP8_DISPLAY_USE_ALPHA
+void crisp8DisplayFade (chip8 emulator)
+{
+    crisp8DisplaySyncFramebuffer (emulator);
+
+    for (int i = 0; i < emulator->displayWidth * emulator->displayHeight; i++)
+    {
+        // A pixel is deemed off if is not at full brightness. This just slowly decrements it.
+        if (emulator->display [i] < 0xFF && emulator->display [i] > 0)
+        {
+            emulator->display [i] -= 2;
+        }
+    }
+}
+#endif
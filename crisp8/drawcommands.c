@@ -0,0 +1,208 @@
+#include "drawcommands.h"
+
+#include "drawcommands_private.h"
+#include "crisp8_private.h"
+#include "display.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The size of the largest command, which the buffer has to be able to hold
+#define MAX_COMMAND_SIZE (sizeof (struct crisp8DrawCommand) + CRISP8_DRAW_COMMAND_MAX_SPRITE_SIZE)
+
+int8_t crisp8DrawCommandsEnable (chip8 emulator, uint32_t capacity, bool headless)
+{
+    if (capacity < MAX_COMMAND_SIZE)
+    {
+        return -1;
+    }
+
+    crisp8DrawCommandsDisable (emulator);
+
+    struct crisp8DrawCommandBuffer* buffer = calloc (1, sizeof (*buffer));
+    if (!buffer)
+    {
+        return -1;
+    }
+
+    buffer->data = malloc (capacity);
+    if (!buffer->data)
+    {
+        free (buffer);
+        return -1;
+    }
+
+    buffer->capacity = capacity;
+
+    emulator->drawCommands = buffer;
+    emulator->headless = headless;
+
+    return 0;
+}
+
+void crisp8DrawCommandsDisable (chip8 emulator)
+{
+    if (emulator->drawCommands)
+    {
+        free (emulator->drawCommands->data);
+        free (emulator->drawCommands);
+        emulator->drawCommands = NULL;
+    }
+
+    emulator->headless = false;
+}
+
+const uint8_t* crisp8DrawCommandsGet (chip8 emulator, uint32_t* size, bool* lost)
+{
+    struct crisp8DrawCommandBuffer* buffer = emulator->drawCommands;
+    if (!buffer)
+    {
+        *size = 0;
+        *lost = false;
+        return NULL;
+    }
+
+    *size = buffer->size;
+    *lost = buffer->lost;
+    return buffer->data;
+}
+
+void crisp8DrawCommandsClear (chip8 emulator)
+{
+    if (emulator->drawCommands)
+    {
+        emulator->drawCommands->size = 0;
+        emulator->drawCommands->lost = false;
+    }
+}
+
+void crisp8DrawCommandRecord (chip8 emulator, enum crisp8DrawCommandType type, uint8_t x, uint8_t y, uint8_t width,
+                              uint8_t height, bool collision, const uint8_t* sprite, uint8_t spriteSize)
+{
+    struct crisp8DrawCommandBuffer* buffer = emulator->drawCommands;
+
+    // With no plane selected the display doesn't change, except for resolution changes which clear every plane
+    uint8_t planes = type == CRISP8_DRAW_RESOLUTION ? (1 << CRISP8_DISPLAY_PLANES) - 1 : emulator->selectedPlanes;
+    if (planes == 0)
+    {
+        return;
+    }
+
+    // Once a command is lost the ones after it are useless to the viewer until it resyncs, so nothing more is recorded
+    if (buffer->lost || buffer->capacity - buffer->size < sizeof (struct crisp8DrawCommand) + spriteSize)
+    {
+        buffer->lost = true;
+        return;
+    }
+
+    struct crisp8DrawCommand command = {
+        .type = type,
+        .planes = planes,
+        .x = x,
+        .y = y,
+        .width = width,
+        .height = height,
+        .collision = collision,
+        .spriteSize = spriteSize
+    };
+
+    memcpy (buffer->data + buffer->size, &command, sizeof (command));
+    buffer->size += sizeof (command);
+
+    if (spriteSize)
+    {
+        memcpy (buffer->data + buffer->size, sprite, spriteSize);
+        buffer->size += spriteSize;
+    }
+}
+
+// Checks that a sprite command's size fields agree with its sprite data, so replaying it never reads past the command
+//
+// Parameters:
+//  command: the sprite command
+//
+// Return value:
+//  True if the command is well formed
+static bool validSprite (const struct crisp8DrawCommand* command)
+{
+    if ((command->width != 8 && command->width != 16) || command->height == 0 || command->height > 16)
+    {
+        return false;
+    }
+
+    int numPlanes = 0;
+    for (int plane = 0; plane < CRISP8_DISPLAY_PLANES; plane++)
+    {
+        numPlanes += (command->planes >> plane) & 1;
+    }
+
+    return command->spriteSize == command->height * (command->width / 8) * numPlanes;
+}
+
+int32_t crisp8DrawCommandsReplay (chip8 viewer, const uint8_t* commands, uint32_t size)
+{
+    int32_t applied = 0;
+    uint32_t offset = 0;
+
+    while (offset < size)
+    {
+        struct crisp8DrawCommand command;
+        if (size - offset < sizeof (command))
+        {
+            return -1;
+        }
+
+        memcpy (&command, commands + offset, sizeof (command));
+        offset += sizeof (command);
+
+        if (command.planes == 0 || command.planes >= (1 << CRISP8_DISPLAY_PLANES) || size - offset < command.spriteSize)
+        {
+            return -1;
+        }
+
+        if (command.type != CRISP8_DRAW_SPRITE && command.spriteSize != 0)
+        {
+            return -1;
+        }
+
+        viewer->selectedPlanes = command.planes;
+
+        switch (command.type)
+        {
+            case CRISP8_DRAW_CLEAR:
+                crisp8DisplayClear (viewer);
+                break;
+            case CRISP8_DRAW_SPRITE:
+                if (!validSprite (&command))
+                {
+                    return -1;
+                }
+
+                crisp8DisplayDrawSprite (viewer, command.x, command.y, commands + offset, command.width,
+                                         command.height);
+                break;
+            case CRISP8_DRAW_SCROLL_DOWN:
+                crisp8DisplayScrollDown (viewer, command.x);
+                break;
+            case CRISP8_DRAW_SCROLL_UP:
+                crisp8DisplayScrollUp (viewer, command.x);
+                break;
+            case CRISP8_DRAW_SCROLL_RIGHT:
+                crisp8DisplayScrollRight (viewer);
+                break;
+            case CRISP8_DRAW_SCROLL_LEFT:
+                crisp8DisplayScrollLeft (viewer);
+                break;
+            case CRISP8_DRAW_RESOLUTION:
+                crisp8DisplaySetHires (viewer, command.x != 0);
+                break;
+            default:
+                return -1;
+        }
+
+        offset += command.spriteSize;
+        applied++;
+    }
+
+    return applied;
+}
@@ -0,0 +1,239 @@
+#include "env.h"
+
+#include "crisp8_private.h"
+#include "state.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The framerate is a uint16_t, and a frame is always 1/60th of a second
+#define MAX_INSTRUCTIONS_PER_FRAME (UINT16_MAX / 60)
+
+struct crisp8Env_s
+{
+    chip8* emulators;
+    uint32_t count;
+
+    // The keys held in each environment, read by its input callback
+    uint32_t* keys;
+    // The number of times each environment was reset, and whether its program has exited
+    uint64_t* episodes;
+    uint8_t* done;
+
+    uint16_t instructionsPerFrame;
+    enum crisp8EnvObservation observation;
+    uint64_t seed;
+
+    // The state taken from the prototype
+    void* bootState;
+    size_t bootStateSize;
+};
+
+// Input callback of the environments
+//
+// Parameters:
+//  userdata: the environment's entry in crisp8Env_s.keys
+static uint32_t envInput (void* userdata)
+{
+    return *(const uint32_t*)userdata;
+}
+
+// Audio callback of the environments. There is nobody to hear it
+//
+// Parameters:
+//  userdata: unused
+static void envAudio (void* userdata)
+{
+}
+
+// Writes the observation of an environment
+//
+// Parameters:
+//  env: the batch
+//  index: the index of the environment
+//  observations: the observations array of the batch
+static void observe (crisp8Env env, uint32_t index, void* observations)
+{
+    if (env->observation == CRISP8_ENV_OBSERVE_NONE || !observations)
+    {
+        return;
+    }
+
+    chip8 emulator = env->emulators [index];
+    uint8_t* out = (uint8_t*)observations + (size_t)index * crisp8EnvObservationSize (env);
+
+    if (env->observation == CRISP8_ENV_OBSERVE_PACKED)
+    {
+        memcpy (out, emulator->displayRows, CRISP8_ENV_PACKED_SIZE);
+        return;
+    }
+
+    // In low resolution each pixel is doubled in both directions, so the observation never changes shape
+    int scale = CRISP8_DISPLAY_HIRES_WIDTH / emulator->displayWidth;
+
+    for (int y = 0; y < CRISP8_DISPLAY_HIRES_HEIGHT; y++)
+    {
+        for (int x = 0; x < CRISP8_DISPLAY_HIRES_WIDTH; x++)
+        {
+            int sourceX = x / scale;
+            int sourceY = y / scale;
+            uint8_t planes = 0;
+
+            for (int plane = 0; plane < CRISP8_DISPLAY_PLANES; plane++)
+            {
+                uint64_t word = emulator->displayRows [plane][sourceY][sourceX / 64];
+                planes |= ((word >> (63 - sourceX % 64)) & 1) << plane;
+            }
+
+            out [y * CRISP8_DISPLAY_HIRES_WIDTH + x] = planes;
+        }
+    }
+}
+
+// Puts an environment into the boot state and reseeds it for its next episode
+//
+// Parameters:
+//  env: the batch
+//  index: the index of the environment
+static void resetEnvironment (crisp8Env env, uint32_t index)
+{
+    chip8 emulator = env->emulators [index];
+
+    crisp8StateLoad (emulator, env->bootState, env->bootStateSize);
+    crisp8SetRandomSeed (emulator, env->seed ^ ((uint64_t)index << 32) ^ env->episodes [index]);
+
+    env->episodes [index]++;
+    env->keys [index] = 0;
+    env->done [index] = emulator->exited;
+}
+
+int8_t crisp8EnvCreate (crisp8Env* env, chip8 prototype, uint32_t count, uint16_t instructionsPerFrame,
+                        enum crisp8EnvObservation observation)
+{
+    if (count == 0 || instructionsPerFrame == 0 || instructionsPerFrame > MAX_INSTRUCTIONS_PER_FRAME ||
+        observation > CRISP8_ENV_OBSERVE_PIXELS)
+    {
+        return -1;
+    }
+
+    *env = calloc (1, sizeof (**env));
+    if (!(*env))
+    {
+        return -1;
+    }
+
+    (*env)->count = count;
+    (*env)->instructionsPerFrame = instructionsPerFrame;
+    (*env)->observation = observation;
+
+    (*env)->emulators = calloc (count, sizeof (*(*env)->emulators));
+    (*env)->keys = calloc (count, sizeof (*(*env)->keys));
+    (*env)->episodes = calloc (count, sizeof (*(*env)->episodes));
+    (*env)->done = calloc (count, sizeof (*(*env)->done));
+
+    (*env)->bootStateSize = crisp8StateSize (prototype);
+    (*env)->bootState = malloc ((*env)->bootStateSize);
+
+    if (!(*env)->emulators || !(*env)->keys || !(*env)->episodes || !(*env)->done || !(*env)->bootState ||
+        crisp8StateSave (prototype, (*env)->bootState, (*env)->bootStateSize) < 0)
+    {
+        crisp8EnvDestroy (env);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (crisp8InitWithMemorySize (&(*env)->emulators [i], crisp8GetMemorySize (prototype)) < 0)
+        {
+            crisp8EnvDestroy (env);
+            return -1;
+        }
+
+        chip8 emulator = (*env)->emulators [i];
+        crisp8SetInputCallbackWithData (emulator, envInput, &(*env)->keys [i]);
+        crisp8SetAudioCallbackWithData (emulator, envAudio, NULL);
+        crisp8SetFramerate (emulator, instructionsPerFrame * 60);
+        emulator->headless = true;
+
+        resetEnvironment (*env, i);
+    }
+
+    return 0;
+}
+
+void crisp8EnvDestroy (crisp8Env* env)
+{
+    if ((*env)->emulators)
+    {
+        for (uint32_t i = 0; i < (*env)->count && (*env)->emulators [i]; i++)
+        {
+            crisp8Destroy (&(*env)->emulators [i]);
+        }
+    }
+
+    free ((*env)->emulators);
+    free ((*env)->keys);
+    free ((*env)->episodes);
+    free ((*env)->done);
+    free ((*env)->bootState);
+    free (*env);
+    *env = NULL;
+}
+
+void crisp8EnvSetSeed (crisp8Env env, uint64_t seed)
+{
+    env->seed = seed;
+}
+
+uint32_t crisp8EnvObservationSize (crisp8Env env)
+{
+    switch (env->observation)
+    {
+        case CRISP8_ENV_OBSERVE_PACKED:
+            return CRISP8_ENV_PACKED_SIZE;
+        case CRISP8_ENV_OBSERVE_PIXELS:
+            return CRISP8_ENV_PIXELS_SIZE;
+        default:
+            return 0;
+    }
+}
+
+void crisp8EnvStep (crisp8Env env, const uint32_t* actions, uint32_t framesPerStep, void* observations,
+                    uint8_t* done)
+{
+    for (uint32_t i = 0; i < env->count; i++)
+    {
+        chip8 emulator = env->emulators [i];
+        env->keys [i] = actions [i];
+
+        for (uint32_t frame = 0; frame < framesPerStep && !env->done [i]; frame++)
+        {
+            crisp8RunCycles (emulator, env->instructionsPerFrame, NULL);
+            env->done [i] = emulator->exited;
+        }
+
+        observe (env, i, observations);
+
+        if (done)
+        {
+            done [i] = env->done [i];
+        }
+    }
+}
+
+void crisp8EnvReset (crisp8Env env, const uint8_t* which, void* observations)
+{
+    for (uint32_t i = 0; i < env->count; i++)
+    {
+        if (!which || which [i])
+        {
+            resetEnvironment (env, i);
+            observe (env, i, observations);
+        }
+    }
+}
+
+chip8 crisp8EnvGetEmulator (crisp8Env env, uint32_t index)
+{
+    return env->emulators [index];
+}
@@ -0,0 +1,280 @@
+#include "export.h"
+
+#include "crisp8_private.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#if defined(_POSIX_SHARED_MEMORY_OBJECTS) && _POSIX_SHARED_MEMORY_OBJECTS > 0
+#define HAVE_SHARED_MEMORY
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// How often a reader tries to get a consistent copy before giving up. A publish is a few KiB of copying, so a reader
+// that keeps losing the race is looking at a dead exporter
+#define READ_ATTEMPTS 1000
+
+// The contents of the shared memory object
+struct segment
+{
+    char magic [8];
+    uint32_t version;
+    uint32_t snapshotSize;
+    // 0x0102 in the byte order of the exporter
+    uint16_t byteOrderMark;
+    uint16_t reserved [3];
+
+    // Odd while the snapshot is being written. Twice the number of completed publishes otherwise
+    alignas (CRISP8_CACHE_LINE_SIZE) _Atomic uint64_t sequence;
+
+    alignas (CRISP8_CACHE_LINE_SIZE) struct crisp8ExportSnapshot snapshot;
+};
+
+struct crisp8Exporter_s
+{
+    chip8 emulator;
+    struct segment* segment;
+    char* name;
+};
+
+struct crisp8ExportReader_s
+{
+    const struct segment* segment;
+    // The sequence of the last snapshot returned
+    uint64_t lastSequence;
+};
+
+#ifdef HAVE_SHARED_MEMORY
+int8_t crisp8ExporterOpen (crisp8Exporter* exporter, chip8 emulator, const char* name)
+{
+    *exporter = calloc (1, sizeof (**exporter));
+    if (!(*exporter))
+    {
+        return -1;
+    }
+
+    (*exporter)->name = malloc (strlen (name) + 1);
+    if (!(*exporter)->name)
+    {
+        free (*exporter);
+        *exporter = NULL;
+        return -1;
+    }
+
+    strcpy ((*exporter)->name, name);
+
+    // Viewers still mapping an old object keep it; new ones get the fresh one
+    shm_unlink (name);
+    int file = shm_open (name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    void* mapping = MAP_FAILED;
+
+    if (file >= 0)
+    {
+        if (ftruncate (file, sizeof (struct segment)) == 0)
+        {
+            mapping = mmap (NULL, sizeof (struct segment), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        }
+
+        close (file);
+    }
+
+    if (mapping == MAP_FAILED)
+    {
+        if (file >= 0)
+        {
+            shm_unlink (name);
+        }
+
+        free ((*exporter)->name);
+        free (*exporter);
+        *exporter = NULL;
+        return -1;
+    }
+
+    // The object starts out zeroed, so the sequence is already 0 (nothing published)
+    struct segment* segment = mapping;
+    memcpy (segment->magic, CRISP8_EXPORT_MAGIC, sizeof (CRISP8_EXPORT_MAGIC));
+    segment->version = CRISP8_EXPORT_VERSION;
+    segment->snapshotSize = sizeof (struct crisp8ExportSnapshot);
+    segment->byteOrderMark = 0x0102;
+
+    (*exporter)->emulator = emulator;
+    (*exporter)->segment = segment;
+
+    return 0;
+}
+
+void crisp8ExporterPublish (crisp8Exporter exporter)
+{
+    struct segment* segment = exporter->segment;
+    chip8 emulator = exporter->emulator;
+
+    // Only this thread writes the sequence, so it can be read relaxed
+    uint64_t sequence = atomic_load_explicit (&segment->sequence, memory_order_relaxed);
+    atomic_store_explicit (&segment->sequence, sequence + 1, memory_order_relaxed);
+    // Keeps the snapshot writes from moving above the odd sequence
+    atomic_thread_fence (memory_order_release);
+
+    struct crisp8ExportSnapshot* snapshot = &segment->snapshot;
+    snapshot->sequence = sequence / 2;
+    snapshot->cycleCount = emulator->cycleCount;
+    snapshot->PC = emulator->PC;
+    snapshot->I = emulator->I;
+    memcpy (snapshot->V, emulator->V, sizeof (snapshot->V));
+
+    snapshot->delayTimer = emulator->delayTimer;
+    snapshot->soundTimer = emulator->soundTimer;
+    snapshot->soundPlaying = emulator->soundPlaying;
+    snapshot->exited = emulator->exited;
+
+    snapshot->stackDepth = emulator->stack.stackPtr - emulator->stack.stack;
+    memcpy (snapshot->stack, emulator->stack.stack, sizeof (snapshot->stack));
+
+    snapshot->displayWidth = emulator->displayWidth;
+    snapshot->displayHeight = emulator->displayHeight;
+    memcpy (snapshot->displayRows, emulator->displayRows, sizeof (snapshot->displayRows));
+
+    atomic_store_explicit (&segment->sequence, sequence + 2, memory_order_release);
+}
+
+void crisp8ExporterClose (crisp8Exporter* exporter, bool unlink)
+{
+    munmap ((*exporter)->segment, sizeof (struct segment));
+
+    if (unlink)
+    {
+        shm_unlink ((*exporter)->name);
+    }
+
+    free ((*exporter)->name);
+    free (*exporter);
+    *exporter = NULL;
+}
+
+int8_t crisp8ExportReaderOpen (crisp8ExportReader* reader, const char* name)
+{
+    int file = shm_open (name, O_RDONLY, 0);
+    if (file < 0)
+    {
+        return -1;
+    }
+
+    // An exporter that is still setting the object up may not have sized it yet
+    struct stat info;
+    if (fstat (file, &info) < 0 || info.st_size < (off_t)sizeof (struct segment))
+    {
+        close (file);
+        return -1;
+    }
+
+    void* mapping = mmap (NULL, sizeof (struct segment), PROT_READ, MAP_SHARED, file, 0);
+    close (file);
+
+    if (mapping == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    const struct segment* segment = mapping;
+    if (memcmp (segment->magic, CRISP8_EXPORT_MAGIC, sizeof (CRISP8_EXPORT_MAGIC)) != 0 ||
+        segment->version != CRISP8_EXPORT_VERSION || segment->snapshotSize != sizeof (struct crisp8ExportSnapshot) ||
+        segment->byteOrderMark != 0x0102)
+    {
+        munmap (mapping, sizeof (struct segment));
+        return -1;
+    }
+
+    *reader = calloc (1, sizeof (**reader));
+    if (!(*reader))
+    {
+        munmap (mapping, sizeof (struct segment));
+        return -1;
+    }
+
+    (*reader)->segment = segment;
+    (*reader)->lastSequence = 0;
+
+    return 0;
+}
+
+int8_t crisp8ExportReaderRead (crisp8ExportReader reader, struct crisp8ExportSnapshot* snapshot)
+{
+    // The segment is mapped read only, but the atomic loads need a non const pointer
+    struct segment* segment = (struct segment*)reader->segment;
+
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++)
+    {
+        uint64_t before = atomic_load_explicit (&segment->sequence, memory_order_acquire);
+        if (before == 0)
+        {
+            return -1;
+        }
+
+        if (before & 1)
+        {
+            continue;
+        }
+
+        memcpy (snapshot, &segment->snapshot, sizeof (*snapshot));
+
+        // Keeps the copy from moving below the second look at the sequence
+        atomic_thread_fence (memory_order_acquire);
+        uint64_t after = atomic_load_explicit (&segment->sequence, memory_order_relaxed);
+
+        if (before == after)
+        {
+            bool fresh = before != reader->lastSequence;
+            reader->lastSequence = before;
+            return fresh;
+        }
+    }
+
+    return -1;
+}
+
+void crisp8ExportReaderClose (crisp8ExportReader* reader)
+{
+    munmap ((void*)(*reader)->segment, sizeof (struct segment));
+    free (*reader);
+    *reader = NULL;
+}
+#else
+int8_t crisp8ExporterOpen (crisp8Exporter* exporter, chip8 emulator, const char* name)
+{
+    *exporter = NULL;
+    return -1;
+}
+
+void crisp8ExporterPublish (crisp8Exporter exporter)
+{
+}
+
+void crisp8ExporterClose (crisp8Exporter* exporter, bool unlink)
+{
+    *exporter = NULL;
+}
+
+int8_t crisp8ExportReaderOpen (crisp8ExportReader* reader, const char* name)
+{
+    *reader = NULL;
+    return -1;
+}
+
+int8_t crisp8ExportReaderRead (crisp8ExportReader reader, struct crisp8ExportSnapshot* snapshot)
+{
+    return -1;
+}
+
+void crisp8ExportReaderClose (crisp8ExportReader* reader)
+{
+    *reader = NULL;
+}
+#endif
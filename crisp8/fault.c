@@ -0,0 +1,71 @@
+#include "fault.h"
+
+#include "fault_private.h"
+#include "crisp8_private.h"
+
+#include <string.h>
+
+void crisp8FaultRecord (chip8 emulator, enum crisp8FaultType type, uint16_t opcode)
+{
+    struct crisp8FaultQueue* queue = &emulator->faults;
+
+    emulator->events |= CRISP8_EVENT_FAULT;
+    emulator->counters.faults++;
+
+    if (emulator->stopOnFault)
+    {
+        emulator->faultStop = true;
+    }
+
+    // The first faults are usually the interesting ones, so the newest are dropped when the queue is full
+    if (queue->count == CRISP8_FAULT_QUEUE_SIZE)
+    {
+        queue->dropped++;
+        return;
+    }
+
+    struct crisp8Fault* fault = &queue->faults [(queue->first + queue->count) % CRISP8_FAULT_QUEUE_SIZE];
+    fault->type = type;
+    fault->cycle = emulator->cycleCount;
+    fault->PC = emulator->PC - 2;
+    fault->opcode = opcode;
+    fault->I = emulator->I;
+
+    queue->count++;
+}
+
+bool crisp8FaultPop (chip8 emulator, struct crisp8Fault* fault)
+{
+    struct crisp8FaultQueue* queue = &emulator->faults;
+
+    if (queue->count == 0)
+    {
+        return false;
+    }
+
+    *fault = queue->faults [queue->first];
+    queue->first = (queue->first + 1) % CRISP8_FAULT_QUEUE_SIZE;
+    queue->count--;
+
+    return true;
+}
+
+uint8_t crisp8FaultCount (chip8 emulator)
+{
+    return emulator->faults.count;
+}
+
+uint32_t crisp8FaultDropped (chip8 emulator)
+{
+    return emulator->faults.dropped;
+}
+
+void crisp8FaultClear (chip8 emulator)
+{
+    memset (&emulator->faults, 0, sizeof (emulator->faults));
+}
+
+void crisp8SetStopOnFault (chip8 emulator, bool stop)
+{
+    emulator->stopOnFault = stop;
+}
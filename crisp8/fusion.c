@@ -0,0 +1,73 @@
+#include "fusion.h"
+
+#include "fusion_private.h"
+#include "crisp8_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int8_t crisp8FusionEnable (chip8 emulator)
+{
+    if (!emulator->fusion)
+    {
+        emulator->fusion = malloc (emulator->memorySize);
+        if (!emulator->fusion)
+        {
+            return -1;
+        }
+    }
+
+    crisp8FusionReset (emulator);
+    return 0;
+}
+
+void crisp8FusionDisable (chip8 emulator)
+{
+    free (emulator->fusion);
+    emulator->fusion = NULL;
+}
+
+uint8_t crisp8FusionAnalyse (chip8 emulator, uint16_t address)
+{
+    address &= emulator->memoryMask;
+    uint8_t operation = CRISP8_FUSED_NONE;
+
+    // Sequences that would wrap around the end of memory are left alone, which keeps the fused operations simple
+    if ((uint32_t)address + CRISP8_FUSION_MAX_LENGTH <= emulator->memorySize)
+    {
+        const uint8_t* code = emulator->memory + address;
+        uint16_t instructions [CRISP8_FUSION_MAX_LENGTH / 2];
+
+        for (int i = 0; i < CRISP8_FUSION_MAX_LENGTH / 2; i++)
+        {
+            instructions [i] = (uint16_t)code [i * 2] << 8 | code [i * 2 + 1];
+        }
+
+        // 1NNN only reaches the first 4 KiB, so loops can't start any further
+        uint16_t loopBack = address < 0x1000 ? 0x1000 | address : 0;
+        uint16_t x = instructions [0] & 0x0F00;
+
+        if (instructions [0] == loopBack)
+        {
+            operation = CRISP8_FUSED_IDLE;
+        }
+        else if ((instructions [0] & 0xF000) == 0x6000 && (instructions [1] & 0xF000) == 0x6000 &&
+                 (instructions [2] & 0xF000) == 0xA000 && (instructions [3] & 0xF000) == 0xD000)
+        {
+            operation = CRISP8_FUSED_POSITION_DRAW;
+        }
+        else if ((instructions [0] & 0xF000) == 0x7000 && (instructions [1] & 0xFF00) == (0x3000 | x) &&
+                 instructions [2] == loopBack)
+        {
+            operation = CRISP8_FUSED_COUNTED_LOOP;
+        }
+        else if ((instructions [0] & 0xF0FF) == 0xF007 && (instructions [1] & 0xFF00) == (0x3000 | x) &&
+                 instructions [2] == loopBack)
+        {
+            operation = CRISP8_FUSED_TIMER_POLL;
+        }
+    }
+
+    emulator->fusion [address] = operation;
+    return operation;
+}
@@ -0,0 +1,108 @@
+#include "state.h"
+
+#include "hash_private.h"
+#include "crisp8_private.h"
+
+#include <string.h>
+
+uint64_t crisp8HashMemory (chip8 emulator)
+{
+    uint64_t hash = 0;
+    for (uint32_t address = 0; address < emulator->memorySize; address++)
+    {
+        hash ^= crisp8HashMemoryByte (address, emulator->memory [address]);
+    }
+
+    return hash;
+}
+
+uint64_t crisp8HashDisplay (chip8 emulator)
+{
+    const uint64_t* words = &emulator->displayRows [0][0][0];
+    uint64_t hash = 0;
+
+    for (uint32_t i = 0; i < sizeof (emulator->displayRows) / sizeof (words [0]); i++)
+    {
+        hash ^= crisp8HashDisplayWord (i, words [i]);
+    }
+
+    return hash;
+}
+
+void crisp8HashMemoryChanged (chip8 emulator)
+{
+    if (emulator->hashing)
+    {
+        emulator->memoryHash = crisp8HashMemory (emulator);
+    }
+}
+
+void crisp8HashDisplayChanged (chip8 emulator)
+{
+    if (emulator->hashing)
+    {
+        emulator->displayHash = crisp8HashDisplay (emulator);
+    }
+}
+
+void crisp8StateHashEnable (chip8 emulator)
+{
+    emulator->hashing = true;
+    crisp8HashMemoryChanged (emulator);
+    crisp8HashDisplayChanged (emulator);
+}
+
+void crisp8StateHashDisable (chip8 emulator)
+{
+    emulator->hashing = false;
+}
+
+// Mixes a value into a hash
+//
+// Parameters:
+//  hash: the hash so far
+//  value: the value to add
+static uint64_t combine (uint64_t hash, uint64_t value)
+{
+    return crisp8HashMix (hash ^ value) + 0x9E3779B97F4A7C15;
+}
+
+uint64_t crisp8StateHash (chip8 emulator)
+{
+    uint64_t memoryHash = emulator->hashing ? emulator->memoryHash : crisp8HashMemory (emulator);
+    uint64_t displayHash = emulator->hashing ? emulator->displayHash : crisp8HashDisplay (emulator);
+
+    uint64_t hash = combine (0, memoryHash);
+    hash = combine (hash, displayHash);
+
+    uint64_t words [2];
+    memcpy (words, emulator->V, sizeof (words));
+    hash = combine (hash, words [0]);
+    hash = combine (hash, words [1]);
+
+    memcpy (words, emulator->flagRegisters, sizeof (words));
+    hash = combine (hash, words [0]);
+    hash = combine (hash, words [1]);
+
+    hash = combine (hash, (uint64_t)emulator->PC | (uint64_t)emulator->I << 16 |
+                          (uint64_t)emulator->delayTimer << 32 | (uint64_t)emulator->soundTimer << 40 |
+                          (uint64_t)emulator->displayWidth << 48 | (uint64_t)emulator->selectedPlanes << 56);
+    hash = combine (hash, (uint64_t)emulator->waitingForKey | (uint64_t)emulator->exited << 1);
+
+    // The depth goes in first so stacks that differ only in length don't collide
+    const uint16_t* item = emulator->stack.stack;
+    hash = combine (hash, emulator->stack.stackPtr - item);
+    for (; item < emulator->stack.stackPtr; item++)
+    {
+        hash = combine (hash, *item);
+    }
+
+    return hash;
+}
+
+uint64_t crisp8FrameHash (chip8 emulator)
+{
+    uint64_t displayHash = emulator->hashing ? emulator->displayHash : crisp8HashDisplay (emulator);
+    uint64_t resolution = (uint64_t)emulator->displayWidth | (uint64_t)emulator->displayHeight << 8;
+    return combine (combine (0, displayHash), resolution);
+}
@@ -2,6 +2,11 @@
 
 #include "crisp8_private.h"
 #include "stack.h"
+#include "breakpoint_private.h"
+#include "display.h"
+#include "rom_private.h"
+#include "fault_private.h"
+#include "memory_private.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -20,19 +25,85 @@
 #define INSTRUCTION_GET_NN(instruction)  ((instruction) & 0x00FF)
 #define INSTRUCTION_GET_NNN(instruction) ((instruction) & 0x0FFF)
 
+// Quirk bits. Every combination of them gets its own dispatch function in which the quirks are compile time
+// constants, so the configurable instructions don't have to look at the configuration when they are executed.
+// To add a quirk, add a bit here, bump NUM_QUIRKS, check it in the instruction with (quirks & QUIRK_...) and add it to
+// selectDispatchVariant. The dispatch variants are listed by hand, so the new ones have to be added to the
+// DEFINE_DISPATCH_VARIANT list and dispatchVariants too; a _Static_assert catches a table of the wrong size
+#define QUIRK_SHIFT_OLD             (1 << 0)
+#define QUIRK_JUMP_OFFSET_NEW       (1 << 1)
+#define QUIRK_STORE_LOAD_MEMORY_OLD (1 << 2)
+
+#define NUM_QUIRKS 3
+
 // General purpose macros
 
+// Accesses memory at an address. The address wraps around at the end of memory, so a program can never access anything
+// outside of it
+#define MEMORY_AT(emulator, address) ((emulator)->memory [(address) & (emulator)->memoryMask])
+
 // This is for the computer representation of bytes, meaning that bits are now counted from the right.
 // This also counts from 0
 #define NTH_BIT(num, n) (((num) & (1 << (n))) >> (n))
 
+// Reports a memory access to the watchpoints. This is a single predictable branch when no watchpoints are set
+//
+// Parameters:
+//  emulator: the emulator making the access
+//  address: the first accessed address
+//  length: the number of accessed bytes
+//  type: CRISP8_WATCH_READ or CRISP8_WATCH_WRITE
+static inline void watchAccess (chip8 emulator, uint16_t address, uint16_t length, enum crisp8WatchType type)
+{
+    if (emulator->watching)
+    {
+        crisp8BreakpointCheckAccess (emulator, address, length, type);
+    }
+}
+
+// Makes sure the emulator has its own memory before an instruction writes to it. Memory is shared with other emulators
+// while it's attached to a ROM that hasn't been written to yet
+//
+// Parameters:
+//  emulator: the emulator about to write to memory
+static inline void prepareMemoryWrite (chip8 emulator)
+{
+    if (emulator->memoryShared)
+    {
+        crisp8RomPrivatizeMemory (emulator);
+    }
+}
+
+// Records a fault if an access of a number of bytes at I would go past the end of memory. The access itself is safe
+// either way since memory is accessed through MEMORY_AT
+//
+// Parameters:
+//  instruction: the instruction making the access
+//  emulator: the emulator making the access
+//  length: the number of bytes accessed
+//
+// Return value:
+//  True if the access goes past the end of memory
+static inline bool checkIndexRange (uint16_t instruction, chip8 emulator, uint16_t length)
+{
+    if ((uint32_t)emulator->I + length > emulator->memorySize)
+    {
+        crisp8FaultRecord (emulator, CRISP8_FAULT_INDEX_OUT_OF_RANGE, instruction);
+        return true;
+    }
+
+    return false;
+}
+
 uint16_t fetchInstruction (chip8 emulator)
 {
+    watchAccess (emulator, emulator->PC, 2, CRISP8_WATCH_READ);
+
     uint16_t instruction = 0;
     // I'm not quite sure how endiannes work with bitwise operators, but hopefully this still works on non little endian
     // machines.
-    instruction = (uint16_t)emulator->memory [emulator->PC] << 8;
-    instruction |= (uint16_t)emulator->memory [emulator->PC + 1];
+    instruction = (uint16_t)MEMORY_AT (emulator, emulator->PC) << 8;
+    instruction |= (uint16_t)MEMORY_AT (emulator, emulator->PC + 1);
 
     // Increment PC for the next instruction
     emulator->PC += 2;
@@ -40,6 +111,17 @@ uint16_t fetchInstruction (chip8 emulator)
     return instruction;
 }
 
+// Skips the instruction after the one being executed. XO-CHIP's F000 NNNN is four bytes long, so it's skipped as a
+// whole
+//
+// Parameters:
+//  emulator: the emulator to operate on
+static inline void skipNextInstruction (chip8 emulator)
+{
+    bool longInstruction = MEMORY_AT (emulator, emulator->PC) == 0xF0 && MEMORY_AT (emulator, emulator->PC + 1) == 0x00;
+    emulator->PC += longInstruction ? 4 : 2;
+}
+
 // Instructions (starts with op for opcode) ----------------------------
 // There are brief comments of what some of them, but honestly just look up the opcodes on wikipedia or something if
 // you want details. There are way better references than anything I should write here
@@ -52,13 +134,62 @@ uint16_t fetchInstruction (chip8 emulator)
 // Clears the screen
 static void opClearScreen (chip8 emulator)
 {
-    memset (emulator->display, 0, sizeof (emulator->display) / sizeof (emulator->display [0]));
+    crisp8DisplayClear (emulator);
+}
+
+// 00CN (SUPER-CHIP)
+// Scroll down N pixels
+static void opScrollDown (uint16_t instruction, chip8 emulator)
+{
+    crisp8DisplayScrollDown (emulator, INSTRUCTION_GET_N (instruction));
+}
+
+// 00DN (XO-CHIP)
+// Scroll up N pixels
+static void opScrollUp (uint16_t instruction, chip8 emulator)
+{
+    crisp8DisplayScrollUp (emulator, INSTRUCTION_GET_N (instruction));
+}
+
+// 00FB (SUPER-CHIP)
+// Scroll right 4 pixels
+static void opScrollRight (chip8 emulator)
+{
+    crisp8DisplayScrollRight (emulator);
+}
+
+// 00FC (SUPER-CHIP)
+// Scroll left 4 pixels
+static void opScrollLeft (chip8 emulator)
+{
+    crisp8DisplayScrollLeft (emulator);
+}
+
+// 00FD (SUPER-CHIP)
+// Exit the interpreter. There is nothing to exit to, so this just keeps executing itself
+static void opExit (chip8 emulator)
+{
+    emulator->exited = true;
+    emulator->PC -= 2;
+}
+
+// 00FE/00FF (SUPER-CHIP)
+// Switch to low/high resolution
+static void opSetResolution (uint16_t instruction, chip8 emulator)
+{
+    crisp8DisplaySetHires (emulator, instruction == 0x00FF);
 }
 
 // 1NNN
 // Unconditional jump
 static void opJump (uint16_t instruction, chip8 emulator)
 {
+    // A jump to itself is how programs halt, so the cycles spent on it are idle
+    if (INSTRUCTION_GET_NNN (instruction) == (uint16_t)(emulator->PC - 2))
+    {
+        emulator->counters.idleCycles++;
+    }
+
     emulator->PC = INSTRUCTION_GET_NNN (instruction);
 }
 
@@ -66,12 +197,19 @@ static void opJump (uint16_t instruction, chip8 emulator)
 // Jump to subroutine
 static void opJumpToSubroutine (uint16_t instruction, chip8 emulator)
 {
-    // I'm currently not doing anything against stack over/underflow even though the stack supports it.
-    // I'm considering doing something along the lines of adding internal flags to the chip8 struct that will signal
-    // these sorts of things so a frontend can warn about it in a debugger.
-    // A stack under/overflow should only occur as the result of a faulty rom so I think it makes sense to leave
-    // it to a debugger.
-    crisp8StackPush (emulator->stack, emulator->PC);
+    // A stack overflow should only occur as the result of a faulty rom, so it's left to a debugger to pick up the
+    // fault. The jump is made anyway
+    if (crisp8StackPush (&emulator->stack, emulator->PC) < 0)
+    {
+        crisp8FaultRecord (emulator, CRISP8_FAULT_STACK_OVERFLOW, instruction);
+    }
+
+    uint8_t depth = emulator->stack.stackPtr - emulator->stack.stack;
+    if (depth > emulator->counters.stackHighWater)
+    {
+        emulator->counters.stackHighWater = depth;
+    }
+
     emulator->PC = INSTRUCTION_GET_NNN (instruction);
 }
 
@@ -80,7 +218,14 @@ static void opJumpToSubroutine (uint16_t instruction, chip8 emulator)
 static void opReturnFromSubroutine (chip8 emulator)
 {
     uint16_t returnAddress;
-    crisp8StackPop(emulator->stack, &returnAddress);
+
+    // There is nowhere to return to, so just carry on with the next instruction
+    if (crisp8StackPop (&emulator->stack, &returnAddress) < 0)
+    {
+        crisp8FaultRecord (emulator, CRISP8_FAULT_STACK_UNDERFLOW, 0x00EE);
+        return;
+    }
+
     emulator->PC = returnAddress;
 }
 
@@ -91,7 +236,7 @@ static void opSkipIfEqualImmediate (uint16_t instruction, chip8 emulator)
     uint8_t compareValue = INSTRUCTION_GET_NN (instruction);
     if (emulator->V [registerNum] == compareValue)
     {
-        emulator->PC += 2;
+        skipNextInstruction (emulator);
     }
 }
 
@@ -102,7 +247,7 @@ static void opSkipIfNotEqualImmediate (uint16_t instruction, chip8 emulator)
     uint8_t compareValue = INSTRUCTION_GET_NN (instruction);
     if (emulator->V [registerNum] != compareValue)
     {
-        emulator->PC += 2;
+        skipNextInstruction (emulator);
     }
 }
 
@@ -113,7 +258,44 @@ static void opSkipIfEqualRegisters (uint16_t instruction, chip8 emulator)
     uint8_t registerY = INSTRUCTION_GET_Y (instruction);
     if (emulator->V [registerX] == emulator->V [registerY])
     {
-        emulator->PC += 2;
+        skipNextInstruction (emulator);
+    }
+}
+
+// 5XY2 (XO-CHIP)
+// Store the registers VX to VY (in that order, so possibly backwards) to memory. I is not changed
+static void opStoreRegisterRange (uint16_t instruction, chip8 emulator)
+{
+    uint8_t registerX = INSTRUCTION_GET_X (instruction);
+    uint8_t registerY = INSTRUCTION_GET_Y (instruction);
+    int8_t direction = registerX <= registerY ? 1 : -1;
+    uint8_t count = (registerX <= registerY ? registerY - registerX : registerX - registerY) + 1;
+
+    watchAccess (emulator, emulator->I, count, CRISP8_WATCH_WRITE);
+    checkIndexRange (instruction, emulator, count);
+    prepareMemoryWrite (emulator);
+
+    for (int i = 0; i < count; i++)
+    {
+        crisp8WriteMemory (emulator, emulator->I + i, emulator->V [registerX + i * direction]);
+    }
+}
+
+// 5XY3 (XO-CHIP)
+// Load the registers VX to VY (in that order, so possibly backwards) from memory. I is not changed
+static void opLoadRegisterRange (uint16_t instruction, chip8 emulator)
+{
+    uint8_t registerX = INSTRUCTION_GET_X (instruction);
+    uint8_t registerY = INSTRUCTION_GET_Y (instruction);
+    int8_t direction = registerX <= registerY ? 1 : -1;
+    uint8_t count = (registerX <= registerY ? registerY - registerX : registerX - registerY) + 1;
+
+    watchAccess (emulator, emulator->I, count, CRISP8_WATCH_READ);
+    checkIndexRange (instruction, emulator, count);
+
+    for (int i = 0; i < count; i++)
+    {
+        emulator->V [registerX + i * direction] = MEMORY_AT (emulator, emulator->I + i);
     }
 }
 
@@ -124,7 +306,7 @@ static void opSkipIfNotEqualRegisters (uint16_t instruction, chip8 emulator)
     uint8_t registerY = INSTRUCTION_GET_Y (instruction);
     if (emulator->V [registerX] != emulator->V [registerY])
     {
-        emulator->PC += 2;
+        skipNextInstruction (emulator);
     }
 }
 
@@ -222,11 +404,11 @@ static void opSubVX (uint16_t instruction, chip8 emulator)
 }
 
 // 8XY6
-static void opShiftRight (uint16_t instruction, chip8 emulator)
+static CRISP8_ALWAYS_INLINE void opShiftRight (uint16_t instruction, chip8 emulator, const unsigned quirks)
 {
     // The original chip-8 put the value in VY in VX before shifting, but this was later removed.
-    // You can choose which behaviour to compile in
-    if (crisp8ConfigGetShift (emulator) == OLD)
+    // You can choose which behaviour to use with crisp8ConfigSetShift
+    if (quirks & QUIRK_SHIFT_OLD)
     {
         emulator->V [INSTRUCTION_GET_X (instruction)] = emulator->V [INSTRUCTION_GET_Y (instruction)];
     }
@@ -238,11 +420,11 @@ static void opShiftRight (uint16_t instruction, chip8 emulator)
 }
 
 // 8XYE
-static void opShiftLeft (uint16_t instruction, chip8 emulator)
+static CRISP8_ALWAYS_INLINE void opShiftLeft (uint16_t instruction, chip8 emulator, const unsigned quirks)
 {
     // The original chip-8 put the value in VY in VX before shifting, but this was later removed.
-    // You can choose which behaviour to compile in
-    if (crisp8ConfigGetShift (emulator) == OLD)
+    // You can choose which behaviour to use with crisp8ConfigSetShift
+    if (quirks & QUIRK_SHIFT_OLD)
     {
         emulator->V [INSTRUCTION_GET_X (instruction)] = emulator->V [INSTRUCTION_GET_Y (instruction)];
     }
@@ -262,29 +444,45 @@ static void opSetIndex (uint16_t instruction, chip8 emulator)
 
 // BNNN/BXNN (depending on config)
 // Jump with offset
-static void opJumpWithOffset (uint16_t instruction, chip8 emulator)
+static CRISP8_ALWAYS_INLINE void opJumpWithOffset (uint16_t instruction, chip8 emulator, const unsigned quirks)
 {
     uint16_t baseAddress = INSTRUCTION_GET_NNN (instruction);
     uint8_t offset;
 
-    if (crisp8ConfigGetJumpOffset (emulator) == OLD)
+    if (quirks & QUIRK_JUMP_OFFSET_NEW)
     {
-        offset = emulator->V [0];
+        offset = emulator->V [INSTRUCTION_GET_X (instruction)];
     }
     else
     {
-        offset = emulator->V [INSTRUCTION_GET_X (instruction)];
+        offset = emulator->V [0];
     }
 
     emulator->PC = baseAddress + offset;
 }
 
+// Returns the next random byte of the emulator's xorshift64* generator
+//
+// Parameters:
+//  emulator: the emulator whose generator to advance
+static uint8_t nextRandom (chip8 emulator)
+{
+    uint64_t state = emulator->randomState;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    emulator->randomState = state;
+
+    // The high bits are the good ones
+    return (state * 0x2545F4914F6CDD1D) >> 56;
+}
+
 // CXNN
 // Random
 static void opRandom (uint16_t instruction, chip8 emulator)
 {
-    // I don't think a library should call srand, so it has to be clear to the user that it is their responsibility
-    uint8_t randomNum = rand () & INSTRUCTION_GET_NN (instruction);
+    // Every emulator has its own generator, so emulators on different threads don't share (or fight over) rand's state
+    uint8_t randomNum = nextRandom (emulator) & INSTRUCTION_GET_NN (instruction);
     emulator->V [INSTRUCTION_GET_X (instruction)] = randomNum;
 }
 
@@ -292,14 +490,14 @@ static void opRandom (uint16_t instruction, chip8 emulator)
 // Skip if key is pressed
 static void opSkipIfKey (uint16_t instruction, chip8 emulator)
 {
-    uint32_t keyMap = emulator->inputCb ();
+    uint32_t keyMap = emulator->inputCb (emulator->inputUserdata);
     uint8_t key = emulator->V [INSTRUCTION_GET_X (instruction)];
 
     // The keymap in defs.h is set up such that the value in VX will be the bit corresponding to its key.
     // Key values from 0x0 to 0xF are allowed; A value outside of this is counted as not pressed
-    if (keyMap & (1 << key) && key <= 0xF)
+    if (key <= 0xF && (keyMap & (1 << key)))
     {
-        emulator->PC += 2;
+        skipNextInstruction (emulator);
     }
 }
 
@@ -307,68 +505,70 @@ static void opSkipIfKey (uint16_t instruction, chip8 emulator)
 // Skip if key is not pressed
 static void opSkipIfNotKey (uint16_t instruction, chip8 emulator)
 {
-    uint32_t keyMap = emulator->inputCb ();
+    uint32_t keyMap = emulator->inputCb (emulator->inputUserdata);
     uint8_t key = emulator->V [INSTRUCTION_GET_X (instruction)];
 
     // The keymap in defs.h is set up such that the value in VX will be the bit corresponding to its key
     // Key values from 0x0 to 0xF are allowed; A value outside of this is counted as not pressed
-    if ((!(keyMap & (1 << key))) || key > 0xF)
+    if (key > 0xF || !(keyMap & (1 << key)))
     {
-        emulator->PC += 2;
+        skipNextInstruction (emulator);
     }
 }
 
 // DXYN
-// Draws to the screen
+// Draws to the screen. DXY0 draws a 16x16 sprite (SUPER-CHIP)
 static void opDraw (uint16_t instruction, chip8 emulator)
 {
-    emulator->V [0xF] = 0;
-
-    uint8_t xCoord = emulator->V [INSTRUCTION_GET_X (instruction)] % CRISP8_DISPLAY_WIDTH;
-    uint8_t yCoord = emulator->V [INSTRUCTION_GET_Y (instruction)] % CRISP8_DISPLAY_HEIGHT;
+    uint8_t xCoord = emulator->V [INSTRUCTION_GET_X (instruction)];
+    uint8_t yCoord = emulator->V [INSTRUCTION_GET_Y (instruction)];
     uint8_t height = INSTRUCTION_GET_N (instruction);
+    uint8_t width = 8;
 
-    uint16_t spriteAddress = emulator->I;
-
-    for (int j = yCoord; j < yCoord + height && j < CRISP8_DISPLAY_HEIGHT; j++)
+    if (height == 0)
     {
-        uint8_t sprite = emulator->memory [spriteAddress];
+        width = 16;
+        height = 16;
+    }
 
-        // xCoord + 8 since a sprite is represented by an 8 bit byte
-        for (int i = xCoord; i < xCoord + 8 && i < CRISP8_DISPLAY_WIDTH; i++)
+    // Every selected plane has its own sprite data
+    uint8_t numPlanes = (emulator->selectedPlanes & 1) + (emulator->selectedPlanes >> 1);
+    uint8_t spriteSize = height * (width / 8) * numPlanes;
+    watchAccess (emulator, emulator->I, spriteSize, CRISP8_WATCH_READ);
+
+    // The sprite is normally read straight out of memory. Only if it runs past the end is it gathered with wrap around
+    const uint8_t* sprite = &MEMORY_AT (emulator, emulator->I);
+    uint8_t wrappedSprite [16 * 2 * CRISP8_DISPLAY_PLANES];
+
+    if ((uint32_t)(emulator->I & emulator->memoryMask) + spriteSize > emulator->memorySize)
+    {
+        for (int i = 0; i < spriteSize; i++)
         {
-#ifdef CRISP8_DISPLAY_USE_ALPHA
-            if (NTH_BIT (sprite, 7))
-            {
-                if (emulator->display [(j * CRISP8_DISPLAY_WIDTH) + i] == 0xFF)
-                {
-                    emulator->display [(j * CRISP8_DISPLAY_WIDTH) + i] -= 1;
-                    emulator->V [0xF] = 1;
-                }
-                else
-                {
-                    emulator->display [(j * CRISP8_DISPLAY_WIDTH) + i] = 0xFF;
-                }
-            }
-#else
-            if (NTH_BIT (sprite, 7))
-            {
-                if (emulator->display [(j * CRISP8_DISPLAY_WIDTH) + i])
-                {
-                    emulator->display [(j * CRISP8_DISPLAY_WIDTH) + i] = 0;
-                    emulator->V [0xF] = 1;
-                }
-                else
-                {
-                    emulator->display [(j * CRISP8_DISPLAY_WIDTH) + i] = 1;
-                }
-            }
-#endif
-            sprite = sprite << 1;
+            wrappedSprite [i] = MEMORY_AT (emulator, emulator->I + i);
         }
 
-        spriteAddress += 1;
+        sprite = wrappedSprite;
     }
+
+    checkIndexRange (instruction, emulator, spriteSize);
+
+    bool collision = crisp8DisplayDrawSprite (emulator, xCoord, yCoord, sprite, width, height);
+    emulator->V [0xF] = collision;
+}
+
+// F000 NNNN (XO-CHIP)
+// Sets the index register to the 16 bit address in the next two bytes
+static void opSetIndexLong (chip8 emulator)
+{
+    emulator->I = ((uint16_t)MEMORY_AT (emulator, emulator->PC) << 8) | MEMORY_AT (emulator, emulator->PC + 1);
+    emulator->PC += 2;
+}
+
+// FN01 (XO-CHIP)
+// Select the bitplanes to draw on
+static void opSelectPlanes (uint16_t instruction, chip8 emulator)
+{
+    emulator->selectedPlanes = INSTRUCTION_GET_X (instruction) & ((1 << CRISP8_DISPLAY_PLANES) - 1);
 }
 
 // FX07
@@ -409,14 +609,23 @@ static void opAddToIndex (uint16_t instruction, chip8 emulator)
 static void opGetKey (uint16_t instruction, chip8 emulator)
 {
     // A key is registered on release, so we have to do some funky stuff
-    uint32_t keyMap = emulator->inputCb ();
+    uint32_t keyMap = emulator->inputCb (emulator->inputUserdata);
 
     if (!emulator->lastKeyState || keyMap == emulator->lastKeyState)
     {
         emulator->PC -= 2;
+        emulator->counters.keyWaitCycles++;
+
+        if (!emulator->waitingForKey)
+        {
+            emulator->waitingForKey = true;
+            emulator->events |= CRISP8_EVENT_KEY_WAIT;
+        }
     }
     else
     {
+        emulator->waitingForKey = false;
+
         for (int i = 0; i <= 0xF; i++)
         {
             if (NTH_BIT (emulator->lastKeyState, i) && !NTH_BIT (keyMap, i))
@@ -443,32 +652,49 @@ static void opFontCharacter (uint16_t instruction, chip8 emulator)
     emulator->I = fontAddress;
 }
 
+// FX30 (SUPER-CHIP)
+// Big font character
+static void opBigFontCharacter (uint16_t instruction, chip8 emulator)
+{
+    uint8_t character = emulator->V [INSTRUCTION_GET_X (instruction)] & 0x0F;
+
+    // Every big font sprite is 10 pixels tall
+    emulator->I = CRISP8_BIG_FONT_START_ADDRESS + (character * 10);
+}
+
 // FX33
 // Decimal conversion
 static void opDecimalConvert (uint16_t instruction, chip8 emulator)
 {
     uint8_t number = emulator->V [INSTRUCTION_GET_X (instruction)];
+    watchAccess (emulator, emulator->I, 3, CRISP8_WATCH_WRITE);
+    checkIndexRange (instruction, emulator, 3);
+    prepareMemoryWrite (emulator);
+
     for (int i = 2; i >= 0; i--)
     {
-        emulator->memory [emulator->I + i] = number % 10;
+        crisp8WriteMemory (emulator, emulator->I + i, number % 10);
         number /= 10;
     }
 }
 
 // FX55
 // Store registers to memory
-static void opStoreMemory (uint16_t instruction, chip8 emulator)
+static CRISP8_ALWAYS_INLINE void opStoreMemory (uint16_t instruction, chip8 emulator, const unsigned quirks)
 {
     uint8_t numRegisters = INSTRUCTION_GET_X (instruction);
+    watchAccess (emulator, emulator->I, numRegisters + 1, CRISP8_WATCH_WRITE);
+    checkIndexRange (instruction, emulator, numRegisters + 1);
+    prepareMemoryWrite (emulator);
 
     for (int i = 0; i <= numRegisters; i++)
     {
-        emulator->memory [emulator->I + i] = emulator->V [i];
+        crisp8WriteMemory (emulator, emulator->I + i, emulator->V [i]);
     }
 
     // In the old behaviour, the I register was incremented as it worked.
     // We can simulate this in O(1) by just calculating the new address
-    if (crisp8ConfigGetStoreLoadMemory (emulator) == OLD)
+    if (quirks & QUIRK_STORE_LOAD_MEMORY_OLD)
     {
         emulator->I += numRegisters + 1;
     }
@@ -476,26 +702,43 @@ static void opStoreMemory (uint16_t instruction, chip8 emulator)
 
 // FX65
 // Load registers from memory
-static void opLoadMemory (uint16_t instruction, chip8 emulator)
+static CRISP8_ALWAYS_INLINE void opLoadMemory (uint16_t instruction, chip8 emulator, const unsigned quirks)
 {
     uint8_t numRegisters = INSTRUCTION_GET_X (instruction);
+    watchAccess (emulator, emulator->I, numRegisters + 1, CRISP8_WATCH_READ);
+    checkIndexRange (instruction, emulator, numRegisters + 1);
 
     for (int i = 0; i <= numRegisters; i++)
     {
-        emulator->V [i] = emulator->memory [emulator->I + i];
+        emulator->V [i] = MEMORY_AT (emulator, emulator->I + i);
     }
 
     // In the old behaviour, the I register was incremented as it worked.
     // We can simulate afterwards by just calculating the new address
-    if (crisp8ConfigGetStoreLoadMemory (emulator) == OLD)
+    if (quirks & QUIRK_STORE_LOAD_MEMORY_OLD)
     {
         emulator->I += numRegisters + 1;
     }
 }
 
+// FX75 (SUPER-CHIP)
+// Store registers to the flag registers
+static void opStoreFlags (uint16_t instruction, chip8 emulator)
+{
+    memcpy (emulator->flagRegisters, emulator->V, INSTRUCTION_GET_X (instruction) + 1);
+}
+
+// FX85 (SUPER-CHIP)
+// Load registers from the flag registers
+static void opLoadFlags (uint16_t instruction, chip8 emulator)
+{
+    memcpy (emulator->V, emulator->flagRegisters, INSTRUCTION_GET_X (instruction) + 1);
+}
+
 // Instruction decoding ------------------------------------------------
 // This group of functions decode instructions before executing them.
-// They all take the instruction to decode and the emulator to operate on as parameters.
+// They all take the instruction to decode and the emulator to operate on as parameters. The ones that lead to
+// configurable instructions also take the quirks, which are always a constant (see the dispatch variants below).
 
 static void decodeType0 (uint16_t instruction, chip8 emulator)
 {
@@ -507,10 +750,57 @@ static void decodeType0 (uint16_t instruction, chip8 emulator)
         case 0x00EE:
             opReturnFromSubroutine (emulator);
             break;
+        case 0x00FB:
+            opScrollRight (emulator);
+            break;
+        case 0x00FC:
+            opScrollLeft (emulator);
+            break;
+        case 0x00FD:
+            opExit (emulator);
+            break;
+        case 0x00FE:
+        case 0x00FF:
+            opSetResolution (instruction, emulator);
+            break;
+        default:
+            if ((instruction & 0xFFF0) == 0x00C0)
+            {
+                opScrollDown (instruction, emulator);
+            }
+            else if ((instruction & 0xFFF0) == 0x00D0)
+            {
+                opScrollUp (instruction, emulator);
+            }
+            else
+            {
+                crisp8FaultRecord (emulator, CRISP8_FAULT_INVALID_OPCODE, instruction);
+            }
+            break;
+    }
+}
+
+static void decodeType5 (uint16_t instruction, chip8 emulator)
+{
+    // The instructions in this group are differentiated by the last nibble
+    switch (INSTRUCTION_GET_NIBBLE (instruction, 3))
+    {
+        case 0:
+            opSkipIfEqualRegisters (instruction, emulator);
+            break;
+        case 2:
+            opStoreRegisterRange (instruction, emulator);
+            break;
+        case 3:
+            opLoadRegisterRange (instruction, emulator);
+            break;
+        default:
+            crisp8FaultRecord (emulator, CRISP8_FAULT_INVALID_OPCODE, instruction);
+            break;
     }
 }
 
-static void decodeType8 (uint16_t instruction, chip8 emulator)
+static CRISP8_ALWAYS_INLINE void decodeType8 (uint16_t instruction, chip8 emulator, const unsigned quirks)
 {
     // The instructions in this group are differentiated by the last nibble
     switch (INSTRUCTION_GET_NIBBLE (instruction, 3))
@@ -534,36 +824,55 @@ static void decodeType8 (uint16_t instruction, chip8 emulator)
             opSubVY (instruction, emulator);
             break;
         case 6:
-            opShiftRight (instruction, emulator);
+            opShiftRight (instruction, emulator, quirks);
             break;
         case 7:
             opSubVX (instruction, emulator);
             break;
         case 0xE:
-            opShiftLeft (instruction, emulator);
+            opShiftLeft (instruction, emulator, quirks);
+            break;
+        default:
+            crisp8FaultRecord (emulator, CRISP8_FAULT_INVALID_OPCODE, instruction);
             break;
     }
 }
 
 static void decodeTypeE (uint16_t instruction, chip8 emulator)
 {
-    // The instructions in this group are differentiated by the last nibble
-    switch (INSTRUCTION_GET_NIBBLE (instruction, 3))
+    // The instructions in this group are differentiated by the two last nibbles
+    switch (INSTRUCTION_GET_NN (instruction))
     {
-        case 1:
+        case 0xA1:
             opSkipIfNotKey (instruction, emulator);
             break;
-        case 0xE:
+        case 0x9E:
             opSkipIfKey (instruction, emulator);
             break;
+        default:
+            crisp8FaultRecord (emulator, CRISP8_FAULT_INVALID_OPCODE, instruction);
+            break;
     }
 }
 
-static void decodeTypeF (uint16_t instruction, chip8 emulator)
+static CRISP8_ALWAYS_INLINE void decodeTypeF (uint16_t instruction, chip8 emulator, const unsigned quirks)
 {
     // This group of instructions are differentiated by the two last nibbles
     switch (INSTRUCTION_GET_NN (instruction))
     {
+        case 0x00:
+            if (instruction == 0xF000)
+            {
+                opSetIndexLong (emulator);
+            }
+            else
+            {
+                crisp8FaultRecord (emulator, CRISP8_FAULT_INVALID_OPCODE, instruction);
+            }
+            break;
+        case 0x01:
+            opSelectPlanes (instruction, emulator);
+            break;
         case 0x07:
             opSetVXDelay (instruction, emulator);
             break;
@@ -582,19 +891,32 @@ static void decodeTypeF (uint16_t instruction, chip8 emulator)
         case 0x29:
             opFontCharacter (instruction, emulator);
             break;
+        case 0x30:
+            opBigFontCharacter (instruction, emulator);
+            break;
         case 0x33:
             opDecimalConvert (instruction, emulator);
             break;
         case 0x55:
-            opStoreMemory (instruction, emulator);
+            opStoreMemory (instruction, emulator, quirks);
             break;
         case 0x65:
-            opLoadMemory (instruction, emulator);
+            opLoadMemory (instruction, emulator, quirks);
+            break;
+        case 0x75:
+            opStoreFlags (instruction, emulator);
+            break;
+        case 0x85:
+            opLoadFlags (instruction, emulator);
+            break;
+        default:
+            crisp8FaultRecord (emulator, CRISP8_FAULT_INVALID_OPCODE, instruction);
             break;
     }
 }
 
-void dispatchInstruction (uint16_t instruction, chip8 emulator)
+// The generic dispatcher. It is only ever called with constant quirks by the dispatch variants
+static CRISP8_ALWAYS_INLINE void dispatchWithQuirks (uint16_t instruction, chip8 emulator, const unsigned quirks)
 {
     // Instructions on the chip8 are divided into types by the first nibble. If an instruction is alone in its type, it
     // just gets executed, otherwise it is sent to a decoding function for further decoding.
@@ -616,7 +938,7 @@ void dispatchInstruction (uint16_t instruction, chip8 emulator)
             opSkipIfNotEqualImmediate (instruction, emulator);
             break;
         case 5:
-            opSkipIfEqualRegisters (instruction, emulator);
+            decodeType5 (instruction, emulator);
             break;
         case 6:
             opSetVXImmediate (instruction, emulator);
@@ -625,7 +947,7 @@ void dispatchInstruction (uint16_t instruction, chip8 emulator)
             opAddVXImmediate (instruction, emulator);
             break;
         case 8:
-            decodeType8 (instruction, emulator);
+            decodeType8 (instruction, emulator, quirks);
             break;
         case 9:
             opSkipIfNotEqualRegisters (instruction, emulator);
@@ -634,7 +956,7 @@ void dispatchInstruction (uint16_t instruction, chip8 emulator)
             opSetIndex (instruction, emulator);
             break;
         case 0xB:
-            opJumpWithOffset (instruction, emulator);
+            opJumpWithOffset (instruction, emulator, quirks);
             break;
         case 0xC:
             opRandom (instruction, emulator);
@@ -646,7 +968,62 @@ void dispatchInstruction (uint16_t instruction, chip8 emulator)
             decodeTypeE (instruction, emulator);
             break;
         case 0xF:
-            decodeTypeF (instruction, emulator);
+            decodeTypeF (instruction, emulator, quirks);
             break;
     }
 }
+
+// Dispatch variants -------------------------------------------------
+// One dispatch function per combination of quirks
+
+#define DEFINE_DISPATCH_VARIANT(quirks) \
+    static void dispatchVariant##quirks (uint16_t instruction, chip8 emulator) \
+    { \
+        dispatchWithQuirks (instruction, emulator, (quirks)); \
+    }
+
+DEFINE_DISPATCH_VARIANT (0)
+DEFINE_DISPATCH_VARIANT (1)
+DEFINE_DISPATCH_VARIANT (2)
+DEFINE_DISPATCH_VARIANT (3)
+DEFINE_DISPATCH_VARIANT (4)
+DEFINE_DISPATCH_VARIANT (5)
+DEFINE_DISPATCH_VARIANT (6)
+DEFINE_DISPATCH_VARIANT (7)
+
+// Indexed by the quirk bits
+static const crisp8DispatchFunction dispatchVariants [] = {
+    dispatchVariant0, dispatchVariant1, dispatchVariant2, dispatchVariant3,
+    dispatchVariant4, dispatchVariant5, dispatchVariant6, dispatchVariant7
+};
+
+// Adding a quirk without adding its variants would index out of the table
+_Static_assert (sizeof (dispatchVariants) / sizeof (dispatchVariants [0]) == (1 << NUM_QUIRKS),
+                "There must be one dispatch variant per quirk combination");
+
+void selectDispatchVariant (chip8 emulator)
+{
+    unsigned quirks = 0;
+
+    if (emulator->config.instructionShift == OLD)
+    {
+        quirks |= QUIRK_SHIFT_OLD;
+    }
+
+    if (emulator->config.instructionJumpOffset == NEW)
+    {
+        quirks |= QUIRK_JUMP_OFFSET_NEW;
+    }
+
+    if (emulator->config.instructionStoreLoadMemory == OLD)
+    {
+        quirks |= QUIRK_STORE_LOAD_MEMORY_OLD;
+    }
+
+    emulator->dispatch = dispatchVariants [quirks];
+}
+
+void dispatchInstruction (uint16_t instruction, chip8 emulator)
+{
+    emulator->dispatch (instruction, emulator);
+}
@@ -0,0 +1,472 @@
+#include "metrics.h"
+
+#include "counters.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#define HAVE_UNIX_SOCKETS
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Avoids SIGPIPE when a client hangs up before reading everything, where the platform allows it per call
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+struct member
+{
+    chip8 emulator;
+    uint32_t group;
+};
+
+struct crisp8Metrics_s
+{
+    struct member* members;
+    uint32_t numMembers;
+    uint32_t memberCapacity;
+
+    char** groups;
+    uint32_t numGroups;
+    uint32_t groupCapacity;
+
+    int socket;
+};
+
+// A metric and where its value is found in struct crisp8Counters
+struct metric
+{
+    const char* name;
+    const char* help;
+    const char* type;
+    size_t offset;
+    bool is8Bit;
+};
+
+static const struct metric metricList [] = {
+    { "crisp8_instructions_total", "Instructions executed.", "counter",
+      offsetof (struct crisp8Counters, instructions), false },
+    { "crisp8_frames_total", "60 Hz frames of emulated time.", "counter",
+      offsetof (struct crisp8Counters, frames), false },
+    { "crisp8_draws_total", "Sprites drawn.", "counter",
+      offsetof (struct crisp8Counters, draws), false },
+    { "crisp8_pixels_flipped_total", "Pixels flipped by sprites, per plane.", "counter",
+      offsetof (struct crisp8Counters, pixelsFlipped), false },
+    { "crisp8_collisions_total", "Sprites that turned off a pixel.", "counter",
+      offsetof (struct crisp8Counters, collisions), false },
+    { "crisp8_idle_cycles_total", "Cycles spent on a jump to itself.", "counter",
+      offsetof (struct crisp8Counters, idleCycles), false },
+    { "crisp8_key_wait_cycles_total", "Cycles spent waiting for a key.", "counter",
+      offsetof (struct crisp8Counters, keyWaitCycles), false },
+    { "crisp8_faults_total", "Faults recorded.", "counter",
+      offsetof (struct crisp8Counters, faults), false },
+    { "crisp8_fused_instructions_total", "Instructions run as part of a fused operation.", "counter",
+      offsetof (struct crisp8Counters, fusedInstructions), false },
+    { "crisp8_stack_high_water", "Deepest the stack has been.", "gauge",
+      offsetof (struct crisp8Counters, stackHighWater), true }
+};
+
+#define NUM_METRICS (sizeof (metricList) / sizeof (metricList [0]))
+
+// Reads a metric out of a counters struct
+//
+// Parameters:
+//  counters: the counters
+//  metric: the metric to read
+static uint64_t metricValue (const struct crisp8Counters* counters, const struct metric* metric)
+{
+    const uint8_t* field = (const uint8_t*)counters + metric->offset;
+    if (metric->is8Bit)
+    {
+        return *field;
+    }
+
+    uint64_t value;
+    memcpy (&value, field, sizeof (value));
+    return value;
+}
+
+// Writes a group name as a label value, escaped the way the text format wants
+//
+// Parameters:
+//  file: the stream to write to
+//  name: the group name
+static void writeLabel (FILE* file, const char* name)
+{
+    for (; *name; name++)
+    {
+        switch (*name)
+        {
+            case '\\':
+                fputs ("\\\\", file);
+                break;
+            case '"':
+                fputs ("\\\"", file);
+                break;
+            case '\n':
+                fputs ("\\n", file);
+                break;
+            default:
+                fputc (*name, file);
+                break;
+        }
+    }
+}
+
+int8_t crisp8MetricsCreate (crisp8Metrics* metrics)
+{
+    *metrics = calloc (1, sizeof (**metrics));
+    if (!(*metrics))
+    {
+        return -1;
+    }
+
+    (*metrics)->socket = -1;
+    return 0;
+}
+
+void crisp8MetricsDestroy (crisp8Metrics* metrics)
+{
+#ifdef HAVE_UNIX_SOCKETS
+    if ((*metrics)->socket >= 0)
+    {
+        close ((*metrics)->socket);
+    }
+#endif
+
+    for (uint32_t i = 0; i < (*metrics)->numGroups; i++)
+    {
+        free ((*metrics)->groups [i]);
+    }
+
+    free ((*metrics)->groups);
+    free ((*metrics)->members);
+    free (*metrics);
+    *metrics = NULL;
+}
+
+// Finds a group by name, adding it if it doesn't exist yet
+//
+// Parameters:
+//  metrics: the collection
+//  name: the name of the group
+//
+// Return value:
+//  The index of the group, or negative if memory could not be allocated
+static int64_t findGroup (crisp8Metrics metrics, const char* name)
+{
+    for (uint32_t i = 0; i < metrics->numGroups; i++)
+    {
+        if (strcmp (metrics->groups [i], name) == 0)
+        {
+            return i;
+        }
+    }
+
+    if (metrics->numGroups == metrics->groupCapacity)
+    {
+        uint32_t capacity = metrics->groupCapacity ? metrics->groupCapacity * 2 : 16;
+        char** groups = realloc (metrics->groups, capacity * sizeof (*groups));
+        if (!groups)
+        {
+            return -1;
+        }
+
+        metrics->groups = groups;
+        metrics->groupCapacity = capacity;
+    }
+
+    char* copy = malloc (strlen (name) + 1);
+    if (!copy)
+    {
+        return -1;
+    }
+
+    strcpy (copy, name);
+    metrics->groups [metrics->numGroups] = copy;
+    return metrics->numGroups++;
+}
+
+int8_t crisp8MetricsAdd (crisp8Metrics metrics, chip8 emulator, const char* group)
+{
+    int64_t index = findGroup (metrics, group);
+    if (index < 0)
+    {
+        return -1;
+    }
+
+    if (metrics->numMembers == metrics->memberCapacity)
+    {
+        uint32_t capacity = metrics->memberCapacity ? metrics->memberCapacity * 2 : 64;
+        struct member* members = realloc (metrics->members, capacity * sizeof (*members));
+        if (!members)
+        {
+            return -1;
+        }
+
+        metrics->members = members;
+        metrics->memberCapacity = capacity;
+    }
+
+    metrics->members [metrics->numMembers].emulator = emulator;
+    metrics->members [metrics->numMembers].group = index;
+    metrics->numMembers++;
+
+    return 0;
+}
+
+void crisp8MetricsRemove (crisp8Metrics metrics, chip8 emulator)
+{
+    for (uint32_t i = 0; i < metrics->numMembers; i++)
+    {
+        if (metrics->members [i].emulator == emulator)
+        {
+            // The order of the members doesn't matter, so the last one fills the hole
+            metrics->members [i] = metrics->members [--metrics->numMembers];
+            return;
+        }
+    }
+}
+
+int8_t crisp8MetricsWrite (crisp8Metrics metrics, FILE* file)
+{
+    struct crisp8Counters* totals = calloc (metrics->numGroups ? metrics->numGroups : 1, sizeof (*totals));
+    if (!totals)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < metrics->numMembers; i++)
+    {
+        struct crisp8Counters counters;
+        crisp8CountersGet (metrics->members [i].emulator, &counters);
+
+        struct crisp8Counters* total = &totals [metrics->members [i].group];
+        total->instructions += counters.instructions;
+        total->frames += counters.frames;
+        total->draws += counters.draws;
+        total->pixelsFlipped += counters.pixelsFlipped;
+        total->collisions += counters.collisions;
+        total->idleCycles += counters.idleCycles;
+        total->keyWaitCycles += counters.keyWaitCycles;
+        total->faults += counters.faults;
+        total->fusedInstructions += counters.fusedInstructions;
+
+        if (counters.stackHighWater > total->stackHighWater)
+        {
+            total->stackHighWater = counters.stackHighWater;
+        }
+    }
+
+    // Groups whose emulators were all removed are left out
+    uint32_t* groupSizes = calloc (metrics->numGroups ? metrics->numGroups : 1, sizeof (*groupSizes));
+    if (!groupSizes)
+    {
+        free (totals);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < metrics->numMembers; i++)
+    {
+        groupSizes [metrics->members [i].group]++;
+    }
+
+    fputs ("# HELP crisp8_emulators Emulators being counted.\n# TYPE crisp8_emulators gauge\n", file);
+    for (uint32_t group = 0; group < metrics->numGroups; group++)
+    {
+        if (groupSizes [group])
+        {
+            fputs ("crisp8_emulators{emulator=\"", file);
+            writeLabel (file, metrics->groups [group]);
+            fprintf (file, "\"} %u\n", groupSizes [group]);
+        }
+    }
+
+    for (size_t i = 0; i < NUM_METRICS; i++)
+    {
+        const struct metric* metric = &metricList [i];
+        fprintf (file, "# HELP %s %s\n# TYPE %s %s\n", metric->name, metric->help, metric->name, metric->type);
+
+        for (uint32_t group = 0; group < metrics->numGroups; group++)
+        {
+            if (groupSizes [group])
+            {
+                fprintf (file, "%s{emulator=\"", metric->name);
+                writeLabel (file, metrics->groups [group]);
+                fprintf (file, "\"} %llu\n", (unsigned long long)metricValue (&totals [group], metric));
+            }
+        }
+    }
+
+    free (groupSizes);
+    free (totals);
+
+    return ferror (file) ? -1 : 0;
+}
+
+int8_t crisp8MetricsWriteFile (crisp8Metrics metrics, const char* path)
+{
+    char* temporaryPath = malloc (strlen (path) + sizeof (".tmp"));
+    if (!temporaryPath)
+    {
+        return -1;
+    }
+
+    strcpy (temporaryPath, path);
+    strcat (temporaryPath, ".tmp");
+
+    FILE* file = fopen (temporaryPath, "w");
+    if (!file)
+    {
+        free (temporaryPath);
+        return -1;
+    }
+
+    int8_t result = crisp8MetricsWrite (metrics, file);
+    if (fclose (file) != 0)
+    {
+        result = -1;
+    }
+
+    if (result == 0 && rename (temporaryPath, path) != 0)
+    {
+        result = -1;
+    }
+
+    if (result < 0)
+    {
+        remove (temporaryPath);
+    }
+
+    free (temporaryPath);
+    return result;
+}
+
+#ifdef HAVE_UNIX_SOCKETS
+int8_t crisp8MetricsListen (crisp8Metrics metrics, const char* path)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen (path) >= sizeof (address.sun_path) || metrics->socket >= 0)
+    {
+        return -1;
+    }
+
+    strcpy (address.sun_path, path);
+
+    int listener = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        return -1;
+    }
+
+    // Serving must never wait for a client to show up
+    unlink (path);
+    if (bind (listener, (struct sockaddr*)&address, sizeof (address)) < 0 || listen (listener, 16) < 0 ||
+        fcntl (listener, F_SETFL, fcntl (listener, F_GETFL) | O_NONBLOCK) < 0)
+    {
+        close (listener);
+        return -1;
+    }
+
+    metrics->socket = listener;
+    return 0;
+}
+
+int32_t crisp8MetricsServe (crisp8Metrics metrics)
+{
+    if (metrics->socket < 0)
+    {
+        return -1;
+    }
+
+    // The metrics are only rendered if somebody asked for them
+    char* text = NULL;
+    size_t size = 0;
+    int32_t served = 0;
+
+    for (;;)
+    {
+        int client = accept (metrics->socket, NULL, NULL);
+        if (client < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        // Accepted sockets don't inherit O_NONBLOCK on every system, and a client that doesn't read must never hold up
+        // the emulators once the socket buffer is full
+        if (fcntl (client, F_SETFL, fcntl (client, F_GETFL) | O_NONBLOCK) < 0)
+        {
+            close (client);
+            continue;
+        }
+
+        if (!text)
+        {
+            FILE* stream = open_memstream (&text, &size);
+            if (!stream || crisp8MetricsWrite (metrics, stream) < 0)
+            {
+                if (stream)
+                {
+                    fclose (stream);
+                }
+
+                free (text);
+                text = NULL;
+                close (client);
+                break;
+            }
+
+            fclose (stream);
+        }
+
+        size_t sent = 0;
+        while (sent < size)
+        {
+            ssize_t result = send (client, text + sent, size - sent, SEND_FLAGS);
+            if (result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            // Clients that would block are dropped with what they got so far
+            if (result <= 0)
+            {
+                break;
+            }
+
+            sent += result;
+        }
+
+        close (client);
+        served += sent == size;
+    }
+
+    free (text);
+    return served;
+}
+#else
+int8_t crisp8MetricsListen (crisp8Metrics metrics, const char* path)
+{
+    return -1;
+}
+
+int32_t crisp8MetricsServe (crisp8Metrics metrics)
+{
+    return -1;
+}
+#endif
@@ -0,0 +1,123 @@
+#include "realtime.h"
+
+#include "realtime_private.h"
+
+#include <string.h>
+
+#ifdef CRISP8_HAVE_CLOCK_NANOSLEEP
+#include <errno.h>
+
+uint64_t crisp8RealtimeNow (void)
+{
+    struct timespec time;
+    clock_gettime (CLOCK_MONOTONIC, &time);
+
+    return (uint64_t)time.tv_sec * CRISP8_NS_PER_SECOND + time.tv_nsec;
+}
+
+void crisp8RealtimeSleepUntil (uint64_t deadline)
+{
+    struct timespec time;
+    time.tv_sec = deadline / CRISP8_NS_PER_SECOND;
+    time.tv_nsec = deadline % CRISP8_NS_PER_SECOND;
+
+    // Being woken by a signal doesn't move an absolute deadline, so the sleep can simply be restarted
+    while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &time, NULL) == EINTR)
+    {
+    }
+}
+
+int8_t crisp8RunRealtime (chip8 emulator, uint32_t ipf, uint16_t hz, crisp8FrameCallback callback, void* userdata,
+                          struct crisp8RealtimeStats* stats)
+{
+    if (ipf == 0 || hz == 0 || (uint64_t)ipf * hz > UINT16_MAX)
+    {
+        return -1;
+    }
+
+    crisp8SetFramerate (emulator, ipf * hz);
+
+    struct crisp8RealtimeStats result;
+    memset (&result, 0, sizeof (result));
+
+    uint64_t period = CRISP8_NS_PER_SECOND / hz;
+    uint64_t origin = crisp8RealtimeNow ();
+    uint64_t deadlineFrame = 0;
+    uint64_t deadline = origin;
+    uint64_t jitterTotal = 0;
+    uint64_t onTimeFrames = 0;
+
+    for (;;)
+    {
+        uint64_t start = crisp8RealtimeNow ();
+
+        enum crisp8StopReason reason = crisp8RunCycles (emulator, ipf, &result.stop);
+        result.frames++;
+
+        bool keepRunning = reason == CRISP8_STOP_CYCLES && !crisp8HasExited (emulator);
+        if (callback && !callback (emulator, userdata))
+        {
+            keepRunning = false;
+        }
+
+        uint64_t end = crisp8RealtimeNow ();
+        if (end - start > result.workMaxNs)
+        {
+            result.workMaxNs = end - start;
+        }
+
+        if (!keepRunning)
+        {
+            break;
+        }
+
+        // Deadlines are worked out from the first one, so rounding errors and late wakeups don't add up
+        deadline = crisp8RealtimeDeadline (origin, ++deadlineFrame, hz);
+
+        if (end > deadline)
+        {
+            result.overruns++;
+
+            // More than a frame behind: give up on the lost frames instead of rushing through them
+            if (end - deadline > period)
+            {
+                uint64_t behind = (end - deadline) / period;
+                result.skippedFrames += behind;
+                deadlineFrame += behind;
+                deadline = crisp8RealtimeDeadline (origin, deadlineFrame, hz);
+            }
+
+            continue;
+        }
+
+        crisp8RealtimeSleepUntil (deadline);
+
+        uint64_t lateness = crisp8RealtimeNow () - deadline;
+        jitterTotal += lateness;
+        onTimeFrames++;
+
+        if (lateness > result.jitterMaxNs)
+        {
+            result.jitterMaxNs = lateness;
+        }
+    }
+
+    if (onTimeFrames > 0)
+    {
+        result.jitterMeanNs = jitterTotal / onTimeFrames;
+    }
+
+    if (stats)
+    {
+        *stats = result;
+    }
+
+    return 0;
+}
+#else
+int8_t crisp8RunRealtime (chip8 emulator, uint32_t ipf, uint16_t hz, crisp8FrameCallback callback, void* userdata,
+                          struct crisp8RealtimeStats* stats)
+{
+    return -1;
+}
+#endif
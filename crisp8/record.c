@@ -0,0 +1,414 @@
+#include "record.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Every byte of a frame stored as a literal, plus a control byte per 128 of them
+#define MAX_ENCODED_SIZE (CRISP8_RECORDING_FRAME_SIZE + CRISP8_RECORDING_FRAME_SIZE / 128)
+
+#define FRAME_WORDS (CRISP8_RECORDING_FRAME_SIZE / 8)
+
+struct crisp8Recorder_s
+{
+    FILE* file;
+    uint32_t keyframeInterval;
+    uint64_t frameCount;
+    uint64_t size;
+
+    uint64_t previous [FRAME_WORDS];
+    uint8_t encoded [MAX_ENCODED_SIZE];
+};
+
+// Where a keyframe is in the recording
+struct keyframe
+{
+    uint64_t frameNumber;
+    long offset;
+};
+
+struct crisp8RecordingReader_s
+{
+    FILE* file;
+    struct crisp8RecordingHeader header;
+
+    // The last decoded frame and the number of the next one
+    uint64_t frame [FRAME_WORDS];
+    uint64_t frameNumber;
+
+    // The keyframes found so far, and how far the frame headers have been looked at
+    struct keyframe* keyframes;
+    uint64_t numKeyframes;
+    uint64_t keyframeCapacity;
+    uint64_t framesScanned;
+    long scanOffset;
+
+    uint8_t encoded [MAX_ENCODED_SIZE];
+};
+
+// Run length encodes a frame
+//
+// Parameters:
+//  data: the frame or delta to encode
+//  size: the size of data
+//  encoded: the buffer to encode into. It must be able to hold MAX_ENCODED_SIZE bytes
+//
+// Return value:
+//  The size of the encoded data
+static uint32_t encode (const uint8_t* data, uint32_t size, uint8_t* encoded)
+{
+    uint32_t in = 0;
+    uint32_t out = 0;
+
+    while (in < size)
+    {
+        uint32_t length = 0;
+
+        if (data [in] == 0)
+        {
+            while (in + length < size && length < 128 && data [in + length] == 0)
+            {
+                length++;
+            }
+
+            encoded [out++] = length - 1;
+        }
+        else
+        {
+            // A lone zero is cheaper to keep in a literal than to end the literal for
+            while (in + length < size && length < 128 &&
+                   (data [in + length] != 0 || (in + length + 1 < size && data [in + length + 1] != 0)))
+            {
+                length++;
+            }
+
+            encoded [out++] = 0x80 | (length - 1);
+            memcpy (encoded + out, data + in, length);
+            out += length;
+        }
+
+        in += length;
+    }
+
+    return out;
+}
+
+// Decodes run length encoded data
+//
+// Parameters:
+//  encoded: the encoded data
+//  encodedSize: the size of the encoded data
+//  data: the buffer to decode into
+//  size: the exact size the decoded data must have
+//
+// Return value:
+//  False if the encoded data is damaged
+static bool decode (const uint8_t* encoded, uint32_t encodedSize, uint8_t* data, uint32_t size)
+{
+    uint32_t in = 0;
+    uint32_t out = 0;
+
+    while (in < encodedSize)
+    {
+        uint8_t control = encoded [in++];
+        uint32_t length = (control & 0x7F) + 1;
+
+        if (out + length > size)
+        {
+            return false;
+        }
+
+        if (control & 0x80)
+        {
+            if (in + length > encodedSize)
+            {
+                return false;
+            }
+
+            memcpy (data + out, encoded + in, length);
+            in += length;
+        }
+        else
+        {
+            memset (data + out, 0, length);
+        }
+
+        out += length;
+    }
+
+    return out == size;
+}
+
+int8_t crisp8RecorderOpen (crisp8Recorder* recorder, FILE* file, uint32_t keyframeInterval)
+{
+    *recorder = calloc (1, sizeof (**recorder));
+    if (!(*recorder))
+    {
+        return -1;
+    }
+
+    struct crisp8RecordingHeader header;
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, CRISP8_RECORDING_MAGIC, sizeof (CRISP8_RECORDING_MAGIC));
+    header.version = CRISP8_RECORDING_VERSION;
+    header.frameSize = CRISP8_RECORDING_FRAME_SIZE;
+    header.keyframeInterval = keyframeInterval;
+    header.byteOrderMark = 0x0102;
+
+    if (fwrite (&header, sizeof (header), 1, file) != 1)
+    {
+        free (*recorder);
+        *recorder = NULL;
+        return -1;
+    }
+
+    (*recorder)->file = file;
+    (*recorder)->keyframeInterval = keyframeInterval;
+    (*recorder)->size = sizeof (header);
+
+    return 0;
+}
+
+int8_t crisp8RecorderCapture (crisp8Recorder recorder, chip8 emulator)
+{
+    const uint64_t* current = crisp8GetPackedFramebuffer (emulator);
+
+    struct crisp8RecordingFrameHeader header;
+    memset (&header, 0, sizeof (header));
+    header.width = crisp8GetDisplayWidth (emulator);
+    header.height = crisp8GetDisplayHeight (emulator);
+
+    bool keyframe = recorder->frameCount == 0 ||
+                    (recorder->keyframeInterval && recorder->frameCount % recorder->keyframeInterval == 0);
+
+    if (keyframe)
+    {
+        header.type = CRISP8_RECORDING_KEYFRAME;
+        header.size = encode ((const uint8_t*)current, CRISP8_RECORDING_FRAME_SIZE, recorder->encoded);
+    }
+    else
+    {
+        // The XOR is worked out in place of the previous frame, which gets replaced by the current one below anyway
+        uint64_t changed = 0;
+        for (int i = 0; i < FRAME_WORDS; i++)
+        {
+            recorder->previous [i] ^= current [i];
+            changed |= recorder->previous [i];
+        }
+
+        header.type = CRISP8_RECORDING_DELTA;
+        header.size = changed ? encode ((const uint8_t*)recorder->previous, CRISP8_RECORDING_FRAME_SIZE,
+                                        recorder->encoded) : 0;
+    }
+
+    memcpy (recorder->previous, current, sizeof (recorder->previous));
+    recorder->frameCount++;
+
+    if (fwrite (&header, sizeof (header), 1, recorder->file) != 1 ||
+        (header.size && fwrite (recorder->encoded, header.size, 1, recorder->file) != 1))
+    {
+        return -1;
+    }
+
+    recorder->size += sizeof (header) + header.size;
+
+    return 0;
+}
+
+uint64_t crisp8RecorderGetSize (crisp8Recorder recorder)
+{
+    return recorder->size;
+}
+
+void crisp8RecorderClose (crisp8Recorder* recorder)
+{
+    fflush ((*recorder)->file);
+    free (*recorder);
+    *recorder = NULL;
+}
+
+int8_t crisp8RecordingOpen (crisp8RecordingReader* reader, FILE* file)
+{
+    *reader = calloc (1, sizeof (**reader));
+    if (!(*reader))
+    {
+        return -1;
+    }
+
+    struct crisp8RecordingHeader* header = &(*reader)->header;
+    if (fread (header, sizeof (*header), 1, file) != 1 ||
+        memcmp (header->magic, CRISP8_RECORDING_MAGIC, sizeof (CRISP8_RECORDING_MAGIC)) != 0 ||
+        header->version != CRISP8_RECORDING_VERSION || header->frameSize != CRISP8_RECORDING_FRAME_SIZE ||
+        header->byteOrderMark != 0x0102)
+    {
+        free (*reader);
+        *reader = NULL;
+        return -1;
+    }
+
+    (*reader)->file = file;
+    (*reader)->scanOffset = ftell (file);
+
+    return 0;
+}
+
+// Remembers where a keyframe is
+//
+// Parameters:
+//  reader: the reader
+//  frameNumber: the number of the keyframe
+//  offset: the position of its header in the stream
+//
+// Return value:
+//  False if memory could not be allocated
+static bool addKeyframe (crisp8RecordingReader reader, uint64_t frameNumber, long offset)
+{
+    if (reader->numKeyframes == reader->keyframeCapacity)
+    {
+        uint64_t capacity = reader->keyframeCapacity ? reader->keyframeCapacity * 2 : 64;
+        struct keyframe* keyframes = realloc (reader->keyframes, capacity * sizeof (*keyframes));
+        if (!keyframes)
+        {
+            return false;
+        }
+
+        reader->keyframes = keyframes;
+        reader->keyframeCapacity = capacity;
+    }
+
+    reader->keyframes [reader->numKeyframes].frameNumber = frameNumber;
+    reader->keyframes [reader->numKeyframes].offset = offset;
+    reader->numKeyframes++;
+
+    return true;
+}
+
+// Reads the header of the next frame, keeping track of keyframes the first time a frame is seen
+//
+// Parameters:
+//  reader: the reader
+//  header: filled in with the header
+//
+// Return value:
+//  False at the end of the recording or if it's damaged
+static bool readFrameHeader (crisp8RecordingReader reader, struct crisp8RecordingFrameHeader* header)
+{
+    long offset = ftell (reader->file);
+
+    if (fread (header, sizeof (*header), 1, reader->file) != 1 || header->size > MAX_ENCODED_SIZE)
+    {
+        return false;
+    }
+
+    if (reader->frameNumber == reader->framesScanned)
+    {
+        if (header->type == CRISP8_RECORDING_KEYFRAME && !addKeyframe (reader, reader->frameNumber, offset))
+        {
+            return false;
+        }
+
+        reader->framesScanned++;
+        reader->scanOffset = offset + sizeof (*header) + header->size;
+    }
+
+    return true;
+}
+
+bool crisp8RecordingRead (crisp8RecordingReader reader, uint64_t* frame, uint8_t* width, uint8_t* height)
+{
+    struct crisp8RecordingFrameHeader header;
+    if (!readFrameHeader (reader, &header) ||
+        (header.size && fread (reader->encoded, header.size, 1, reader->file) != 1))
+    {
+        return false;
+    }
+
+    if (header.type == CRISP8_RECORDING_KEYFRAME)
+    {
+        if (!decode (reader->encoded, header.size, (uint8_t*)reader->frame, CRISP8_RECORDING_FRAME_SIZE))
+        {
+            return false;
+        }
+    }
+    else if (header.size)
+    {
+        uint64_t delta [FRAME_WORDS];
+        if (!decode (reader->encoded, header.size, (uint8_t*)delta, CRISP8_RECORDING_FRAME_SIZE))
+        {
+            return false;
+        }
+
+        for (int i = 0; i < FRAME_WORDS; i++)
+        {
+            reader->frame [i] ^= delta [i];
+        }
+    }
+
+    reader->frameNumber++;
+
+    memcpy (frame, reader->frame, CRISP8_RECORDING_FRAME_SIZE);
+    *width = header.width;
+    *height = header.height;
+
+    return true;
+}
+
+int8_t crisp8RecordingSeek (crisp8RecordingReader reader, uint64_t frameNumber)
+{
+    // Find the frame by skipping over the headers of frames that haven't been seen yet
+    if (fseek (reader->file, reader->scanOffset, SEEK_SET) != 0)
+    {
+        return -1;
+    }
+
+    reader->frameNumber = reader->framesScanned;
+    while (reader->framesScanned <= frameNumber)
+    {
+        struct crisp8RecordingFrameHeader header;
+        if (!readFrameHeader (reader, &header) || fseek (reader->file, header.size, SEEK_CUR) != 0)
+        {
+            return -1;
+        }
+
+        reader->frameNumber++;
+    }
+
+    // The first frame is always a keyframe, so there is one at or before every frame of an undamaged recording
+    if (reader->numKeyframes == 0 || reader->keyframes [0].frameNumber != 0)
+    {
+        return -1;
+    }
+
+    uint64_t keyframe = reader->numKeyframes - 1;
+    while (reader->keyframes [keyframe].frameNumber > frameNumber)
+    {
+        keyframe--;
+    }
+
+    if (fseek (reader->file, reader->keyframes [keyframe].offset, SEEK_SET) != 0)
+    {
+        return -1;
+    }
+
+    // Decode up to the frame before the one asked for
+    reader->frameNumber = reader->keyframes [keyframe].frameNumber;
+    while (reader->frameNumber < frameNumber)
+    {
+        uint8_t width;
+        uint8_t height;
+        uint64_t frame [FRAME_WORDS];
+
+        if (!crisp8RecordingRead (reader, frame, &width, &height))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void crisp8RecordingClose (crisp8RecordingReader* reader)
+{
+    free ((*reader)->keyframes);
+    free (*reader);
+    *reader = NULL;
+}
@@ -0,0 +1,330 @@
+#include "render.h"
+
+#include "defs.h"
+
+#include <stdalign.h>
+#include <string.h>
+
+// Define CRISP8_RENDER_SCALAR to leave out the vector kernels
+#if !defined(CRISP8_RENDER_SCALAR) && \
+    (defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)))
+#define RENDER_SSE2
+#include <emmintrin.h>
+
+// AVX2 kernels are compiled for that instruction set on their own and only used if the processor has it
+#if defined(__GNUC__) || defined(__clang__)
+#define RENDER_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+// Lines are expanded with whole vector stores, which may write up to a vector past the end of the line
+#define LINE_SLACK 16
+#define MAX_LINE_PIXELS (CRISP8_DISPLAY_HIRES_WIDTH * CRISP8_RENDER_MAX_SCALE + LINE_SLACK)
+
+// Expands a line of color indices into colors, repeating each color scale times
+typedef void (*expandFunction) (const uint32_t* colors, const uint8_t* indices, int count, int scale, void* line);
+
+// Converts a 0xRRGGBBAA color to the output format
+//
+// Parameters:
+//  format: the output format
+//  color: the color
+static uint32_t convertColor (enum crisp8PixelFormat format, uint32_t color)
+{
+    if (format == CRISP8_PIXEL_RGB565)
+    {
+        uint32_t red = color >> 24;
+        uint32_t green = (color >> 16) & 0xFF;
+        uint32_t blue = (color >> 8) & 0xFF;
+
+        return ((red >> 3) << 11) | ((green >> 2) << 5) | (blue >> 3);
+    }
+
+    return color;
+}
+
+// Mixes two 0xRRGGBBAA colors channel by channel
+//
+// Parameters:
+//  from: the color at amount 0
+//  to: the color at amount 255
+//  amount: how far to go from one to the other
+static uint32_t blendColors (uint32_t from, uint32_t to, uint8_t amount)
+{
+    uint32_t result = 0;
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t a = (from >> shift) & 0xFF;
+        uint32_t b = (to >> shift) & 0xFF;
+        result |= ((a * (255 - amount) + b * amount + 127) / 255) << shift;
+    }
+
+    return result;
+}
+
+// Darkens a 0xRRGGBBAA color for scanlines, keeping its alpha
+//
+// Parameters:
+//  color: the color
+//  brightness: the brightness of the scanline, 255 keeps the color as it is
+static uint32_t dimColor (uint32_t color, uint8_t brightness)
+{
+    return (blendColors (color & 0xFFFFFF00, color, brightness) & 0xFFFFFF00) | (color & 0xFF);
+}
+
+void crisp8RendererInit (struct crisp8Renderer* renderer, enum crisp8PixelFormat format, const uint32_t palette [4],
+                         enum crisp8RenderMapping mapping, uint8_t scanlineBrightness)
+{
+    renderer->format = format;
+    renderer->scanlines = scanlineBrightness < 255;
+
+    for (int value = 0; value < 256; value++)
+    {
+        uint32_t color;
+
+        if (mapping == CRISP8_RENDER_INDEXED)
+        {
+            color = palette [value & 3];
+        }
+        else if (mapping == CRISP8_RENDER_FADE_ALPHA && format == CRISP8_PIXEL_RGBA8888)
+        {
+            color = (palette [1] & 0xFFFFFF00) | (((palette [1] & 0xFF) * value + 127) / 255);
+        }
+        else
+        {
+            color = blendColors (palette [0], palette [1], value);
+        }
+
+        renderer->colors [0][value] = convertColor (format, color);
+        renderer->colors [1][value] = convertColor (format, dimColor (color, scanlineBrightness));
+    }
+
+    for (int index = 0; index < 4; index++)
+    {
+        renderer->paletteColors [0][index] = convertColor (format, palette [index]);
+        renderer->paletteColors [1][index] = convertColor (format, dimColor (palette [index], scanlineBrightness));
+    }
+}
+
+// Scalar kernels ------------------------------------------------------
+
+#ifndef RENDER_SSE2
+
+static void expandLine32Scalar (const uint32_t* colors, const uint8_t* indices, int count, int scale, void* line)
+{
+    uint32_t* pixel = line;
+
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t color = colors [indices [i]];
+        for (int j = 0; j < scale; j++)
+        {
+            *pixel++ = color;
+        }
+    }
+}
+
+static void expandLine16Scalar (const uint32_t* colors, const uint8_t* indices, int count, int scale, void* line)
+{
+    uint16_t* pixel = line;
+
+    for (int i = 0; i < count; i++)
+    {
+        uint16_t color = colors [indices [i]];
+        for (int j = 0; j < scale; j++)
+        {
+            *pixel++ = color;
+        }
+    }
+}
+
+#endif
+
+// SSE2 kernels --------------------------------------------------------
+
+#ifdef RENDER_SSE2
+// Every color is broadcast into a vector and stored as many times as it takes to cover scale pixels. The stores
+// overlap: the next color overwrites whatever went past the end of this one
+static void expandLine32Sse2 (const uint32_t* colors, const uint8_t* indices, int count, int scale, void* line)
+{
+    uint32_t* pixel = line;
+
+    for (int i = 0; i < count; i++, pixel += scale)
+    {
+        __m128i color = _mm_set1_epi32 (colors [indices [i]]);
+        for (int j = 0; j < scale; j += 4)
+        {
+            _mm_storeu_si128 ((__m128i*)(pixel + j), color);
+        }
+    }
+}
+
+static void expandLine16Sse2 (const uint32_t* colors, const uint8_t* indices, int count, int scale, void* line)
+{
+    uint16_t* pixel = line;
+
+    for (int i = 0; i < count; i++, pixel += scale)
+    {
+        __m128i color = _mm_set1_epi16 (colors [indices [i]]);
+        for (int j = 0; j < scale; j += 8)
+        {
+            _mm_storeu_si128 ((__m128i*)(pixel + j), color);
+        }
+    }
+}
+#endif
+
+// AVX2 kernels --------------------------------------------------------
+
+#ifdef RENDER_AVX2
+__attribute__ ((target ("avx2")))
+static void expandLine32Avx2 (const uint32_t* colors, const uint8_t* indices, int count, int scale, void* line)
+{
+    uint32_t* pixel = line;
+    int i = 0;
+
+    // Without scaling, eight colors are looked up at once
+    if (scale == 1)
+    {
+        for (; i + 8 <= count; i += 8, pixel += 8)
+        {
+            __m256i index = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i*)(indices + i)));
+            _mm256_storeu_si256 ((__m256i*)pixel, _mm256_i32gather_epi32 ((const int*)colors, index, 4));
+        }
+    }
+
+    for (; i < count; i++, pixel += scale)
+    {
+        __m256i color = _mm256_set1_epi32 (colors [indices [i]]);
+        for (int j = 0; j < scale; j += 8)
+        {
+            _mm256_storeu_si256 ((__m256i*)(pixel + j), color);
+        }
+    }
+}
+
+__attribute__ ((target ("avx2")))
+static void expandLine16Avx2 (const uint32_t* colors, const uint8_t* indices, int count, int scale, void* line)
+{
+    uint16_t* pixel = line;
+
+    for (int i = 0; i < count; i++, pixel += scale)
+    {
+        __m256i color = _mm256_set1_epi16 (colors [indices [i]]);
+        for (int j = 0; j < scale; j += 16)
+        {
+            _mm256_storeu_si256 ((__m256i*)(pixel + j), color);
+        }
+    }
+}
+#endif
+
+// Picks the best kernel the processor supports
+//
+// Parameters:
+//  format: the output format
+static expandFunction selectKernel (enum crisp8PixelFormat format)
+{
+#ifdef RENDER_AVX2
+    if (__builtin_cpu_supports ("avx2"))
+    {
+        return format == CRISP8_PIXEL_RGB565 ? expandLine16Avx2 : expandLine32Avx2;
+    }
+#endif
+
+#ifdef RENDER_SSE2
+    return format == CRISP8_PIXEL_RGB565 ? expandLine16Sse2 : expandLine32Sse2;
+#else
+    return format == CRISP8_PIXEL_RGB565 ? expandLine16Scalar : expandLine32Scalar;
+#endif
+}
+
+// Draws one row of the display as scale rows of the surface
+//
+// Parameters:
+//  renderer: the renderer
+//  expand: the kernel
+//  colors: the normal and scanline colors, indexed by the values in indices
+//  indices: the row of the display
+//  width: the width of the display
+//  scale: the scaling factor
+//  surface: the first surface row to draw to
+//  pitch: the distance between surface rows in bytes
+static void renderRow (const struct crisp8Renderer* renderer, expandFunction expand, const uint32_t* colors [2],
+                       const uint8_t* indices, int width, int scale, uint8_t* surface, size_t pitch)
+{
+    // Kept aligned so the vector stores don't straddle cache lines more than they have to
+    alignas (32) uint32_t line [MAX_LINE_PIXELS];
+
+    size_t lineBytes = (size_t)width * scale * (renderer->format == CRISP8_PIXEL_RGB565 ? 2 : 4);
+    bool scanline = renderer->scanlines && scale > 1;
+
+    expand (colors [0], indices, width, scale, line);
+
+    for (int i = 0; i < scale - scanline; i++)
+    {
+        memcpy (surface + i * pitch, line, lineBytes);
+    }
+
+    if (scanline)
+    {
+        expand (colors [1], indices, width, scale, line);
+        memcpy (surface + (scale - 1) * pitch, line, lineBytes);
+    }
+}
+
+int8_t crisp8RenderFramebuffer (const struct crisp8Renderer* renderer, const uint8_t* framebuffer, uint8_t width,
+                                uint8_t height, uint8_t scale, void* surface, size_t pitch)
+{
+    if (scale == 0 || scale > CRISP8_RENDER_MAX_SCALE || width > CRISP8_DISPLAY_HIRES_WIDTH)
+    {
+        return -1;
+    }
+
+    expandFunction expand = selectKernel (renderer->format);
+    const uint32_t* colors [2] = {renderer->colors [0], renderer->colors [1]};
+
+    for (int y = 0; y < height; y++)
+    {
+        renderRow (renderer, expand, colors, framebuffer + y * width, width, scale,
+                   (uint8_t*)surface + (size_t)y * scale * pitch, pitch);
+    }
+
+    return 0;
+}
+
+int8_t crisp8RenderPacked (const struct crisp8Renderer* renderer, const uint64_t* packed, uint8_t width,
+                           uint8_t height, uint8_t scale, void* surface, size_t pitch)
+{
+    if (scale == 0 || scale > CRISP8_RENDER_MAX_SCALE || width > CRISP8_DISPLAY_HIRES_WIDTH ||
+        height > CRISP8_DISPLAY_HIRES_HEIGHT)
+    {
+        return -1;
+    }
+
+    expandFunction expand = selectKernel (renderer->format);
+    const uint32_t* colors [2] = {renderer->paletteColors [0], renderer->paletteColors [1]};
+
+    const size_t planeWords = CRISP8_DISPLAY_HIRES_HEIGHT * CRISP8_DISPLAY_PACKED_ROW_WORDS;
+
+    for (int y = 0; y < height; y++)
+    {
+        // Palette indices of the row, bit N set if the pixel is on in plane N
+        uint8_t indices [CRISP8_DISPLAY_HIRES_WIDTH];
+
+        for (int x = 0; x < width; x++)
+        {
+            size_t word = (size_t)y * CRISP8_DISPLAY_PACKED_ROW_WORDS + x / 64;
+            int bit = 63 - (x % 64);
+
+            indices [x] = ((packed [word] >> bit) & 1) | (((packed [planeWords + word] >> bit) & 1) << 1);
+        }
+
+        renderRow (renderer, expand, colors, indices, width, scale, (uint8_t*)surface + (size_t)y * scale * pitch,
+                   pitch);
+    }
+
+    return 0;
+}
@@ -0,0 +1,337 @@
+#include "rom.h"
+
+#include "rom_private.h"
+#include "crisp8_private.h"
+#include "fusion_private.h"
+#include "hash_private.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// One memory image per possible memory size: 4, 8, 16, 32 and 64 KiB
+#define NUM_IMAGE_SIZES 5
+
+struct crisp8Rom_s
+{
+    const uint8_t* data;
+    uint32_t size;
+    uint64_t hash;
+
+    // The emulator memory images, font and program included. Each is built by the first emulator of that memory size
+    // that attaches
+    _Atomic (uint8_t*) images [NUM_IMAGE_SIZES];
+
+    // The memory hash of each image (see hash_private.h), worked out by the first emulator tracking its state hash that
+    // attaches. 0 until then, which no image hashes to since the font is never all zeros
+    _Atomic uint64_t imageHashes [NUM_IMAGE_SIZES];
+
+    // The static analysis of the program (see analysis.h), made the first time it's asked for
+    _Atomic (crisp8Analysis) analysis;
+
+    // One for the handle returned by crisp8RomOpen plus one per emulator sharing an image
+    _Atomic uint32_t references;
+};
+
+// Returns the index into crisp8Rom_s.images for a memory size
+//
+// Parameters:
+//  memorySize: a valid emulator memory size
+static int imageIndex (uint32_t memorySize)
+{
+    int index = 0;
+    while (((uint32_t)CRISP8_MEMORY_SIZE << index) < memorySize)
+    {
+        index++;
+    }
+
+    return index;
+}
+
+// Hashes the program with 64 bit FNV-1a
+//
+// Parameters:
+//  data: the program
+//  size: the size of the program
+static uint64_t hashProgram (const uint8_t* data, uint32_t size)
+{
+    uint64_t hash = 0xCBF29CE484222325;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        hash ^= data [i];
+        hash *= 0x100000001B3;
+    }
+
+    return hash;
+}
+
+// Unmaps the program and frees the ROM. Called when the last reference is dropped
+//
+// Parameters:
+//  rom: the ROM to free
+static void freeRom (crisp8Rom rom)
+{
+    for (int i = 0; i < NUM_IMAGE_SIZES; i++)
+    {
+        free (atomic_load (&rom->images [i]));
+    }
+
+    crisp8Analysis analysis = atomic_load (&rom->analysis);
+    crisp8AnalysisDestroy (&analysis);
+
+#ifndef _WIN32
+    munmap ((void*)rom->data, rom->size);
+#else
+    free ((void*)rom->data);
+#endif
+
+    free (rom);
+}
+
+// Drops a reference to a ROM, freeing it if it was the last one
+//
+// Parameters:
+//  rom: the ROM
+static void releaseRom (crisp8Rom rom)
+{
+    if (atomic_fetch_sub_explicit (&rom->references, 1, memory_order_acq_rel) == 1)
+    {
+        freeRom (rom);
+    }
+}
+
+// Maps or reads the program file
+//
+// Parameters:
+//  path: the path of the program file
+//  size: set to the size of the file
+//
+// Return value:
+//  The contents of the file or NULL if it could not be read, is empty or too big
+static const uint8_t* readProgram (const char* path, uint32_t* size)
+{
+#ifndef _WIN32
+    int file = open (path, O_RDONLY);
+    if (file < 0)
+    {
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat (file, &info) < 0 || info.st_size <= 0 ||
+        info.st_size > CRISP8_XO_MEMORY_SIZE - CRISP8_PROGRAM_START_ADDRESS)
+    {
+        close (file);
+        return NULL;
+    }
+
+    void* data = mmap (NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close (file);
+
+    if (data == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    *size = info.st_size;
+    return data;
+#else
+    // No mmap here, so the program is simply read once
+    FILE* file = fopen (path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    uint8_t* data = malloc (CRISP8_XO_MEMORY_SIZE - CRISP8_PROGRAM_START_ADDRESS + 1);
+    size_t read = data ? fread (data, 1, CRISP8_XO_MEMORY_SIZE - CRISP8_PROGRAM_START_ADDRESS + 1, file) : 0;
+    fclose (file);
+
+    if (read == 0 || read > CRISP8_XO_MEMORY_SIZE - CRISP8_PROGRAM_START_ADDRESS)
+    {
+        free (data);
+        return NULL;
+    }
+
+    *size = read;
+    return data;
+#endif
+}
+
+int8_t crisp8RomOpen (crisp8Rom* rom, const char* path)
+{
+    *rom = calloc (1, sizeof (**rom));
+    if (!(*rom))
+    {
+        return -1;
+    }
+
+    (*rom)->data = readProgram (path, &(*rom)->size);
+    if (!(*rom)->data)
+    {
+        free (*rom);
+        *rom = NULL;
+        return -1;
+    }
+
+    (*rom)->hash = hashProgram ((*rom)->data, (*rom)->size);
+    atomic_init (&(*rom)->references, 1);
+
+    for (int i = 0; i < NUM_IMAGE_SIZES; i++)
+    {
+        atomic_init (&(*rom)->images [i], NULL);
+        atomic_init (&(*rom)->imageHashes [i], 0);
+    }
+
+    atomic_init (&(*rom)->analysis, NULL);
+
+    return 0;
+}
+
+void crisp8RomClose (crisp8Rom* rom)
+{
+    releaseRom (*rom);
+    *rom = NULL;
+}
+
+uint32_t crisp8RomGetSize (crisp8Rom rom)
+{
+    return rom->size;
+}
+
+const uint8_t* crisp8RomGetData (crisp8Rom rom)
+{
+    return rom->data;
+}
+
+uint64_t crisp8RomGetHash (crisp8Rom rom)
+{
+    return rom->hash;
+}
+
+crisp8Analysis crisp8RomGetAnalysis (crisp8Rom rom)
+{
+    crisp8Analysis analysis = atomic_load_explicit (&rom->analysis, memory_order_acquire);
+    if (analysis)
+    {
+        return analysis;
+    }
+
+    if (crisp8AnalysisCreate (&analysis, rom->data, rom->size, 0) < 0)
+    {
+        return NULL;
+    }
+
+    // Like the images, the first of several threads racing to analyse the program wins
+    crisp8Analysis expected = NULL;
+    if (!atomic_compare_exchange_strong_explicit (&rom->analysis, &expected, analysis, memory_order_acq_rel,
+                                                  memory_order_acquire))
+    {
+        crisp8AnalysisDestroy (&analysis);
+        return expected;
+    }
+
+    return analysis;
+}
+
+// Returns the memory image for a memory size, building it if no emulator of that size has attached yet
+//
+// Parameters:
+//  rom: the ROM
+//  memorySize: the memory size of the attaching emulator
+//
+// Return value:
+//  The image, or NULL if memory could not be allocated
+static const uint8_t* getImage (crisp8Rom rom, uint32_t memorySize)
+{
+    _Atomic (uint8_t*)* slot = &rom->images [imageIndex (memorySize)];
+
+    uint8_t* image = atomic_load_explicit (slot, memory_order_acquire);
+    if (image)
+    {
+        return image;
+    }
+
+    image = calloc (memorySize, 1);
+    if (!image)
+    {
+        return NULL;
+    }
+
+    crisp8LoadFont (image);
+    memcpy (image + CRISP8_PROGRAM_START_ADDRESS, rom->data, rom->size);
+
+    // Several emulators may race to build the image; the first one wins and the others use its image
+    uint8_t* expected = NULL;
+    if (!atomic_compare_exchange_strong_explicit (slot, &expected, image, memory_order_acq_rel, memory_order_acquire))
+    {
+        free (image);
+        return expected;
+    }
+
+    return image;
+}
+
+int8_t crisp8AttachRom (chip8 emulator, crisp8Rom rom)
+{
+    if (rom->size > emulator->memorySize - CRISP8_PROGRAM_START_ADDRESS)
+    {
+        return -1;
+    }
+
+    const uint8_t* image = getImage (rom, emulator->memorySize);
+    if (!image)
+    {
+        return -1;
+    }
+
+    atomic_fetch_add_explicit (&rom->references, 1, memory_order_relaxed);
+    crisp8RomDetach (emulator);
+
+    // The image is never written through this pointer; instructions privatize memory before writing
+    emulator->memory = (uint8_t*)image;
+    emulator->memoryShared = true;
+    emulator->rom = rom;
+    emulator->PC = CRISP8_PROGRAM_START_ADDRESS;
+    crisp8FusionReset (emulator);
+
+    if (emulator->hashing)
+    {
+        _Atomic uint64_t* imageHash = &rom->imageHashes [imageIndex (emulator->memorySize)];
+        emulator->memoryHash = atomic_load_explicit (imageHash, memory_order_relaxed);
+
+        if (emulator->memoryHash == 0)
+        {
+            emulator->memoryHash = crisp8HashMemory (emulator);
+            atomic_store_explicit (imageHash, emulator->memoryHash, memory_order_relaxed);
+        }
+    }
+
+    return 0;
+}
+
+void crisp8RomPrivatizeMemory (chip8 emulator)
+{
+    memcpy (emulator->privateMemory, emulator->memory, emulator->memorySize);
+    crisp8RomDetach (emulator);
+}
+
+void crisp8RomDetach (chip8 emulator)
+{
+    if (emulator->rom)
+    {
+        releaseRom (emulator->rom);
+        emulator->rom = NULL;
+    }
+
+    emulator->memory = emulator->privateMemory;
+    emulator->memoryShared = false;
+}
@@ -0,0 +1,361 @@
+#include "snapshot.h"
+
+#include "crisp8_private.h"
+#include "state_private.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#define HAVE_MAPPED_FILES
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// The slots start one page into the file
+#define HEADER_SIZE 4096
+
+// The latest copy of a slot that hasn't been looked at yet, or of a slot without an intact checkpoint
+#define COPY_UNKNOWN -2
+#define COPY_NONE    -1
+
+// The start of the file
+struct header
+{
+    char magic [8];
+    uint32_t version;
+    // 0x0102 in the byte order of the creator
+    uint16_t byteOrderMark;
+    uint16_t reserved;
+
+    uint32_t slots;
+    uint32_t memorySize;
+    uint64_t stateSize;
+    uint64_t copySize;
+};
+
+// The start of a copy of a slot. The saved state follows it
+struct copy
+{
+    // The number of the checkpoint held by the copy. 0 while the copy is empty or being written
+    _Atomic uint64_t sequence;
+    // The checksum of the saved state and the sequence number
+    uint64_t checksum;
+};
+
+// What this process knows about a slot, so a checkpoint doesn't have to check the copies again
+struct slot
+{
+    uint64_t sequence;
+    int8_t latest;
+};
+
+struct crisp8SnapshotStore_s
+{
+    uint8_t* mapping;
+    size_t mappingSize;
+    // Kept open, since closing it would drop the lock on the file
+    int file;
+
+    uint32_t slots;
+    uint32_t memorySize;
+    size_t stateSize;
+    // The size of a copy, header included, rounded up to whole cache lines so slots used by different threads don't
+    // share any
+    size_t copySize;
+
+    struct slot* slotStates;
+};
+
+// Checksums a saved state together with its sequence number, 8 bytes at a time
+//
+// Parameters:
+//  data: the saved state
+//  size: the size of the saved state
+//  sequence: the sequence number of the checkpoint
+static uint64_t checksum (const uint8_t* data, size_t size, uint64_t sequence)
+{
+    uint64_t hash = 0xCBF29CE484222325 ^ sequence;
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy (&word, data + i, sizeof (word));
+        hash = (hash ^ word) * 0x100000001B3;
+        hash ^= hash >> 29;
+    }
+
+    for (; i < size; i++)
+    {
+        hash = (hash ^ data [i]) * 0x100000001B3;
+    }
+
+    return hash ^ (hash >> 32);
+}
+
+// Returns a copy of a slot
+//
+// Parameters:
+//  store: the store
+//  slot: the slot
+//  which: 0 or 1
+static struct copy* getCopy (crisp8SnapshotStore store, uint32_t slot, int which)
+{
+    return (struct copy*)(store->mapping + HEADER_SIZE + ((size_t)slot * 2 + which) * store->copySize);
+}
+
+// Returns the saved state in a copy
+static uint8_t* copyState (struct copy* copy)
+{
+    return (uint8_t*)(copy + 1);
+}
+
+// Finds the copy of a slot holding its latest intact checkpoint, checking the copies the first time the slot is used
+//
+// Parameters:
+//  store: the store
+//  slot: the slot
+//
+// Return value:
+//  The slot's entry in store->slotStates
+static struct slot* findLatest (crisp8SnapshotStore store, uint32_t slot)
+{
+    struct slot* state = &store->slotStates [slot];
+    if (state->latest != COPY_UNKNOWN)
+    {
+        return state;
+    }
+
+    state->latest = COPY_NONE;
+    state->sequence = 0;
+
+    for (int which = 0; which < 2; which++)
+    {
+        struct copy* copy = getCopy (store, slot, which);
+        uint64_t sequence = atomic_load_explicit (&copy->sequence, memory_order_acquire);
+
+        // A copy a crash interrupted the writing of has either sequence 0 or a checksum that doesn't match
+        if (sequence > state->sequence && copy->checksum == checksum (copyState (copy), store->stateSize, sequence))
+        {
+            state->latest = which;
+            state->sequence = sequence;
+        }
+    }
+
+    return state;
+}
+
+#ifdef HAVE_MAPPED_FILES
+int8_t crisp8SnapshotStoreOpen (crisp8SnapshotStore* store, const char* path, uint32_t slots, uint32_t memorySize)
+{
+    *store = NULL;
+
+    if (slots == 0 || memorySize < CRISP8_MEMORY_SIZE || memorySize > CRISP8_XO_MEMORY_SIZE ||
+        (memorySize & (memorySize - 1)))
+    {
+        return -1;
+    }
+
+    size_t stateSize = crisp8StateSizeForMemory (memorySize);
+    size_t copySize = sizeof (struct copy) + stateSize;
+    copySize = (copySize + CRISP8_CACHE_LINE_SIZE - 1) / CRISP8_CACHE_LINE_SIZE * CRISP8_CACHE_LINE_SIZE;
+    size_t mappingSize = HEADER_SIZE + (size_t)slots * 2 * copySize;
+
+    int file = open (path, O_RDWR | O_CREAT, 0644);
+    if (file < 0)
+    {
+        return -1;
+    }
+
+    // Two stores checkpointing into the same slots would overwrite each other's copies. Unlike fcntl locks, flock locks
+    // also keep a second store in the same process out
+    struct stat status;
+
+    if (flock (file, LOCK_EX | LOCK_NB) != 0 || fstat (file, &status) != 0)
+    {
+        close (file);
+        return -1;
+    }
+
+    // A new file is zeroed, which makes every slot empty
+    if ((status.st_size == 0 && ftruncate (file, mappingSize) != 0) ||
+        (status.st_size != 0 && (size_t)status.st_size != mappingSize))
+    {
+        close (file);
+        return -1;
+    }
+
+    void* mapping = mmap (NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close (file);
+        return -1;
+    }
+
+    // A file without the magic is new, or its creation was interrupted before anything was committed to it
+    struct header* header = mapping;
+    if (header->magic [0] == '\0')
+    {
+        header->version = CRISP8_SNAPSHOT_VERSION;
+        header->byteOrderMark = 0x0102;
+        header->slots = slots;
+        header->memorySize = memorySize;
+        header->stateSize = stateSize;
+        header->copySize = copySize;
+
+        // The magic goes in last, so a header that was only partly written is never taken for a valid one
+        atomic_thread_fence (memory_order_release);
+        memcpy (header->magic, CRISP8_SNAPSHOT_MAGIC, sizeof (CRISP8_SNAPSHOT_MAGIC));
+    }
+    else if (memcmp (header->magic, CRISP8_SNAPSHOT_MAGIC, sizeof (CRISP8_SNAPSHOT_MAGIC)) != 0 ||
+             header->version != CRISP8_SNAPSHOT_VERSION || header->byteOrderMark != 0x0102 || header->slots != slots ||
+             header->memorySize != memorySize || header->stateSize != stateSize || header->copySize != copySize)
+    {
+        munmap (mapping, mappingSize);
+        close (file);
+        return -1;
+    }
+    else
+    {
+        // Restarting usually restores every slot, so start reading the file in now
+        posix_madvise (mapping, mappingSize, POSIX_MADV_WILLNEED);
+    }
+
+    *store = calloc (1, sizeof (**store));
+    struct slot* slotStates = malloc (slots * sizeof (struct slot));
+
+    if (!(*store) || !slotStates)
+    {
+        free (*store);
+        free (slotStates);
+        *store = NULL;
+        munmap (mapping, mappingSize);
+        close (file);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < slots; i++)
+    {
+        slotStates [i] = (struct slot){0, COPY_UNKNOWN};
+    }
+
+    (*store)->mapping = mapping;
+    (*store)->mappingSize = mappingSize;
+    (*store)->file = file;
+    (*store)->slots = slots;
+    (*store)->memorySize = memorySize;
+    (*store)->stateSize = stateSize;
+    (*store)->copySize = copySize;
+    (*store)->slotStates = slotStates;
+
+    return 0;
+}
+
+void crisp8SnapshotStoreClose (crisp8SnapshotStore* store)
+{
+    if (*store)
+    {
+        munmap ((*store)->mapping, (*store)->mappingSize);
+        close ((*store)->file);
+        free ((*store)->slotStates);
+        free (*store);
+        *store = NULL;
+    }
+}
+
+int8_t crisp8SnapshotStoreSync (crisp8SnapshotStore store)
+{
+    return msync (store->mapping, store->mappingSize, MS_SYNC) == 0 ? 0 : -1;
+}
+#else
+int8_t crisp8SnapshotStoreOpen (crisp8SnapshotStore* store, const char* path, uint32_t slots, uint32_t memorySize)
+{
+    *store = NULL;
+    return -1;
+}
+
+void crisp8SnapshotStoreClose (crisp8SnapshotStore* store)
+{
+}
+
+int8_t crisp8SnapshotStoreSync (crisp8SnapshotStore store)
+{
+    return -1;
+}
+#endif
+
+int8_t crisp8SnapshotStoreCommit (crisp8SnapshotStore store, uint32_t slot, chip8 emulator)
+{
+    if (slot >= store->slots || emulator->memorySize != store->memorySize)
+    {
+        return -1;
+    }
+
+    struct slot* state = findLatest (store, slot);
+    int target = state->latest == 0 ? 1 : 0;
+    struct copy* copy = getCopy (store, slot, target);
+    uint64_t sequence = state->sequence + 1;
+
+    // Takes the copy out of use before overwriting it. The release fence keeps the state from being written first
+    atomic_store_explicit (&copy->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence (memory_order_release);
+
+    if (crisp8StateSave (emulator, copyState (copy), store->stateSize) < 0)
+    {
+        // The other copy still holds the latest checkpoint
+        return -1;
+    }
+
+    copy->checksum = checksum (copyState (copy), store->stateSize, sequence);
+    atomic_store_explicit (&copy->sequence, sequence, memory_order_release);
+
+    state->latest = target;
+    state->sequence = sequence;
+
+    return 0;
+}
+
+int8_t crisp8SnapshotStoreRestore (crisp8SnapshotStore store, uint32_t slot, chip8 emulator)
+{
+    if (slot >= store->slots || emulator->memorySize != store->memorySize)
+    {
+        return -1;
+    }
+
+    struct slot* state = findLatest (store, slot);
+    if (state->latest == COPY_NONE)
+    {
+        return -1;
+    }
+
+    return crisp8StateLoad (emulator, copyState (getCopy (store, slot, state->latest)), store->stateSize);
+}
+
+uint64_t crisp8SnapshotStoreGetSequence (crisp8SnapshotStore store, uint32_t slot)
+{
+    return slot < store->slots ? findLatest (store, slot)->sequence : 0;
+}
+
+void crisp8SnapshotStoreClear (crisp8SnapshotStore store, uint32_t slot)
+{
+    if (slot < store->slots)
+    {
+        atomic_store_explicit (&getCopy (store, slot, 0)->sequence, 0, memory_order_release);
+        atomic_store_explicit (&getCopy (store, slot, 1)->sequence, 0, memory_order_release);
+        store->slotStates [slot] = (struct slot){0, COPY_NONE};
+    }
+}
+
+uint32_t crisp8SnapshotStoreGetSlots (crisp8SnapshotStore store)
+{
+    return store->slots;
+}
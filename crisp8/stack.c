@@ -1,17 +1,10 @@
 #include "stack.h"
 
+#include "stack_private.h"
+
 #include <stdlib.h>
 #include <stdio.h>
 
-// This size is viable according to someone on the internet so surely it has to be true
-#define STACK_SIZE 16
-
-struct chip8Stack_s
-{
-    uint16_t stack [STACK_SIZE];
-    uint16_t* stackPtr;
-};
-
 // Increments the stack pointer.
 //
 // Parameters:
@@ -37,6 +30,7 @@ static void decrementStackPtr (chip8Stack stack, int16_t amount)
 void crisp8StackInit (chip8Stack* stack)
 {
     // I don't want to malloc here, but I simply don't know how I would allocate opaque types on the stack.
+    // (The emulator now embeds its stack and only calls crisp8StackReset; this is for stacks used on their own)
     *stack = malloc (sizeof (**stack));
     if (*stack == NULL)
     {
@@ -44,7 +38,12 @@ void crisp8StackInit (chip8Stack* stack)
         abort ();
     }
 
-    (*stack)->stackPtr = (*stack)->stack;
+    crisp8StackReset (*stack);
+}
+
+void crisp8StackReset (chip8Stack stack)
+{
+    stack->stackPtr = stack->stack;
 }
 
 void crisp8StackDestroy (chip8Stack* stack)
@@ -61,7 +60,7 @@ int8_t crisp8StackPush (chip8Stack stack, uint16_t item)
     uint16_t* stackPtr = crisp8StackGetTop (stack);
     uint16_t* basePtr = crisp8StackGetBase (stack);
 
-    if (stackPtr - basePtr == STACK_SIZE)
+    if (stackPtr - basePtr == CRISP8_STACK_SIZE)
     {
         return -1;
     }
@@ -90,7 +89,7 @@ int8_t crisp8StackPop (chip8Stack stack, uint16_t* item)
 
 uint16_t crisp8StackGetSize (chip8Stack stack)
 {
-    return STACK_SIZE;
+    return CRISP8_STACK_SIZE;
 }
 
 uint16_t* crisp8StackGetTop (chip8Stack stack)
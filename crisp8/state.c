@@ -0,0 +1,198 @@
+#include "state.h"
+
+#include "state_private.h"
+#include "crisp8_private.h"
+#include "drawcommands_private.h"
+#include "instructions.h"
+#include "rom_private.h"
+#include "memory_private.h"
+
+#include <string.h>
+
+// Bumped every time savedState changes
+#define STATE_VERSION 2
+
+#define STATE_STACK_SIZE CRISP8_STACK_SIZE
+
+// The part of a saved state before the memory contents
+struct savedState
+{
+    char magic [8];
+    uint32_t version;
+    uint32_t memorySize;
+
+    uint64_t cycleCount;
+
+    uint16_t PC;
+    uint16_t I;
+    uint8_t V [16];
+    uint8_t flagRegisters [16];
+
+    uint16_t stack [STATE_STACK_SIZE];
+    uint16_t stackItems;
+
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    float delayTimerRemainder;
+    float soundTimerRemainder;
+    bool soundPlaying;
+
+    uint8_t displayWidth;
+    uint8_t displayHeight;
+    uint8_t selectedPlanes;
+    bool framebufferDirty;
+    bool exited;
+
+    uint32_t lastKeyState;
+    bool waitingForKey;
+
+    uint64_t randomState;
+
+    struct crisp8Config config;
+
+    uint64_t displayRows [CRISP8_DISPLAY_PLANES][CRISP8_DISPLAY_HIRES_HEIGHT][CRISP8_DISPLAY_PACKED_ROW_WORDS];
+    uint8_t display [CRISP8_DISPLAY_HIRES_WIDTH * CRISP8_DISPLAY_HIRES_HEIGHT];
+};
+
+static const char stateMagic [8] = "C8STATE";
+
+size_t crisp8StateSizeForMemory (uint32_t memorySize)
+{
+    return sizeof (struct savedState) + memorySize;
+}
+
+size_t crisp8StateSize (chip8 emulator)
+{
+    return crisp8StateSizeForMemory (emulator->memorySize);
+}
+
+int8_t crisp8StateSave (chip8 emulator, void* buffer, size_t size)
+{
+    if (size < crisp8StateSize (emulator) || crisp8StackGetSize (&emulator->stack) > STATE_STACK_SIZE)
+    {
+        return -1;
+    }
+
+    // Built on the side and copied in, so the buffer doesn't have to be aligned
+    struct savedState state;
+    memset (&state, 0, sizeof (state));
+
+    memcpy (state.magic, stateMagic, sizeof (state.magic));
+    state.version = STATE_VERSION;
+    state.memorySize = emulator->memorySize;
+
+    state.cycleCount = emulator->cycleCount;
+
+    state.PC = emulator->PC;
+    state.I = emulator->I;
+    memcpy (state.V, emulator->V, sizeof (state.V));
+    memcpy (state.flagRegisters, emulator->flagRegisters, sizeof (state.flagRegisters));
+
+    state.stackItems = crisp8StackGetNumItems (&emulator->stack);
+    memcpy (state.stack, crisp8StackGetBase (&emulator->stack), state.stackItems * sizeof (uint16_t));
+
+    state.delayTimer = emulator->delayTimer;
+    state.soundTimer = emulator->soundTimer;
+    state.delayTimerRemainder = emulator->delayTimerRemainder;
+    state.soundTimerRemainder = emulator->soundTimerRemainder;
+    state.soundPlaying = emulator->soundPlaying;
+
+    state.displayWidth = emulator->displayWidth;
+    state.displayHeight = emulator->displayHeight;
+    state.selectedPlanes = emulator->selectedPlanes;
+    state.framebufferDirty = emulator->framebufferDirty;
+    state.exited = emulator->exited;
+
+    state.lastKeyState = emulator->lastKeyState;
+    state.waitingForKey = emulator->waitingForKey;
+
+    state.randomState = emulator->randomState;
+
+    state.config = emulator->config;
+
+    memcpy (state.displayRows, emulator->displayRows, sizeof (state.displayRows));
+    memcpy (state.display, emulator->display, sizeof (state.display));
+
+    memcpy (buffer, &state, sizeof (state));
+    memcpy ((uint8_t*)buffer + sizeof (state), emulator->memory, emulator->memorySize);
+
+    return 0;
+}
+
+int8_t crisp8StateLoad (chip8 emulator, const void* buffer, size_t size)
+{
+    struct savedState state;
+
+    if (size < sizeof (state))
+    {
+        return -1;
+    }
+
+    memcpy (&state, buffer, sizeof (state));
+
+    if (memcmp (state.magic, stateMagic, sizeof (state.magic)) != 0 || state.version != STATE_VERSION ||
+        state.memorySize != emulator->memorySize || size < crisp8StateSize (emulator) ||
+        state.stackItems > STATE_STACK_SIZE)
+    {
+        return -1;
+    }
+
+    // The whole memory is overwritten, so a shared ROM image can simply be let go of
+    crisp8RomDetach (emulator);
+    memcpy (emulator->memory, (const uint8_t*)buffer + sizeof (state), emulator->memorySize);
+
+    // The performance counters count what this emulator executed, so they must not jump along with the cycle count.
+    // Moving their base by the same amount keeps the instruction and frame counters where they were
+    emulator->counters.baseCycle += state.cycleCount - emulator->cycleCount;
+    emulator->cycleCount = state.cycleCount;
+
+    emulator->PC = state.PC;
+    emulator->I = state.I;
+    memcpy (emulator->V, state.V, sizeof (state.V));
+    memcpy (emulator->flagRegisters, state.flagRegisters, sizeof (state.flagRegisters));
+
+    uint16_t item;
+    while (crisp8StackPop (&emulator->stack, &item) == 0)
+    {
+    }
+
+    for (uint16_t i = 0; i < state.stackItems; i++)
+    {
+        crisp8StackPush (&emulator->stack, state.stack [i]);
+    }
+
+    emulator->delayTimer = state.delayTimer;
+    emulator->soundTimer = state.soundTimer;
+    emulator->delayTimerRemainder = state.delayTimerRemainder;
+    emulator->soundTimerRemainder = state.soundTimerRemainder;
+    emulator->soundPlaying = state.soundPlaying;
+
+    emulator->displayWidth = state.displayWidth;
+    emulator->displayHeight = state.displayHeight;
+    emulator->selectedPlanes = state.selectedPlanes;
+    emulator->framebufferDirty = state.framebufferDirty;
+    emulator->exited = state.exited;
+
+    emulator->lastKeyState = state.lastKeyState;
+    emulator->waitingForKey = state.waitingForKey;
+
+    emulator->randomState = state.randomState;
+
+    // The dispatcher is chosen by the configuration, so it has to follow it
+    emulator->config = state.config;
+    selectDispatchVariant (emulator);
+
+    memcpy (emulator->displayRows, state.displayRows, sizeof (state.displayRows));
+    memcpy (emulator->display, state.display, sizeof (state.display));
+
+    crisp8MemoryReplaced (emulator);
+    crisp8HashDisplayChanged (emulator);
+
+    // The display was replaced wholesale, which no draw command describes
+    if (emulator->drawCommands)
+    {
+        emulator->drawCommands->lost = true;
+    }
+
+    return 0;
+}
@@ -0,0 +1,476 @@
+#include "thread.h"
+
+#include "breakpoint_private.h"
+#include "crisp8_private.h"
+#include "realtime_private.h"
+#include "spsc.h"
+#include "state.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CRISP8_HAVE_CLOCK_NANOSLEEP
+#include <pthread.h>
+
+// Set in crisp8Thread_s.middle when the frame in it hasn't been picked up by the host yet
+#define FRAME_FRESH 0x80
+
+// The events the emulator thread stops its batches for
+#define THREAD_EVENTS (CRISP8_EVENT_BREAKPOINT | CRISP8_EVENT_WATCHPOINT | CRISP8_EVENT_FAULT | CRISP8_EVENT_SOUND | \
+                       CRISP8_EVENT_FRAME)
+
+struct crisp8Thread_s
+{
+    // Host to emulator thread and back
+    struct crisp8Spsc commands;
+    struct crisp8Spsc events;
+
+    // Triple buffered frames. The emulator thread fills frames [back], then swaps it with middle; the host swaps middle
+    // with frames [front] when it's fresh. Nobody ever waits for the other side
+    struct crisp8ThreadFrame frames [3];
+    _Atomic uint8_t middle;
+    uint8_t back;
+    uint8_t front;
+
+    _Atomic bool quit;
+    _Atomic uint64_t eventsDropped;
+
+    pthread_t thread;
+
+    // Everything below is only touched by the emulator thread once it's running
+
+    chip8 emulator;
+    uint32_t ipf;
+    uint16_t hz;
+    bool paused;
+    uint32_t keys;
+    uint64_t frameCount;
+
+    // The state of the emulator when the thread was created, restored before loading a ROM
+    void* resetState;
+};
+
+static void threadAudioCallback (void* userdata)
+{
+    // Sound is reported through events instead
+}
+
+static uint32_t threadInputCallback (void* userdata)
+{
+    return ((crisp8Thread)userdata)->keys;
+}
+
+// Pushes an event to the host, dropping it if the queue is full
+//
+// Parameters:
+//  thread: the runner
+//  event: the event
+static void pushEvent (crisp8Thread thread, struct crisp8ThreadEvent* event)
+{
+    event->frame = thread->frameCount;
+
+    if (!crisp8SpscPush (&thread->events, event))
+    {
+        free (event->state);
+        atomic_fetch_add_explicit (&thread->eventsDropped, 1, memory_order_relaxed);
+    }
+}
+
+// Pushes an event that carries nothing but its type
+//
+// Parameters:
+//  thread: the runner
+//  type: the type of the event
+static void pushSimpleEvent (crisp8Thread thread, enum crisp8ThreadEventType type)
+{
+    struct crisp8ThreadEvent event;
+    memset (&event, 0, sizeof (event));
+    event.type = type;
+
+    pushEvent (thread, &event);
+}
+
+// Copies the framebuffer into the back frame and makes it the one the host picks up next
+//
+// Parameters:
+//  thread: the runner
+static void publishFrame (crisp8Thread thread)
+{
+    struct crisp8ThreadFrame* frame = &thread->frames [thread->back];
+    chip8 emulator = thread->emulator;
+
+    frame->number = thread->frameCount;
+    frame->width = crisp8GetDisplayWidth (emulator);
+    frame->height = crisp8GetDisplayHeight (emulator);
+    memcpy (frame->pixels, crisp8GetFramebuffer (emulator), (size_t)frame->width * frame->height);
+
+    thread->back = atomic_exchange_explicit (&thread->middle, thread->back | FRAME_FRESH, memory_order_acq_rel) &
+                   ~FRAME_FRESH;
+
+    pushSimpleEvent (thread, CRISP8_THREAD_EVENT_FRAME);
+}
+
+// Executes instructions, turning what happens into events
+//
+// Parameters:
+//  thread: the runner
+//  cycles: the number of instructions to execute
+//
+// Return value:
+//  True if the display changed
+static bool runCycles (crisp8Thread thread, uint32_t cycles)
+{
+    chip8 emulator = thread->emulator;
+    bool frameChanged = false;
+
+    while (cycles > 0)
+    {
+        struct crisp8Event result;
+        crisp8RunUntilEvent (emulator, cycles, &result);
+        cycles -= result.cyclesExecuted;
+
+        if (result.events & CRISP8_EVENT_FRAME)
+        {
+            frameChanged = true;
+        }
+
+        if (result.events & CRISP8_EVENT_SOUND)
+        {
+            pushSimpleEvent (thread,
+                             result.soundPlaying ? CRISP8_THREAD_EVENT_SOUND_ON : CRISP8_THREAD_EVENT_SOUND_OFF);
+        }
+
+        if (result.events & CRISP8_EVENT_FAULT)
+        {
+            struct crisp8ThreadEvent event;
+            memset (&event, 0, sizeof (event));
+            event.type = CRISP8_THREAD_EVENT_FAULT;
+
+            while (crisp8FaultPop (emulator, &event.fault))
+            {
+                pushEvent (thread, &event);
+            }
+        }
+
+        if (result.events & (CRISP8_EVENT_BREAKPOINT | CRISP8_EVENT_WATCHPOINT))
+        {
+            struct crisp8ThreadEvent event;
+            memset (&event, 0, sizeof (event));
+            event.type = CRISP8_THREAD_EVENT_STOPPED;
+            event.stop.reason = (result.events & CRISP8_EVENT_BREAKPOINT) ? CRISP8_STOP_BREAKPOINT :
+                                                                            CRISP8_STOP_WATCHPOINT;
+            event.stop.cyclesExecuted = result.cyclesExecuted;
+            event.stop.PC = result.PC;
+            event.stop.watchpoint = -1;
+
+            if (event.stop.reason == CRISP8_STOP_WATCHPOINT)
+            {
+                event.stop.watchpoint = emulator->breakpoints->hitWatchpoint;
+                event.stop.address = emulator->breakpoints->hitAddress;
+                event.stop.accessType = emulator->breakpoints->hitType;
+            }
+
+            thread->paused = true;
+            pushEvent (thread, &event);
+            break;
+        }
+
+        if (crisp8HasExited (emulator))
+        {
+            thread->paused = true;
+            pushSimpleEvent (thread, CRISP8_THREAD_EVENT_EXITED);
+            break;
+        }
+    }
+
+    return frameChanged;
+}
+
+// Carries out a command from the host
+//
+// Parameters:
+//  thread: the runner
+//  command: the command
+//
+// Return value:
+//  True if the display changed
+static bool handleCommand (crisp8Thread thread, struct crisp8Command* command)
+{
+    chip8 emulator = thread->emulator;
+
+    switch (command->type)
+    {
+        case CRISP8_COMMAND_KEYS:
+            thread->keys = command->keys;
+            return false;
+        case CRISP8_COMMAND_PAUSE:
+            thread->paused = true;
+            return false;
+        case CRISP8_COMMAND_RESUME:
+            thread->paused = false;
+            return false;
+        case CRISP8_COMMAND_STEP:
+            return runCycles (thread, command->cycles);
+        case CRISP8_COMMAND_SNAPSHOT:
+        {
+            struct crisp8ThreadEvent event;
+            memset (&event, 0, sizeof (event));
+            event.type = CRISP8_THREAD_EVENT_SNAPSHOT;
+            event.stateSize = crisp8StateSize (emulator);
+            event.state = malloc (event.stateSize);
+
+            // Out of memory is answered with an empty snapshot rather than no answer at all
+            if (!event.state || crisp8StateSave (emulator, event.state, event.stateSize) < 0)
+            {
+                free (event.state);
+                event.state = NULL;
+                event.stateSize = 0;
+            }
+
+            pushEvent (thread, &event);
+            return false;
+        }
+        case CRISP8_COMMAND_RESTORE:
+            crisp8StateLoad (emulator, command->state, command->stateSize);
+            free (command->state);
+            return true;
+        case CRISP8_COMMAND_LOAD_ROM:
+            crisp8StateLoad (emulator, thread->resetState, crisp8StateSize (emulator));
+            crisp8FaultClear (emulator);
+            if (crisp8AttachRom (emulator, command->rom) < 0)
+            {
+                // Running the reset state without a program would only fault, so wait for the host instead
+                thread->paused = true;
+                pushSimpleEvent (thread, CRISP8_THREAD_EVENT_LOAD_FAILED);
+            }
+
+            crisp8RomClose (&command->rom);
+            return true;
+    }
+
+    return false;
+}
+
+// Releases what a command that was never handled owns
+//
+// Parameters:
+//  command: the command
+static void discardCommand (struct crisp8Command* command)
+{
+    if (command->type == CRISP8_COMMAND_LOAD_ROM)
+    {
+        crisp8RomClose (&command->rom);
+    }
+    else if (command->type == CRISP8_COMMAND_RESTORE)
+    {
+        free (command->state);
+    }
+}
+
+// The emulator thread. Runs a frame's worth of instructions per frame and sleeps in between
+//
+// Parameters:
+//  argument: the runner
+static void* threadMain (void* argument)
+{
+    crisp8Thread thread = argument;
+    chip8 emulator = thread->emulator;
+
+    // Only done once the thread is running, so an emulator handed back after a failed crisp8ThreadCreate keeps its own
+    // settings and callbacks
+    crisp8SetFramerate (emulator, thread->ipf * thread->hz);
+    crisp8SetAudioCallbackWithData (emulator, threadAudioCallback, thread);
+    crisp8SetInputCallbackWithData (emulator, threadInputCallback, thread);
+    crisp8SetEventMask (emulator, THREAD_EVENTS);
+
+    uint64_t period = CRISP8_NS_PER_SECOND / thread->hz;
+    uint64_t origin = crisp8RealtimeNow ();
+    uint64_t deadlineFrame = 0;
+
+    publishFrame (thread);
+
+    while (!atomic_load_explicit (&thread->quit, memory_order_acquire))
+    {
+        bool frameChanged = false;
+
+        struct crisp8Command command;
+        while (crisp8SpscPop (&thread->commands, &command))
+        {
+            frameChanged |= handleCommand (thread, &command);
+        }
+
+        if (!thread->paused)
+        {
+            frameChanged |= runCycles (thread, thread->ipf);
+            thread->frameCount++;
+
+#ifdef CRISP8_DISPLAY_USE_ALPHA
+            // Pixels fade every cycle, so the frame changes whenever the emulator runs
+            frameChanged = true;
+#endif
+        }
+
+        if (frameChanged)
+        {
+            publishFrame (thread);
+        }
+
+        // Deadlines are worked out from the frame number so they don't drift. After falling more than a frame behind,
+        // the lost time is given up on and the deadlines start over from now
+        uint64_t deadline = crisp8RealtimeDeadline (origin, ++deadlineFrame, thread->hz);
+
+        uint64_t now = crisp8RealtimeNow ();
+        if (now < deadline)
+        {
+            crisp8RealtimeSleepUntil (deadline);
+        }
+        else if (now - deadline > period)
+        {
+            origin = now;
+            deadlineFrame = 0;
+        }
+    }
+
+    return NULL;
+}
+
+int8_t crisp8ThreadCreate (crisp8Thread* thread, chip8 emulator, uint32_t ipf, uint16_t hz)
+{
+    if (ipf == 0 || hz == 0 || (uint64_t)ipf * hz > UINT16_MAX)
+    {
+        return -1;
+    }
+
+    // The queues want their own cache lines, which plain malloc doesn't promise
+    size_t size = (sizeof (**thread) + 63) & ~(size_t)63;
+    *thread = aligned_alloc (64, size);
+    if (!(*thread))
+    {
+        return -1;
+    }
+
+    memset (*thread, 0, sizeof (**thread));
+
+    (*thread)->resetState = malloc (crisp8StateSize (emulator));
+    if (!(*thread)->resetState || crisp8SpscInit (&(*thread)->commands, CRISP8_THREAD_QUEUE_SIZE,
+                                                  sizeof (struct crisp8Command)) < 0)
+    {
+        free ((*thread)->resetState);
+        free (*thread);
+        *thread = NULL;
+        return -1;
+    }
+
+    if (crisp8SpscInit (&(*thread)->events, CRISP8_THREAD_QUEUE_SIZE, sizeof (struct crisp8ThreadEvent)) < 0)
+    {
+        crisp8SpscDestroy (&(*thread)->commands);
+        free ((*thread)->resetState);
+        free (*thread);
+        *thread = NULL;
+        return -1;
+    }
+
+    crisp8StateSave (emulator, (*thread)->resetState, crisp8StateSize (emulator));
+
+    (*thread)->emulator = emulator;
+    (*thread)->ipf = ipf;
+    (*thread)->hz = hz;
+
+    (*thread)->front = 0;
+    atomic_init (&(*thread)->middle, 1);
+    (*thread)->back = 2;
+    atomic_init (&(*thread)->quit, false);
+    atomic_init (&(*thread)->eventsDropped, 0);
+
+    if (pthread_create (&(*thread)->thread, NULL, threadMain, *thread) != 0)
+    {
+        crisp8SpscDestroy (&(*thread)->events);
+        crisp8SpscDestroy (&(*thread)->commands);
+        free ((*thread)->resetState);
+        free (*thread);
+        *thread = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+void crisp8ThreadDestroy (crisp8Thread* thread)
+{
+    atomic_store_explicit (&(*thread)->quit, true, memory_order_release);
+    pthread_join ((*thread)->thread, NULL);
+
+    struct crisp8Command command;
+    while (crisp8SpscPop (&(*thread)->commands, &command))
+    {
+        discardCommand (&command);
+    }
+
+    struct crisp8ThreadEvent event;
+    while (crisp8SpscPop (&(*thread)->events, &event))
+    {
+        free (event.state);
+    }
+
+    crisp8SpscDestroy (&(*thread)->events);
+    crisp8SpscDestroy (&(*thread)->commands);
+    crisp8Destroy (&(*thread)->emulator);
+    free ((*thread)->resetState);
+    free (*thread);
+    *thread = NULL;
+}
+
+int8_t crisp8ThreadSend (crisp8Thread thread, const struct crisp8Command* command)
+{
+    return crisp8SpscPush (&thread->commands, command) ? 0 : -1;
+}
+
+bool crisp8ThreadPollEvent (crisp8Thread thread, struct crisp8ThreadEvent* event)
+{
+    return crisp8SpscPop (&thread->events, event);
+}
+
+uint64_t crisp8ThreadEventsDropped (crisp8Thread thread)
+{
+    return atomic_load_explicit (&thread->eventsDropped, memory_order_relaxed);
+}
+
+const struct crisp8ThreadFrame* crisp8ThreadGetFrame (crisp8Thread thread)
+{
+    if (atomic_load_explicit (&thread->middle, memory_order_relaxed) & FRAME_FRESH)
+    {
+        thread->front = atomic_exchange_explicit (&thread->middle, thread->front, memory_order_acq_rel) & ~FRAME_FRESH;
+    }
+
+    return &thread->frames [thread->front];
+}
+#else
+int8_t crisp8ThreadCreate (crisp8Thread* thread, chip8 emulator, uint32_t ipf, uint16_t hz)
+{
+    return -1;
+}
+
+void crisp8ThreadDestroy (crisp8Thread* thread)
+{
+}
+
+int8_t crisp8ThreadSend (crisp8Thread thread, const struct crisp8Command* command)
+{
+    return -1;
+}
+
+bool crisp8ThreadPollEvent (crisp8Thread thread, struct crisp8ThreadEvent* event)
+{
+    return false;
+}
+
+uint64_t crisp8ThreadEventsDropped (crisp8Thread thread)
+{
+    return 0;
+}
+
+const struct crisp8ThreadFrame* crisp8ThreadGetFrame (crisp8Thread thread)
+{
+    return NULL;
+}
+#endif
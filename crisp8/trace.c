@@ -0,0 +1,167 @@
+#include "trace.h"
+
+#include "crisp8_private.h"
+#include "trace_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CRISP8_TRACE
+// Rounds a number up to the nearest power of two
+//
+// Parameters:
+//  value: the number to round
+//
+// Return value:
+//  The rounded number, or 0 if it doesn't fit in 32 bits
+static uint32_t roundUpToPowerOfTwo (uint32_t value)
+{
+    uint32_t power = 1;
+    while (power < value && power != 0)
+    {
+        power <<= 1;
+    }
+
+    return power;
+}
+
+int8_t crisp8TraceEnable (chip8 emulator, uint32_t capacity)
+{
+    capacity = roundUpToPowerOfTwo (capacity);
+    if (capacity == 0)
+    {
+        return -1;
+    }
+
+    struct crisp8TraceBuffer* trace = malloc (sizeof (*trace));
+    if (!trace)
+    {
+        return -1;
+    }
+
+    trace->records = malloc (sizeof (*trace->records) * capacity);
+    if (!trace->records)
+    {
+        free (trace);
+        return -1;
+    }
+
+    trace->mask = capacity - 1;
+    atomic_init (&trace->head, 0);
+
+    crisp8TraceDisable (emulator);
+    emulator->trace = trace;
+
+    return 0;
+}
+
+void crisp8TraceDisable (chip8 emulator)
+{
+    if (!emulator->trace)
+    {
+        return;
+    }
+
+    free (emulator->trace->records);
+    free (emulator->trace);
+    emulator->trace = NULL;
+}
+
+uint32_t crisp8TraceRead (chip8 emulator, struct crisp8TraceRecord* records, uint32_t maxRecords)
+{
+    struct crisp8TraceBuffer* trace = emulator->trace;
+    if (!trace || maxRecords == 0)
+    {
+        return 0;
+    }
+
+    uint64_t capacity = (uint64_t)trace->mask + 1;
+    uint64_t head = atomic_load_explicit (&trace->head, memory_order_acquire);
+
+    uint64_t count = head < capacity ? head : capacity;
+    if (count > maxRecords)
+    {
+        count = maxRecords;
+    }
+
+    uint64_t first = head - count;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        records [i] = trace->records [(first + i) & trace->mask];
+    }
+
+    // The writer may have lapped us while we were copying. Every record older than the slot it is currently writing
+    // could be torn, so those are thrown away
+    atomic_thread_fence (memory_order_acquire);
+    uint64_t newHead = atomic_load_explicit (&trace->head, memory_order_relaxed);
+    uint64_t oldestValid = newHead + 1 > capacity ? newHead + 1 - capacity : 0;
+
+    if (first < oldestValid)
+    {
+        uint64_t torn = oldestValid - first;
+        if (torn >= count)
+        {
+            return 0;
+        }
+
+        memmove (records, records + torn, sizeof (*records) * (count - torn));
+        count -= torn;
+    }
+
+    return (uint32_t)count;
+}
+
+int8_t crisp8TraceDump (chip8 emulator, FILE* file)
+{
+    if (!emulator->trace)
+    {
+        return -1;
+    }
+
+    uint32_t capacity = emulator->trace->mask + 1;
+    struct crisp8TraceRecord* records = malloc (sizeof (*records) * capacity);
+    if (!records)
+    {
+        return -1;
+    }
+
+    uint32_t numRecords = crisp8TraceRead (emulator, records, capacity);
+
+    struct crisp8TraceFileHeader header;
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, CRISP8_TRACE_FILE_MAGIC, sizeof (CRISP8_TRACE_FILE_MAGIC));
+    header.version = CRISP8_TRACE_FILE_VERSION;
+    header.recordSize = sizeof (struct crisp8TraceRecord);
+    header.byteOrderMark = 0x0102;
+    header.numRecords = numRecords;
+
+    int8_t result = 0;
+    if (fwrite (&header, sizeof (header), 1, file) != 1 ||
+        fwrite (records, sizeof (*records), numRecords, file) != numRecords)
+    {
+        result = -1;
+    }
+
+    free (records);
+    return result;
+}
+#else
+int8_t crisp8TraceEnable (chip8 emulator, uint32_t capacity)
+{
+    return -1;
+}
+
+void crisp8TraceDisable (chip8 emulator)
+{
+}
+
+uint32_t crisp8TraceRead (chip8 emulator, struct crisp8TraceRecord* records, uint32_t maxRecords)
+{
+    return 0;
+}
+
+int8_t crisp8TraceDump (chip8 emulator, FILE* file)
+{
+    return -1;
+}
+#endif
@@ -0,0 +1,133 @@
+// Runs lots of emulators on several threads at once and checks that every one of them ends up exactly where the same
+// emulator run on its own does. Each emulator gets its keys and counts its beeps through the user data of its
+// callbacks, so nothing is shared between them.
+#include "../include/public/crisp8.h"
+#include "../include/public/state.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_THREADS 8
+#define EMULATORS_PER_THREAD 64
+#define CYCLES 5000
+
+// Everything a single emulator's callbacks need
+struct instance
+{
+    chip8 emulator;
+    uint32_t keys;
+    uint32_t beeps;
+    uint64_t hash;
+};
+
+// A program that keeps drawing at random places, beeping and reading random keys
+static uint8_t program [] = {0xC0, 0x3F,   // Set V0 to a random number between 0 and 0x3F
+                             0xC1, 0x1F,   // Set V1 to a random number between 0 and 0x1F
+                             0xA0, 0x50,   // Point the index register at the font
+                             0xD0, 0x15,   // Draw a character at V0, V1
+                             0x62, 0x02,   // Set V2 to 2
+                             0xF2, 0x18,   // Beep for 2 ticks
+                             0xC4, 0x0F,   // Pick a random key
+                             0xE4, 0x9E,   // Skip the next instruction if it's pressed
+                             0x73, 0x01,   // Count the times it wasn't
+                             0x12, 0x00};  // Start over
+
+static void audioCallback (void* userdata)
+{
+    ((struct instance*)userdata)->beeps++;
+}
+
+static uint32_t inputCallback (void* userdata)
+{
+    // The keys change every time they're looked at, in a way that only depends on the instance
+    struct instance* instance = userdata;
+    instance->keys = instance->keys * 1103515245 + 12345;
+
+    return instance->keys >> 16;
+}
+
+// Runs an emulator seeded with its number and hashes its final state
+static void runInstance (struct instance* instance, uint64_t number)
+{
+    crisp8Init (&instance->emulator);
+    crisp8SetFramerate (instance->emulator, 60);
+    crisp8SetAudioCallbackWithData (instance->emulator, audioCallback, instance);
+    crisp8SetInputCallbackWithData (instance->emulator, inputCallback, instance);
+    crisp8SetRandomSeed (instance->emulator, number);
+    // Nobody looks at the display, so skip fading it every cycle
+    crisp8SetHeadless (instance->emulator, true);
+    instance->keys = number;
+    instance->beeps = 0;
+
+    crisp8InitializeProgram (instance->emulator, program, sizeof (program));
+    crisp8RunCycles (instance->emulator, CYCLES, NULL);
+
+    size_t size = crisp8StateSize (instance->emulator);
+    uint8_t* state = malloc (size);
+    crisp8StateSave (instance->emulator, state, size);
+
+    instance->hash = 0xCBF29CE484222325;
+    for (size_t i = 0; i < size; i++)
+    {
+        instance->hash ^= state [i];
+        instance->hash *= 0x100000001B3;
+    }
+
+    free (state);
+    crisp8Destroy (&instance->emulator);
+}
+
+static struct instance instances [NUM_THREADS][EMULATORS_PER_THREAD];
+
+static void* threadMain (void* argument)
+{
+    struct instance* mine = argument;
+    uint64_t first = (mine - &instances [0][0]);
+
+    for (int i = 0; i < EMULATORS_PER_THREAD; i++)
+    {
+        runInstance (&mine [i], first + i);
+    }
+
+    return NULL;
+}
+
+int main ()
+{
+    pthread_t threads [NUM_THREADS];
+
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        pthread_create (&threads [i], NULL, threadMain, instances [i]);
+    }
+
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        pthread_join (threads [i], NULL);
+    }
+
+    // Now run every emulator again, one at a time, and compare
+    int mismatches = 0;
+    uint64_t beeps = 0;
+    for (int i = 0; i < NUM_THREADS * EMULATORS_PER_THREAD; i++)
+    {
+        struct instance* threaded = &instances [0][0] + i;
+        struct instance alone;
+        runInstance (&alone, i);
+
+        if (alone.hash != threaded->hash || alone.beeps != threaded->beeps)
+        {
+            printf ("Emulator %d differs: %016llX and %u beeps alone, %016llX and %u beeps threaded\n", i,
+                    (unsigned long long)alone.hash, alone.beeps, (unsigned long long)threaded->hash, threaded->beeps);
+            mismatches++;
+        }
+
+        beeps += threaded->beeps;
+    }
+
+    printf ("%d emulators on %d threads, %d cycles each, %llu beeps: %d mismatches\n",
+            NUM_THREADS * EMULATORS_PER_THREAD, NUM_THREADS, CYCLES, (unsigned long long)beeps, mismatches);
+
+    return mismatches ? 1 : 0;
+}
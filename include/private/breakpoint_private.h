@@ -0,0 +1,55 @@
+// Internals of breakpoints and watchpoints
+#ifndef CRISP8_BREAKPOINT_PRIVATE_H
+#define CRISP8_BREAKPOINT_PRIVATE_H
+
+#include "breakpoint.h"
+#include "crisp8_private.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct crisp8Watchpoint
+{
+    uint16_t start;
+    uint16_t end;
+    // 0 if the slot is unused
+    uint8_t type;
+};
+
+// Only allocated while at least one breakpoint or watchpoint is set, so emulators that aren't being debugged only pay
+// for a NULL pointer
+struct crisp8Breakpoints
+{
+    // One bit per address in the largest possible memory
+    uint64_t bitmap [CRISP8_XO_MEMORY_SIZE / 64];
+    uint16_t numBreakpoints;
+
+    struct crisp8Watchpoint watchpoints [CRISP8_MAX_WATCHPOINTS];
+    uint8_t numWatchpoints;
+
+    // Set by crisp8BreakpointCheckAccess when a watchpoint triggers
+    bool watchpointHit;
+    int8_t hitWatchpoint;
+    uint16_t hitAddress;
+    uint8_t hitType;
+};
+
+// Checks if there is a breakpoint at an address. The emulator must have breakpoints allocated
+//
+// Parameters:
+//  breakpoints: the breakpoints of the emulator
+//  address: the address to check
+static inline bool crisp8BreakpointHit (const struct crisp8Breakpoints* breakpoints, uint16_t address)
+{
+    return (breakpoints->bitmap [address / 64] >> (address % 64)) & 1;
+}
+
+// Records a memory access against the watchpoints. This should only be called if emulator->watching is set
+//
+// Parameters:
+//  emulator: the emulator making the access
+//  address: the first accessed address, as the instruction sees it. It's wrapped around the end of memory
+//  length: the number of accessed bytes
+//  type: CRISP8_WATCH_READ or CRISP8_WATCH_WRITE
+void crisp8BreakpointCheckAccess (chip8 emulator, uint16_t address, uint16_t length, enum crisp8WatchType type);
+#endif
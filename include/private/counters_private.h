@@ -0,0 +1,42 @@
+// Internals of the performance counters
+#ifndef CRISP8_COUNTERS_PRIVATE_H
+#define CRISP8_COUNTERS_PRIVATE_H
+
+#include <stdint.h>
+
+// The counters that are incremented as the emulator runs. Instructions and frames are worked out from cycleCount
+struct crisp8CounterBlock
+{
+    uint64_t draws;
+    uint64_t pixelsFlipped;
+    uint64_t collisions;
+    uint64_t idleCycles;
+    uint64_t keyWaitCycles;
+    uint64_t faults;
+    uint64_t fusedInstructions;
+
+    // cycleCount when the counters were last reset, moved along whenever a saved state replaces cycleCount
+    uint64_t baseCycle;
+
+    uint8_t stackHighWater;
+};
+
+// Counts the bits set in a word
+//
+// Parameters:
+//  word: the word
+static inline int crisp8PopCount (uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll (word);
+#else
+    int count = 0;
+    for (; word; word &= word - 1)
+    {
+        count++;
+    }
+
+    return count;
+#endif
+}
+#endif
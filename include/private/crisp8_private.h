@@ -6,62 +6,197 @@
 // it between 0x50 and 0x9F so I'll follow that
 #define CRISP8_FONT_START_ADDRESS 0x50
 
+// The SUPER-CHIP's large font is placed right after the normal one
+#define CRISP8_BIG_FONT_START_ADDRESS 0xA0
+
 // Programs are loaded into memory at adress 0x200 since the chip8 iself originally
 // took up the first 0x1FF bytes of the host computers memory
 #define CRISP8_PROGRAM_START_ADDRESS 0x200
 
+#include <stdalign.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+// The size of a cache line on the machines crisp8 cares about
+#define CRISP8_CACHE_LINE_SIZE 64
+
+// Forces a function to be inlined. Used where inlining turns parameters into constants
+#if defined(__GNUC__) || defined(__clang__)
+#define CRISP8_ALWAYS_INLINE inline __attribute__ ((always_inline))
+#elif defined(_MSC_VER)
+#define CRISP8_ALWAYS_INLINE __forceinline
+#else
+#define CRISP8_ALWAYS_INLINE inline
+#endif
+
 #include "defs.h"
 #include "stack.h"
+#include "stack_private.h"
 #include "config.h"
+#include "fault_private.h"
+#include "counters_private.h"
 
-typedef void (*crisp8AudioCallback) (void);
-typedef uint32_t (*crisp8InputCallback) (void);
-
+#ifdef CRISP8_TRACE
+struct crisp8TraceBuffer;
+#endif
+struct crisp8Breakpoints;
+struct crisp8DrawCommandBuffer;
+struct crisp8Rom_s;
+
+typedef void (*crisp8AudioCallback) (void* userdata);
+typedef uint32_t (*crisp8InputCallback) (void* userdata);
+typedef void (*crisp8LegacyAudioCallback) (void);
+typedef uint32_t (*crisp8LegacyInputCallback) (void);
+typedef void (*crisp8DispatchFunction) (uint16_t instruction, struct chip8_s* emulator);
+
+// The struct is split in two. The hot core at the start holds everything an ordinary instruction touches and fits in a
+// few cache lines, so stepping thousands of emulators round-robin only pulls in those lines (plus the few bytes of
+// memory an instruction reads). The cold part after it holds what only some instructions, the frontend or a debugger
+// need, with the big display blocks last. Program memory is allocated separately.
+//
+// The struct is aligned to a cache line, so it has to be allocated with crisp8AllocateEmulator.
 struct chip8_s
 {
-    // Memory ------------------------
-
-    // I guess these allocations could pose problems on embedded systems
-    uint8_t memory [CRISP8_MEMORY_SIZE];
-    uint8_t display [CRISP8_DISPLAY_WIDTH * CRISP8_DISPLAY_HEIGHT];
-
-    chip8Stack stack;
-
-    // Registers ---------------------
+    // Hot core ----------------------
+
+    // The instruction dispatcher specialized for the current configuration
+    alignas (CRISP8_CACHE_LINE_SIZE) crisp8DispatchFunction dispatch;
+
+    // memory points to privateMemory, or to the read only image of a shared ROM while memoryShared is set (see rom.h).
+    // Instructions have to check memoryShared before writing to memory
+    uint8_t* memory;
+    // memorySize - 1. Every address is and'ed with this, so accesses past the end wrap around instead of leaving memory
+    uint16_t memoryMask;
+    bool memoryShared;
+    // True while at least one watchpoint is set. Memory accessing instructions only check watchpoints if this is set
+    bool watching;
+    // True while the memory and display hashes are kept up to date (see state.h)
+    bool hashing;
 
     uint16_t PC;
     uint16_t I;
     // Using an array allows us to more easily choose registers from opcodes
     uint8_t V [16];
 
-    // Timers ------------------------
-
     uint8_t delayTimer;
     uint8_t soundTimer;
+    // Sound timer state
+    bool soundPlaying;
+    // Set while FX0A is waiting for a key, so the wait is only reported as an event once
+    bool waitingForKey;
 
-    // Non emulator information ------
-
-    // Timer remainder counters (used to make sure they decrement at 60hz)
+    // Timer remainder counters (used to make sure they decrement at 60hz), and how much they grow every cycle
+    // (60 / framerate, worked out when the framerate is set)
     float delayTimerRemainder;
     float soundTimerRemainder;
+    float timerStep;
 
-    // Sound timer state
-    bool soundPlaying;
+    // The enum crisp8EventType bits of the events that happened since the last cycle started, and the ones
+    // crisp8RunUntilEvent stops for
+    uint32_t events;
+    uint32_t eventMask;
+
+    // Last cycles keystate (used to check for key release)
+    uint32_t lastKeyState;
+
+    // Set when a fault is recorded while stopOnFault is set. Batched runs stop when they see it
+    bool faultStop;
+    // Set once the program has executed 00FD (exit)
+    bool exited;
+    // Set when displayRows has changed since the framebuffer was last rebuilt
+    bool framebufferDirty;
+    // Set while the framebuffer isn't faded every cycle (see drawcommands.h)
+    bool headless;
+
+    // The current resolution of the display (changed by the SUPER-CHIP instructions 00FE and 00FF)
+    uint8_t displayWidth;
+    uint8_t displayHeight;
+    // Bitmask of the planes that drawing, clearing and scrolling operate on (XO-CHIP FN01)
+    uint8_t selectedPlanes;
 
-    // Callbacks
+    struct chip8Stack_s stack;
+
+    // Callbacks. The ones set without user data are called through an adapter that gets the emulator as its user data
     crisp8AudioCallback audioCb;
+    void* audioUserdata;
     crisp8InputCallback inputCb;
+    void* inputUserdata;
+
+    // State of the xorshift generator used by CXNN. Never zero
+    uint64_t randomState;
+
+    // The number of cycles executed since the emulator was initialized
+    uint64_t cycleCount;
+
+    // Breakpoints and watchpoints. NULL while none are set
+    struct crisp8Breakpoints* breakpoints;
+
+    // One enum crisp8FusedOperation per address of memory (see fusion.h). NULL while fusion is disabled
+    uint8_t* fusion;
+
+#ifdef CRISP8_TRACE
+    // Execution trace ring buffer. Tracing is disabled while it is NULL
+    struct crisp8TraceBuffer* trace;
+#endif
+
+    // Cold --------------------------
+
+    // Allocated separately with a size chosen at initialization, so XO-CHIP emulators with 64 KiB of memory don't make
+    // the struct any bigger for the ones running classic programs
+    alignas (CRISP8_CACHE_LINE_SIZE) uint8_t* privateMemory;
+    uint32_t memorySize;
+    struct crisp8Rom_s* rom;
 
-    // Framerate
     uint16_t framerate;
 
-    // Configuration for some ambiguous instructions
+    // Configuration for some ambiguous instructions. Instructions don't read it; the dispatcher is specialized for it
     struct crisp8Config config;
 
-    // Last cycles keystate (used to check for key release)
-    uint32_t lastKeyState;
+    crisp8LegacyAudioCallback legacyAudioCb;
+    crisp8LegacyInputCallback legacyInputCb;
+
+    // The SUPER-CHIP's flag registers (FX75/FX85)
+    uint8_t flagRegisters [16];
+
+    // Faults recorded by instructions (see fault.h)
+    struct crisp8FaultQueue faults;
+    bool stopOnFault;
+
+    // The memory and display parts of the state hash. Only up to date while hashing is set
+    uint64_t memoryHash;
+    uint64_t displayHash;
+
+    // Draw commands recorded by the display functions. Recording is disabled while it is NULL
+    struct crisp8DrawCommandBuffer* drawCommands;
+
+    // Performance counters (see counters.h). They get a cache line of their own, since only draws, calls, faults and
+    // some waits touch them
+    alignas (CRISP8_CACHE_LINE_SIZE) struct crisp8CounterBlock counters;
+
+    // The display as one bit per pixel, one set of rows per bitplane. This is what instructions operate on
+    alignas (CRISP8_CACHE_LINE_SIZE)
+    uint64_t displayRows [CRISP8_DISPLAY_PLANES][CRISP8_DISPLAY_HIRES_HEIGHT][CRISP8_DISPLAY_PACKED_ROW_WORDS];
+
+    // The framebuffer handed to the frontend, one byte per pixel with a stride of displayWidth. It's rebuilt from
+    // displayRows when needed (see display.h)
+    alignas (CRISP8_CACHE_LINE_SIZE) uint8_t display [CRISP8_DISPLAY_HIRES_WIDTH * CRISP8_DISPLAY_HIRES_HEIGHT];
 };
+
+// Allocates an uninitialized emulator struct, respecting its alignment
+//
+// Return value:
+//  The struct, or NULL if memory could not be allocated
+struct chip8_s* crisp8AllocateEmulator (void);
+
+// Frees a struct allocated by crisp8AllocateEmulator
+//
+// Parameters:
+//  emulator: the struct to free
+void crisp8FreeEmulator (struct chip8_s* emulator);
+
+// Loads the chip-8 and SUPER-CHIP fonts into memory
+//
+// Parameters:
+//  memory: the memory to load the fonts into
+void crisp8LoadFont (uint8_t* memory);
 #endif
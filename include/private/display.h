@@ -0,0 +1,87 @@
+// Operations on the packed display.
+//
+// The display is stored as one bit per pixel in emulator->displayRows, with CRISP8_DISPLAY_PACKED_ROW_WORDS 64 bit
+// words per row and the leftmost pixel in the most significant bit of the first word. There is one set of rows per
+// XO-CHIP bitplane. In low resolution mode only the first word of the first CRISP8_DISPLAY_HEIGHT rows is used.
+// Instructions only ever touch the packed rows; the byte per pixel framebuffer handed to frontends is rebuilt from them
+// when it's asked for.
+//
+// Clearing, drawing and scrolling only affect the planes selected with FN01 (emulator->selectedPlanes).
+#ifndef CRISP8_DISPLAY_H
+#define CRISP8_DISPLAY_H
+
+#include "crisp8.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Clears the display
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8DisplayClear (chip8 emulator);
+
+// Switches between low and high resolution mode. The display is cleared
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - hires: true for high resolution mode
+void crisp8DisplaySetHires (chip8 emulator, bool hires);
+
+// Xors a sprite onto the display. Sprites wrap around if they start outside of the display, but are clipped at its
+// edges.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - x: the column of the sprite's left edge
+//  - y: the row of the sprite's top edge
+//  - sprite: the sprite data, one byte per row for 8 pixel wide sprites and two bytes per row for 16 pixel wide ones.
+//            If several planes are selected, the data for each plane follows the previous one
+//  - width: 8 or 16
+//  - height: the number of rows in the sprite
+//
+// Return value:
+//  True if any pixel was turned off
+bool crisp8DisplayDrawSprite (chip8 emulator, uint8_t x, uint8_t y, const uint8_t* sprite, uint8_t width,
+                              uint8_t height);
+
+// Scrolls the display down. Rows scrolled in at the top are blank
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - rows: the number of rows to scroll
+void crisp8DisplayScrollDown (chip8 emulator, uint8_t rows);
+
+// Scrolls the display up. Rows scrolled in at the bottom are blank
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - rows: the number of rows to scroll
+void crisp8DisplayScrollUp (chip8 emulator, uint8_t rows);
+
+// Scrolls the display right by 4 pixels
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8DisplayScrollRight (chip8 emulator);
+
+// Scrolls the display left by 4 pixels
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8DisplayScrollLeft (chip8 emulator);
+
+// Brings the byte per pixel framebuffer up to date with the packed rows if they have changed
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8DisplaySyncFramebuffer (chip8 emulator);
+
+#ifdef CRISP8_DISPLAY_USE_ALPHA
+// Decrements the alpha value of pixels that are turned off, to give them an old monitor effect. Called once per cycle
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8DisplayFade (chip8 emulator);
+#endif
+#endif
@@ -0,0 +1,34 @@
+// Internals of the draw command stream
+#ifndef CRISP8_DRAWCOMMANDS_PRIVATE_H
+#define CRISP8_DRAWCOMMANDS_PRIVATE_H
+
+#include "drawcommands.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct crisp8DrawCommandBuffer
+{
+    uint8_t* data;
+    uint32_t size;
+    uint32_t capacity;
+
+    // Set when a command didn't fit or the display was replaced by a saved state
+    bool lost;
+};
+
+// Appends a command to the emulator's command buffer. Must only be called while emulator->drawCommands is set
+//
+// Parameters:
+//  emulator: the recording emulator
+//  type: the kind of command
+//  x: the x field of the command
+//  y: the y field of the command
+//  width: the width of the sprite, or 0
+//  height: the height of the sprite, or 0
+//  collision: the collision result of a sprite
+//  sprite: the sprite data, or NULL
+//  spriteSize: the size of the sprite data
+void crisp8DrawCommandRecord (chip8 emulator, enum crisp8DrawCommandType type, uint8_t x, uint8_t y, uint8_t width,
+                              uint8_t height, bool collision, const uint8_t* sprite, uint8_t spriteSize);
+#endif
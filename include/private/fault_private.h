@@ -0,0 +1,24 @@
+// Internals of the fault queue
+#ifndef CRISP8_FAULT_PRIVATE_H
+#define CRISP8_FAULT_PRIVATE_H
+
+#include "fault.h"
+
+#include <stdint.h>
+
+struct crisp8FaultQueue
+{
+    struct crisp8Fault faults [CRISP8_FAULT_QUEUE_SIZE];
+    uint8_t first;
+    uint8_t count;
+    uint32_t dropped;
+};
+
+// Records a fault for the instruction being executed. It must be called before the instruction changes PC
+//
+// Parameters:
+//  emulator: the faulting emulator
+//  type: the kind of fault
+//  opcode: the faulting instruction
+void crisp8FaultRecord (chip8 emulator, enum crisp8FaultType type, uint16_t opcode);
+#endif
@@ -0,0 +1,77 @@
+// Internals of macro-op fusion. While fusion is enabled, every address in memory has an entry in a table that says
+// which fused operation (if any) starts there. Entries are worked out the first time execution reaches an address and
+// forgotten again when memory close to it is written
+#ifndef CRISP8_FUSION_PRIVATE_H
+#define CRISP8_FUSION_PRIVATE_H
+
+#include "crisp8_private.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// The longest instruction sequence that is fused, in bytes
+#define CRISP8_FUSION_MAX_LENGTH 8
+
+enum crisp8FusedOperation
+{
+    // The address hasn't been looked at yet
+    CRISP8_FUSED_UNKNOWN,
+    // No sequence that can be fused starts at the address
+    CRISP8_FUSED_NONE,
+    // 1NNN jumping to itself
+    CRISP8_FUSED_IDLE,
+    // 6XNN 6YNN ANNN DXYN: positioning and drawing a sprite
+    CRISP8_FUSED_POSITION_DRAW,
+    // 7XNN 3XNN 1NNN, with the jump back to the 7XNN: a counted loop
+    CRISP8_FUSED_COUNTED_LOOP,
+    // FX07 3XNN 1NNN, with the jump back to the FX07: waiting for the delay timer
+    CRISP8_FUSED_TIMER_POLL
+};
+
+// Works out which fused operation starts at an address and stores it in the table
+//
+// Parameters:
+//  emulator: an emulator with fusion enabled
+//  address: the address to look at
+//
+// Return value:
+//  An enum crisp8FusedOperation other than CRISP8_FUSED_UNKNOWN
+uint8_t crisp8FusionAnalyse (chip8 emulator, uint16_t address);
+
+// Returns the fused operation starting at an address
+//
+// Parameters:
+//  emulator: an emulator with fusion enabled
+//  address: the address of the next instruction
+static inline uint8_t crisp8FusionLookup (chip8 emulator, uint16_t address)
+{
+    uint8_t operation = emulator->fusion [address & emulator->memoryMask];
+    return operation != CRISP8_FUSED_UNKNOWN ? operation : crisp8FusionAnalyse (emulator, address);
+}
+
+// Forgets the fused operations that might include a byte of memory that's about to be written
+//
+// Parameters:
+//  emulator: the emulator being written to
+//  address: the address of the byte, already wrapped
+static inline void crisp8FusionInvalidate (chip8 emulator, uint16_t address)
+{
+    if (emulator->fusion)
+    {
+        uint16_t first = address >= CRISP8_FUSION_MAX_LENGTH - 1 ? address - (CRISP8_FUSION_MAX_LENGTH - 1) : 0;
+        memset (emulator->fusion + first, CRISP8_FUSED_UNKNOWN, address - first + 1);
+    }
+}
+
+// Forgets every fused operation, after memory was replaced wholesale
+//
+// Parameters:
+//  emulator: the emulator whose memory was replaced
+static inline void crisp8FusionReset (chip8 emulator)
+{
+    if (emulator->fusion)
+    {
+        memset (emulator->fusion, CRISP8_FUSED_UNKNOWN, emulator->memorySize);
+    }
+}
+#endif
@@ -0,0 +1,88 @@
+// Internals of the state hash. Memory and the display are hashed as the XOR of one value per non zero byte (memory) or
+// word (display), so a write only has to XOR out the value of the old contents and XOR in the new one. The registers
+// are small enough to be hashed when the hash is asked for.
+#ifndef CRISP8_HASH_PRIVATE_H
+#define CRISP8_HASH_PRIVATE_H
+
+#include "crisp8_private.h"
+
+#include <stdint.h>
+
+// Spreads the bits of a value over all 64 bits (the SplitMix64 finalizer)
+//
+// Parameters:
+//  x: the value to mix
+static inline uint64_t crisp8HashMix (uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+// Returns what a byte of memory contributes to the memory hash. Zero bytes contribute nothing
+//
+// Parameters:
+//  address: the address of the byte
+//  value: the byte
+static inline uint64_t crisp8HashMemoryByte (uint16_t address, uint8_t value)
+{
+    return value ? crisp8HashMix (((uint64_t)address << 8) | value) : 0;
+}
+
+// Returns what a word of the packed display contributes to the display hash. Zero words contribute nothing
+//
+// Parameters:
+//  index: the index of the word in displayRows, counting from its first word
+//  word: the word
+static inline uint64_t crisp8HashDisplayWord (uint32_t index, uint64_t word)
+{
+    return word ? crisp8HashMix (word ^ ((uint64_t)(index + 1) * 0x9E3779B97F4A7C15)) : 0;
+}
+
+// Replaces a word of the packed display, keeping the display hash up to date while it's tracked
+//
+// Parameters:
+//  emulator: the emulator to write to
+//  word: the word in displayRows to replace
+//  value: the new contents of the word
+static inline void crisp8HashWriteDisplay (chip8 emulator, uint64_t* word, uint64_t value)
+{
+    if (emulator->hashing && *word != value)
+    {
+        uint32_t index = word - &emulator->displayRows [0][0][0];
+        emulator->displayHash ^= crisp8HashDisplayWord (index, *word) ^ crisp8HashDisplayWord (index, value);
+    }
+
+    *word = value;
+}
+
+// Works out the hash of the whole memory from scratch
+//
+// Parameters:
+//  emulator: the emulator whose memory to hash
+//
+// Return value:
+//  The memory hash
+uint64_t crisp8HashMemory (chip8 emulator);
+
+// Works out the hash of the whole packed display from scratch
+//
+// Parameters:
+//  emulator: the emulator whose display to hash
+//
+// Return value:
+//  The display hash
+uint64_t crisp8HashDisplay (chip8 emulator);
+
+// Recomputes the memory hash after memory was replaced wholesale. Does nothing while the hash isn't tracked
+//
+// Parameters:
+//  emulator: the emulator whose memory changed
+void crisp8HashMemoryChanged (chip8 emulator);
+
+// Recomputes the display hash after the display was replaced or moved around. Does nothing while the hash isn't tracked
+//
+// Parameters:
+//  emulator: the emulator whose display changed
+void crisp8HashDisplayChanged (chip8 emulator);
+#endif
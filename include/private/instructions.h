@@ -12,10 +12,17 @@
 //  The fetched instruction
 uint16_t fetchInstruction (chip8 emulator);
 
-// Decodes and executes an instruction
+// Decodes and executes an instruction using the dispatch variant selected for the emulator's configuration
 //
 // Parameters:
 //  - instruction: the instruction to execute
 //  - emulator: the used chip-8 emulator
 void dispatchInstruction (uint16_t instruction, chip8 emulator);
+
+// Selects the dispatch variant in which the quirks match the emulator's configuration. This has to be called every time
+// the configuration changes
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void selectDispatchVariant (chip8 emulator);
 #endif
@@ -0,0 +1,41 @@
+// Writes to memory that other parts of the emulator keep track of
+#ifndef CRISP8_MEMORY_PRIVATE_H
+#define CRISP8_MEMORY_PRIVATE_H
+
+#include "crisp8_private.h"
+#include "fusion_private.h"
+#include "hash_private.h"
+
+#include <stdint.h>
+
+// Writes a byte of memory for an instruction, keeping the state hash and the fusion table up to date. Memory must not
+// be shared
+//
+// Parameters:
+//  emulator: the emulator to write to
+//  address: the address to write, wrapped around the end of memory
+//  value: the byte to write
+static inline void crisp8WriteMemory (chip8 emulator, uint16_t address, uint8_t value)
+{
+    address &= emulator->memoryMask;
+
+    if (emulator->hashing)
+    {
+        emulator->memoryHash ^= crisp8HashMemoryByte (address, emulator->memory [address]) ^
+                                crisp8HashMemoryByte (address, value);
+    }
+
+    crisp8FusionInvalidate (emulator, address);
+    emulator->memory [address] = value;
+}
+
+// Brings the state hash and the fusion table up to date after memory was replaced wholesale
+//
+// Parameters:
+//  emulator: the emulator whose memory was replaced
+static inline void crisp8MemoryReplaced (chip8 emulator)
+{
+    crisp8HashMemoryChanged (emulator);
+    crisp8FusionReset (emulator);
+}
+#endif
@@ -0,0 +1,40 @@
+// Clock helpers of the realtime runner, shared with the other runners that pace themselves
+#ifndef CRISP8_REALTIME_PRIVATE_H
+#define CRISP8_REALTIME_PRIVATE_H
+
+#include "realtime.h"
+
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0 && defined(TIMER_ABSTIME)
+#define CRISP8_HAVE_CLOCK_NANOSLEEP
+
+#define CRISP8_NS_PER_SECOND 1000000000
+
+// Returns the current time of the monotonic clock in nanoseconds
+uint64_t crisp8RealtimeNow (void);
+
+// Returns the deadline of a frame. Working it out from the frame number instead of adding a period rounded down to
+// whole nanoseconds every frame keeps the deadlines from drifting
+//
+// Parameters:
+//  origin: the deadline of frame 0 in nanoseconds
+//  frame: the frame number
+//  hz: the number of frames per second
+static inline uint64_t crisp8RealtimeDeadline (uint64_t origin, uint64_t frame, uint16_t hz)
+{
+    return origin + frame * CRISP8_NS_PER_SECOND / hz;
+}
+
+// Sleeps until an absolute point in time of the monotonic clock
+//
+// Parameters:
+//  deadline: the time to wake up at in nanoseconds
+void crisp8RealtimeSleepUntil (uint64_t deadline);
+#endif
+#endif
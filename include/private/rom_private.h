@@ -0,0 +1,21 @@
+// Internals of shared ROM images
+#ifndef CRISP8_ROM_PRIVATE_H
+#define CRISP8_ROM_PRIVATE_H
+
+#include "rom.h"
+#include "crisp8_private.h"
+
+// Gives an emulator its own copy of a shared memory image and drops its reference to the ROM. Instructions call this
+// before their first write to memory
+//
+// Parameters:
+//  emulator: an emulator with emulator->memoryShared set
+void crisp8RomPrivatizeMemory (chip8 emulator);
+
+// Drops an emulator's reference to its ROM without copying its memory. The emulator must be given new memory contents
+// right after
+//
+// Parameters:
+//  emulator: the emulator to detach
+void crisp8RomDetach (chip8 emulator);
+#endif
@@ -0,0 +1,109 @@
+// A bounded lock-free queue with a single producer and a single consumer thread. Items of a fixed size are copied in
+// and out. Neither side ever waits: pushing to a full queue and popping from an empty one simply fail.
+//
+// head is only written by the consumer and tail only by the producer. They live on separate cache lines so the two
+// threads don't keep stealing the line from each other.
+#ifndef CRISP8_SPSC_H
+#define CRISP8_SPSC_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct crisp8Spsc
+{
+    alignas (64) _Atomic uint32_t head;
+    alignas (64) _Atomic uint32_t tail;
+
+    alignas (64) uint8_t* items;
+    size_t itemSize;
+    // The capacity minus one. The capacity is a power of two so positions can wrap around freely
+    uint32_t mask;
+};
+
+// Allocates the items of a queue
+//
+// Parameters:
+//  - queue: the queue to initialize
+//  - capacity: the number of items the queue holds. Must be a power of two
+//  - itemSize: the size of an item
+//
+// Return value:
+//  Negative if memory could not be allocated
+static inline int8_t crisp8SpscInit (struct crisp8Spsc* queue, uint32_t capacity, size_t itemSize)
+{
+    queue->items = malloc ((size_t)capacity * itemSize);
+    if (!queue->items)
+    {
+        return -1;
+    }
+
+    queue->itemSize = itemSize;
+    queue->mask = capacity - 1;
+    atomic_init (&queue->head, 0);
+    atomic_init (&queue->tail, 0);
+
+    return 0;
+}
+
+// Frees the items of a queue
+//
+// Parameters:
+//  - queue: the queue to destroy
+static inline void crisp8SpscDestroy (struct crisp8Spsc* queue)
+{
+    free (queue->items);
+    queue->items = NULL;
+}
+
+// Copies an item into the queue. Only call this from the producer thread
+//
+// Parameters:
+//  - queue: the queue
+//  - item: the item to push
+//
+// Return value:
+//  False if the queue was full
+static inline bool crisp8SpscPush (struct crisp8Spsc* queue, const void* item)
+{
+    uint32_t tail = atomic_load_explicit (&queue->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit (&queue->head, memory_order_acquire);
+
+    if (tail - head > queue->mask)
+    {
+        return false;
+    }
+
+    memcpy (queue->items + (size_t)(tail & queue->mask) * queue->itemSize, item, queue->itemSize);
+    atomic_store_explicit (&queue->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+// Copies the oldest item out of the queue. Only call this from the consumer thread
+//
+// Parameters:
+//  - queue: the queue
+//  - item: filled in with the popped item
+//
+// Return value:
+//  False if the queue was empty
+static inline bool crisp8SpscPop (struct crisp8Spsc* queue, void* item)
+{
+    uint32_t head = atomic_load_explicit (&queue->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit (&queue->tail, memory_order_acquire);
+
+    if (head == tail)
+    {
+        return false;
+    }
+
+    memcpy (item, queue->items + (size_t)(head & queue->mask) * queue->itemSize, queue->itemSize);
+    atomic_store_explicit (&queue->head, head + 1, memory_order_release);
+
+    return true;
+}
+#endif
@@ -0,0 +1,23 @@
+// Stack internals. The definition lives here so the emulator can embed its stack instead of pointing to one
+#ifndef CRISP8_STACK_PRIVATE_H
+#define CRISP8_STACK_PRIVATE_H
+
+#include "stack.h"
+
+#include <stdint.h>
+
+// This size is viable according to someone on the internet so surely it has to be true
+#define CRISP8_STACK_SIZE 16
+
+struct chip8Stack_s
+{
+    uint16_t stack [CRISP8_STACK_SIZE];
+    uint16_t* stackPtr;
+};
+
+// Empties a stack. This is all the initialization a stack that isn't allocated by crisp8StackInit needs
+//
+// Parameters:
+//  stack: the stack to empty
+void crisp8StackReset (chip8Stack stack);
+#endif
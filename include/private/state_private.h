@@ -0,0 +1,15 @@
+// Internals of saved states
+#ifndef CRISP8_STATE_PRIVATE_H
+#define CRISP8_STATE_PRIVATE_H
+
+#include "state.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Returns the size of a saved state of an emulator with a memory size, like crisp8StateSize does for an emulator
+//
+// Parameters:
+//  memorySize: the emulator memory size
+size_t crisp8StateSizeForMemory (uint32_t memorySize);
+#endif
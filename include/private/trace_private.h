@@ -0,0 +1,55 @@
+// Internals of the execution tracer
+#ifndef CRISP8_TRACE_PRIVATE_H
+#define CRISP8_TRACE_PRIVATE_H
+
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+struct crisp8TraceBuffer
+{
+    struct crisp8TraceRecord* records;
+
+    // capacity - 1. The capacity is always a power of two so indices can be masked instead of using modulo
+    uint32_t mask;
+
+    // The total number of records ever written. The next record goes to records [head & mask]. It is only written by
+    // the emulator thread, but read by any thread calling crisp8TraceRead
+    _Atomic uint64_t head;
+};
+
+// Appends a record for an executed instruction to the ring buffer
+//
+// Parameters:
+//  trace: the ring buffer to write to
+//  cycle: the number of cycles executed before the instruction
+//  PC: the value of PC before the instruction was fetched
+//  opcode: the executed instruction
+//  I: the value of I after the instruction
+//  previousV: the registers before the instruction
+//  V: the registers after the instruction
+static inline void crisp8TraceWrite (struct crisp8TraceBuffer* trace, uint64_t cycle, uint16_t PC, uint16_t opcode,
+                                     uint16_t I, const uint8_t* previousV, const uint8_t* V)
+{
+    uint64_t head = atomic_load_explicit (&trace->head, memory_order_relaxed);
+    struct crisp8TraceRecord* record = &trace->records [head & trace->mask];
+
+    uint16_t changed = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        changed |= (uint16_t)(previousV [i] != V [i]) << i;
+    }
+
+    record->cycle = cycle;
+    record->PC = PC;
+    record->opcode = opcode;
+    record->I = I;
+    record->changedRegisters = changed;
+    memcpy (record->V, V, sizeof (record->V));
+
+    // Publish the record. Readers use the head to find out which records are complete
+    atomic_store_explicit (&trace->head, head + 1, memory_order_release);
+}
+#endif
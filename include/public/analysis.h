@@ -0,0 +1,186 @@
+// This is the public API of static program analysis. It finds the code a program can reach without running it, by
+// walking the instructions from 0x200 and following jumps (1NNN), calls (2NNN), returns (00EE) and skips, and builds a
+// control flow graph of basic blocks from it. Along the way it tracks the index register through the graph, so it also
+// finds the sprites drawn (DXYN) and the memory read and written (FX33, FX55, FX65 and the XO-CHIP 5XY2 and 5XY3) at
+// addresses that don't depend on input, and flags the code that may be overwritten while it runs.
+//
+// Anything that would need to run the program to know is reported as unknown rather than guessed: computed jumps (BNNN)
+// end their block without successors, and accesses with an unknown index register only set a flag. Code that is only
+// reached through them isn't found.
+//
+// An analysis is immutable once created, so it may be shared between threads. crisp8RomGetAnalysis (see rom.h) creates
+// one per ROM the first time it's asked for.
+#ifndef CRISP8_ANALYSIS_H
+#define CRISP8_ANALYSIS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct crisp8Analysis_s* crisp8Analysis;
+
+// Flags of a basic block
+enum crisp8BlockFlags
+{
+    // The block is the target of a call
+    CRISP8_BLOCK_CALL_TARGET = 1 << 0,
+    // The block ends in a call. Its first successor is the return address, and callTarget is set
+    CRISP8_BLOCK_ENDS_IN_CALL = 1 << 1,
+    // The block ends in a return (00EE)
+    CRISP8_BLOCK_ENDS_IN_RETURN = 1 << 2,
+    // The block ends in a computed jump (BNNN), whose targets aren't known
+    CRISP8_BLOCK_ENDS_IN_COMPUTED_JUMP = 1 << 3,
+    // The block ends in 00FD, or runs off the end of memory
+    CRISP8_BLOCK_ENDS_IN_EXIT = 1 << 4,
+    // Part of the block may be written by the program (see CRISP8_ADDRESS_WRITTEN)
+    CRISP8_BLOCK_WRITTEN = 1 << 5
+};
+
+// A run of instructions that is always executed from the start to the end
+struct crisp8BasicBlock
+{
+    // The address of the first instruction, and the address after the last one
+    uint16_t start;
+    uint16_t end;
+
+    // The blocks execution can go on to: the next instruction, and a jump target or the instruction skipped to
+    uint16_t successors [2];
+    uint8_t numSuccessors;
+
+    // A combination of enum crisp8BlockFlags
+    uint8_t flags;
+
+    // The called subroutine, if the block ends in a call
+    uint16_t callTarget;
+};
+
+// How memory outside the code is used
+enum crisp8DataKind
+{
+    // Sprite data drawn with DXYN
+    CRISP8_DATA_SPRITE,
+    // Read into registers with FX65 or 5XY3
+    CRISP8_DATA_READ,
+    // Written with FX33, FX55 or 5XY2
+    CRISP8_DATA_WRITTEN
+};
+
+// A range of memory accessed at a known address
+struct crisp8DataRegion
+{
+    uint16_t start;
+    uint16_t size;
+    enum crisp8DataKind kind;
+
+    // The address of the instruction making the access
+    uint16_t instruction;
+};
+
+// What the analysis knows about a single address
+enum crisp8AddressFlags
+{
+    // An instruction starts at the address
+    CRISP8_ADDRESS_INSTRUCTION = 1 << 0,
+    // The address is part of an instruction
+    CRISP8_ADDRESS_CODE = 1 << 1,
+    // A basic block starts at the address
+    CRISP8_ADDRESS_BLOCK_START = 1 << 2,
+    // The address is part of a sprite
+    CRISP8_ADDRESS_SPRITE = 1 << 3,
+    // The address is read into registers
+    CRISP8_ADDRESS_READ = 1 << 4,
+    // The address is written
+    CRISP8_ADDRESS_WRITTEN = 1 << 5
+};
+
+// Things about the program as a whole
+enum crisp8AnalysisFlags
+{
+    // The program has computed jumps (BNNN), so some of its code may not have been found
+    CRISP8_ANALYSIS_COMPUTED_JUMPS = 1 << 0,
+    // The program writes memory at addresses the analysis doesn't know, so any of its code may be overwritten
+    CRISP8_ANALYSIS_UNKNOWN_WRITES = 1 << 1,
+    // The program writes to its own code at known addresses
+    CRISP8_ANALYSIS_SELF_MODIFYING = 1 << 2,
+    // The program draws or reads memory at addresses the analysis doesn't know
+    CRISP8_ANALYSIS_UNKNOWN_READS = 1 << 3
+};
+
+// Analyses a program
+//
+// Parameters:
+//  - analysis: a pointer to the analysis being created
+//  - program: the program, as loaded at 0x200
+//  - size: the size of the program in bytes
+//  - memorySize: the size of memory the program runs with, a power of two from CRISP8_MEMORY_SIZE to
+//    CRISP8_XO_MEMORY_SIZE. 0 picks the smallest one the program fits in
+//
+// Return value:
+//  Negative if the program doesn't fit in memory or memory could not be allocated
+int8_t crisp8AnalysisCreate (crisp8Analysis* analysis, const uint8_t* program, uint32_t size, uint32_t memorySize);
+
+// Frees an analysis
+//
+// Parameters:
+//  - analysis: a pointer to the analysis to free
+void crisp8AnalysisDestroy (crisp8Analysis* analysis);
+
+// Returns the basic blocks, ordered by their start addresses
+//
+// Parameters:
+//  - analysis: the analysis
+//  - count: set to the number of blocks
+//
+// Return value:
+//  The blocks
+const struct crisp8BasicBlock* crisp8AnalysisGetBlocks (crisp8Analysis analysis, uint32_t* count);
+
+// Finds the basic block starting at an address
+//
+// Parameters:
+//  - analysis: the analysis
+//  - address: the start address of the block
+//
+// Return value:
+//  The block, or NULL if no block starts at the address
+const struct crisp8BasicBlock* crisp8AnalysisFindBlock (crisp8Analysis analysis, uint16_t address);
+
+// Returns the addresses of the subroutines called with 2NNN, in ascending order
+//
+// Parameters:
+//  - analysis: the analysis
+//  - count: set to the number of subroutines
+//
+// Return value:
+//  The addresses
+const uint16_t* crisp8AnalysisGetCallTargets (crisp8Analysis analysis, uint32_t* count);
+
+// Returns the memory accessed at known addresses, ordered by start address. The same range is listed once per kind of
+// access and instruction making it
+//
+// Parameters:
+//  - analysis: the analysis
+//  - count: set to the number of regions
+//
+// Return value:
+//  The regions
+const struct crisp8DataRegion* crisp8AnalysisGetDataRegions (crisp8Analysis analysis, uint32_t* count);
+
+// Returns what the analysis knows about an address
+//
+// Parameters:
+//  - analysis: the analysis
+//  - address: the address, wrapped around the end of memory
+//
+// Return value:
+//  A combination of enum crisp8AddressFlags
+uint8_t crisp8AnalysisGetAddressFlags (crisp8Analysis analysis, uint16_t address);
+
+// Returns what the analysis found out about the program as a whole
+//
+// Parameters:
+//  - analysis: the analysis
+//
+// Return value:
+//  A combination of enum crisp8AnalysisFlags
+uint32_t crisp8AnalysisGetFlags (crisp8Analysis analysis);
+#endif
@@ -0,0 +1,80 @@
+// This is the public API for breakpoints and watchpoints. Use this in your frontend if you are writing a debugger.
+//
+// Breakpoints and watchpoints only stop the batched run functions (such as crisp8RunCycles). crisp8RunCycle always
+// executes exactly one instruction. As long as no breakpoints or watchpoints are set, the batched run functions use a
+// loop without any checks.
+#ifndef CRISP8_BREAKPOINT_H
+#define CRISP8_BREAKPOINT_H
+
+#include "crisp8.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The maximum number of watchpoints per emulator
+#define CRISP8_MAX_WATCHPOINTS 16
+
+// The kind of memory access a watchpoint triggers on. They may be or'ed together
+enum crisp8WatchType
+{
+    CRISP8_WATCH_READ = 1 << 0,
+    CRISP8_WATCH_WRITE = 1 << 1,
+    CRISP8_WATCH_READ_WRITE = CRISP8_WATCH_READ | CRISP8_WATCH_WRITE
+};
+
+// Sets an execution breakpoint. A batched run stops before executing the instruction at the address, unless it is the
+// first instruction of the run (so that a run can be resumed from a breakpoint).
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - address: the address of the instruction to stop at
+//
+// Return value:
+//  Negative if the address is outside of memory or memory for the breakpoints could not be allocated
+int8_t crisp8BreakpointSet (chip8 emulator, uint16_t address);
+
+// Removes an execution breakpoint. Nothing happens if there is no breakpoint at the address
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - address: the address of the breakpoint
+void crisp8BreakpointClear (chip8 emulator, uint16_t address);
+
+// Checks if there is a breakpoint at an address
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - address: the address to check
+//
+// Return value:
+//  True if there is a breakpoint at the address
+bool crisp8BreakpointIsSet (chip8 emulator, uint16_t address);
+
+// Adds a watchpoint on a range of memory. Accesses are checked in instruction fetches, DXYN, FX33, FX55 and FX65.
+// A batched run stops after the instruction that made the access. Reads and writes through the crisp8Debug struct are
+// not checked.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - start: the first address of the range
+//  - end: the last address of the range (inclusive)
+//  - type: which kind of access to stop on
+//
+// Return value:
+//  The id of the watchpoint, or a negative value if the range is invalid, all CRISP8_MAX_WATCHPOINTS are in use or
+//  memory could not be allocated
+int8_t crisp8WatchpointAdd (chip8 emulator, uint16_t start, uint16_t end, enum crisp8WatchType type);
+
+// Removes a watchpoint
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - id: the id returned by crisp8WatchpointAdd
+void crisp8WatchpointRemove (chip8 emulator, int8_t id);
+
+// Removes all breakpoints and watchpoints
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8BreakpointClearAll (chip8 emulator);
+#endif
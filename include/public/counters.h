@@ -0,0 +1,55 @@
+// This is the public API of the performance counters. Every emulator counts what it spends its cycles on as it runs, at
+// the cost of an increment here and there, so a frontend can see from the outside what a program is doing. metrics.h
+// collects the counters of many emulators and exports them to a monitoring system.
+//
+// Counters must be read on the thread that runs the emulator, or while it isn't running.
+#ifndef CRISP8_COUNTERS_H
+#define CRISP8_COUNTERS_H
+
+#include "crisp8.h"
+
+#include <stdint.h>
+
+struct crisp8Counters
+{
+    // The number of instructions executed
+    uint64_t instructions;
+
+    // The number of 60 Hz frames that have passed in emulated time, worked out from the instructions and the framerate
+    uint64_t frames;
+
+    // The number of sprites drawn (DXYN), the pixels they flipped (counted per plane) and how many of them collided
+    uint64_t draws;
+    uint64_t pixelsFlipped;
+    uint64_t collisions;
+
+    // The number of cycles spent on a jump to itself (1NNN with NNN its own address), the usual way for a program to
+    // wait for the end of time
+    uint64_t idleCycles;
+
+    // The number of cycles spent waiting for a key (FX0A)
+    uint64_t keyWaitCycles;
+
+    // The number of faults recorded (see fault.h), including the ones dropped from the fault queue
+    uint64_t faults;
+
+    // The number of instructions run as part of a fused operation, without being fetched and dispatched (see fusion.h)
+    uint64_t fusedInstructions;
+
+    // The deepest the stack has been
+    uint8_t stackHighWater;
+};
+
+// Reads the counters of an emulator
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - counters: filled in with the counters since the emulator was initialized or the counters were last reset
+void crisp8CountersGet (chip8 emulator, struct crisp8Counters* counters);
+
+// Sets every counter back to zero. The stack high water mark restarts from the current depth of the stack
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8CountersReset (chip8 emulator);
+#endif
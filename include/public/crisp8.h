@@ -3,6 +3,7 @@
 #define CRISP8_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "stack.h"
 
@@ -10,12 +11,27 @@ typedef struct chip8_s* chip8;
 
 // Initialization and deinitialization ---------------------------------
 
-// Performs neccesary initialization of the chip-8 emulator. This must be the first operation performed on a new chip8
+// Performs neccesary initialization of the chip-8 emulator. This must be the first operation performed on a new chip8.
+// It prints a message and aborts the process if memory could not be allocated; use crisp8InitWithMemorySize with
+// CRISP8_MEMORY_SIZE to get an error back instead.
 //
 // Parameters:
 //  - emulator: a pointer to the emulator being initialized
 void crisp8Init (chip8* emulator);
 
+// Like crisp8Init, but lets you choose the size of the emulator's memory. Use CRISP8_XO_MEMORY_SIZE for XO-CHIP
+// programs that need the 64 KiB address space. The memory is allocated separately from the rest of the emulator, so
+// the size doesn't affect emulators running classic programs.
+//
+// Parameters:
+//  - emulator: a pointer to the emulator being initialized
+//  - memorySize: the size of the memory in bytes. It must be a power of two between CRISP8_MEMORY_SIZE and
+//                CRISP8_XO_MEMORY_SIZE
+//
+// Return value:
+//  Negative if the size is invalid or memory could not be allocated. The emulator is not initialized in that case
+int8_t crisp8InitWithMemorySize (chip8* emulator, uint32_t memorySize);
+
 // Frees all memory accociated with the emulator. This must be the last function it's used in
 //
 // Parameters:
@@ -50,14 +66,43 @@ void crisp8SetAudioCallback (chip8 emulator, void (*callback) (void));
 //  - callback: a function pointer to the callback function
 void crisp8SetInputCallback (chip8 emulator, uint32_t (*callback) (void));
 
+// Like crisp8SetAudioCallback, but the callback is handed a pointer of the frontend's choosing. This lets a process
+// running many emulators tell them apart without global lookup tables
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - callback: a function pointer to the callback function
+//  - userdata: passed to every call of the callback
+void crisp8SetAudioCallbackWithData (chip8 emulator, void (*callback) (void* userdata), void* userdata);
+
+// Like crisp8SetInputCallback, but the callback is handed a pointer of the frontend's choosing
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - callback: a function pointer to the callback function
+//  - userdata: passed to every call of the callback
+void crisp8SetInputCallbackWithData (chip8 emulator, uint32_t (*callback) (void* userdata), void* userdata);
+
+// Seeds the emulator's random number generator, which is used by CXNN. Every emulator has its own generator, seeded
+// from the time and its address when it's initialized. Emulators given the same seed produce the same numbers
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - seed: the seed
+void crisp8SetRandomSeed (chip8 emulator, uint64_t seed);
+
 // The chip-8 program resides completely in memory. The frontend is respnsible for doing the file io to read in the
-// program, which is then passed into the backend in the form of an array.
+// program, which is then passed into the backend in the form of an array. If you run many emulators with the same
+// program, look at rom.h instead.
 //
 // Parameters:
 //  - emulator: the used chip-8 emulator
 //  - program: an array of the chip-8 program in raw bytes
 //  - program_size: the size of program
-void crisp8InitializeProgram (chip8 emulator, uint8_t* program, uint16_t program_size);
+//
+// Return value:
+//  Negative if the program doesn't fit in the emulator's memory. Nothing is loaded in that case
+int8_t crisp8InitializeProgram (chip8 emulator, uint8_t* program, uint16_t program_size);
 
 // Program execution ---------------------------------------------------
 
@@ -67,11 +112,122 @@ void crisp8InitializeProgram (chip8 emulator, uint8_t* program, uint16_t program
 //  - emulator: the used chip-8 emulator
 void crisp8RunCycle (chip8 emulator);
 
+// The reason a batched run returned
+enum crisp8StopReason
+{
+    // The requested number of cycles were executed
+    CRISP8_STOP_CYCLES,
+    // The next instruction is at a breakpoint (see breakpoint.h)
+    CRISP8_STOP_BREAKPOINT,
+    // The last executed instruction triggered a watchpoint (see breakpoint.h)
+    CRISP8_STOP_WATCHPOINT,
+    // The last executed instruction faulted and crisp8SetStopOnFault is enabled (see fault.h)
+    CRISP8_STOP_FAULT
+};
+
+// Describes why and where a batched run stopped
+struct crisp8StopInfo
+{
+    enum crisp8StopReason reason;
+
+    // The number of cycles executed by the run
+    uint32_t cyclesExecuted;
+
+    // PC when the run stopped
+    uint16_t PC;
+
+    // For CRISP8_STOP_WATCHPOINT: the id of the watchpoint, the first watched address that was accessed and the kind
+    // of access (an enum crisp8WatchType)
+    int8_t watchpoint;
+    uint16_t address;
+    uint8_t accessType;
+};
+
+// Execute up to a number of cycles. This behaves exactly like calling crisp8RunCycle in a loop, but stops early if a
+// breakpoint or watchpoint triggers, or on faults if the frontend asked for it. When no breakpoints or watchpoints are
+// set, the loop doesn't check for them at all.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - maxCycles: the maximum number of cycles to execute
+//  - info: filled in with details about the stop. May be NULL
+//
+// Return value:
+//  The reason the run stopped
+enum crisp8StopReason crisp8RunCycles (chip8 emulator, uint32_t maxCycles, struct crisp8StopInfo* info);
+
+// Things crisp8RunUntilEvent stops for. The values are bits, so they can be combined into a mask for
+// crisp8SetEventMask. When several happen during the same cycle, crisp8RunUntilEvent returns the one listed first here
+enum crisp8EventType
+{
+    // No event happened before the cycle budget ran out
+    CRISP8_EVENT_NONE = 0,
+    // The next instruction is at a breakpoint (see breakpoint.h)
+    CRISP8_EVENT_BREAKPOINT = 1 << 0,
+    // The last executed instruction triggered a watchpoint (see breakpoint.h)
+    CRISP8_EVENT_WATCHPOINT = 1 << 1,
+    // The last executed instruction faulted (see fault.h)
+    CRISP8_EVENT_FAULT = 1 << 2,
+    // The program started waiting for a key with FX0A. This is reported once per wait, not for every cycle it waits
+    CRISP8_EVENT_KEY_WAIT = 1 << 3,
+    // The sound started or stopped playing
+    CRISP8_EVENT_SOUND = 1 << 4,
+    // The display changed (DXYN, 00E0 and the SUPER-CHIP/XO-CHIP scrolling and resolution instructions)
+    CRISP8_EVENT_FRAME = 1 << 5,
+    // The delay or sound timer was decremented
+    CRISP8_EVENT_TIMER = 1 << 6,
+
+    CRISP8_EVENT_ALL = (1 << 7) - 1
+};
+
+// Describes the event a run stopped for
+struct crisp8Event
+{
+    enum crisp8EventType type;
+
+    // Every event (of any type, masked or not) that happened during the last executed cycle
+    uint32_t events;
+
+    // The number of cycles executed by the run
+    uint32_t cyclesExecuted;
+
+    // PC when the run stopped
+    uint16_t PC;
+
+    // For CRISP8_EVENT_SOUND: true if the sound started playing, false if it stopped
+    bool soundPlaying;
+};
+
+// Execute until something the frontend cares about happens or the cycle budget runs out. This behaves exactly like
+// calling crisp8RunCycle in a loop, so a frontend can run a whole frame's worth of cycles at once and only redraw,
+// start or stop a beep or sleep when it's told to. Like crisp8RunCycles, the first instruction is allowed to be at a
+// breakpoint.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - maxCycles: the maximum number of cycles to execute
+//  - event: filled in with details about the event. May be NULL
+//
+// Return value:
+//  The event the run stopped for, or CRISP8_EVENT_NONE if it executed maxCycles cycles
+enum crisp8EventType crisp8RunUntilEvent (chip8 emulator, uint32_t maxCycles, struct crisp8Event* event);
+
+// Chooses which events crisp8RunUntilEvent stops for. By default it stops for all of them
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - mask: the enum crisp8EventType values to stop for or'ed together
+void crisp8SetEventMask (chip8 emulator, uint32_t mask);
+
 // Returns a pointer to the framebuffer for the frontend to draw to the screen. The returned pointer is technically
-// r/w because we don't want to copy memory, but it should be treated as read only. The framebuffer is 64x32 pixels
-// long, each pixel represented by an 8 bit integer. If the program is compiled with CRISP8_DISPLAY_USE_ALPHA defined,
-// the integers value may be treated as an alpha value for an "old monitor fading effect". Otherwise a value of zero
-// means off and 1 means on.
+// r/w because we don't want to copy memory, but it should be treated as read only. The framebuffer is
+// crisp8GetDisplayWidth x crisp8GetDisplayHeight pixels long (64x32 unless a SUPER-CHIP program switched to high
+// resolution), each pixel represented by an 8 bit integer. If the program is compiled with CRISP8_DISPLAY_USE_ALPHA
+// defined, the integers value may be treated as an alpha value for an "old monitor fading effect". Otherwise a value of
+// zero means off and 1 means on; XO-CHIP programs drawing to the second bitplane produce the values 2 and 3 (bit N is
+// set if the pixel is on in plane N).
+//
+// The framebuffer is brought up to date when this function is called, so call it every time you draw.
 //
 // Parameters:
 //  - emulator: the used chip-8 emulator
@@ -80,6 +236,66 @@ void crisp8RunCycle (chip8 emulator);
 //  A pointer to the emulators framebuffer
 const uint8_t* const crisp8GetFramebuffer (chip8 emulator);
 
+// Returns a pointer to the display as the instructions see it: one bit per pixel, CRISP8_DISPLAY_PACKED_ROW_WORDS 64
+// bit words per row and the leftmost pixel in the most significant bit of a row's first word. Only the first
+// crisp8GetDisplayHeight rows and crisp8GetDisplayWidth bits of each row are part of the display. The
+// CRISP8_DISPLAY_PLANES bitplanes follow each other, each CRISP8_DISPLAY_HIRES_HEIGHT rows long. This is always up to
+// date and is the cheapest way to look at the display.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  A pointer to the first word of the first row
+const uint64_t* crisp8GetPackedFramebuffer (chip8 emulator);
+
+// Makes the emulator headless, for frontends that never show the byte per pixel framebuffer or only look at it now and
+// then. A headless emulator doesn't fade the framebuffer every cycle; crisp8GetFramebuffer still works, but pixels that
+// are turned off disappear at once instead of fading. crisp8DrawCommandsDisable (see drawcommands.h) turns this off.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - headless: true to stop fading the framebuffer
+void crisp8SetHeadless (chip8 emulator, bool headless);
+
+// Returns the current width of the display in pixels. This is CRISP8_DISPLAY_WIDTH, or CRISP8_DISPLAY_HIRES_WIDTH if a
+// SUPER-CHIP program has switched to high resolution mode
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  The width of the display
+uint8_t crisp8GetDisplayWidth (chip8 emulator);
+
+// Returns the current height of the display in pixels. This is CRISP8_DISPLAY_HEIGHT, or CRISP8_DISPLAY_HIRES_HEIGHT if
+// a SUPER-CHIP program has switched to high resolution mode
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  The height of the display
+uint8_t crisp8GetDisplayHeight (chip8 emulator);
+
+// Returns the size of the emulator's memory, as chosen when it was initialized
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  The size of the memory in bytes
+uint32_t crisp8GetMemorySize (chip8 emulator);
+
+// Checks if the program has exited with the SUPER-CHIP instruction 00FD. An exited program keeps executing 00FD
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  True if the program has exited
+bool crisp8HasExited (chip8 emulator);
+
 // Debugging -----------------------------------------------------------
 
 // A struct containing pointers to the chip-8 emulators memory, stack and registers.
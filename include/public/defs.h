@@ -5,10 +5,23 @@
 // The RAM size of the chip-8 in bytes
 #define CRISP8_MEMORY_SIZE 4096
 
+// The RAM size of the XO-CHIP in bytes (see crisp8InitWithMemorySize)
+#define CRISP8_XO_MEMORY_SIZE 65536
+
 // The width and height of the chip-8's display
 #define CRISP8_DISPLAY_WIDTH 64
 #define CRISP8_DISPLAY_HEIGHT 32
 
+// The width and height of the display in the SUPER-CHIP high resolution mode
+#define CRISP8_DISPLAY_HIRES_WIDTH 128
+#define CRISP8_DISPLAY_HIRES_HEIGHT 64
+
+// The number of 64 bit words per row in the packed framebuffer (see crisp8GetPackedFramebuffer)
+#define CRISP8_DISPLAY_PACKED_ROW_WORDS (CRISP8_DISPLAY_HIRES_WIDTH / 64)
+
+// The number of XO-CHIP bitplanes
+#define CRISP8_DISPLAY_PLANES 2
+
 // Helper macros to write your input callback
 #define CRISP8_KEYPAD_0 (1 << 0x0)
 #define CRISP8_KEYPAD_1 (1 << 0x1)
@@ -0,0 +1,43 @@
+// This is the public API of the disassembler. It turns instructions into text the way this emulator decodes them, so
+// instructions it doesn't execute come out as data (DW). Mnemonics follow the common Cowgod style (LD, SE, DRW, ...),
+// with the SUPER-CHIP and XO-CHIP additions (SCD, SCU, SCR, SCL, EXIT, LOW, HIGH, SAVE, LOAD, PLANE and the four byte
+// LD I, long). Nothing here allocates or uses stdio, so whole programs can be streamed into a buffer of any size.
+#ifndef CRISP8_DISASSEMBLE_H
+#define CRISP8_DISASSEMBLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The size of the longest text crisp8Disassemble writes, the terminating null character included
+#define CRISP8_DISASSEMBLY_MAX_TEXT 20
+
+// The size of the longest line crisp8DisassembleRange writes: "ADDR  OPCODE    TEXT\n"
+#define CRISP8_DISASSEMBLY_MAX_LINE (6 + 10 + CRISP8_DISASSEMBLY_MAX_TEXT)
+
+// Disassembles one instruction
+//
+// Parameters:
+//  - code: the instruction's bytes
+//  - size: the number of bytes available at code
+//  - text: gets the null terminated text of the instruction. Must hold CRISP8_DISASSEMBLY_MAX_TEXT characters
+//
+// Return value:
+//  The length of the instruction in bytes: 4 for LD I, long (F000 NNNN), otherwise 2. 0 if size is less than 2
+uint8_t crisp8Disassemble (const uint8_t* code, uint32_t size, char* text);
+
+// Disassembles instructions one after the other into a buffer, a line per instruction with its address and opcode.
+// Only whole lines are written; call again with the rest of the code to carry on where it stopped
+//
+// Parameters:
+//  - code: the instructions
+//  - size: the number of bytes at code
+//  - address: the address of the first instruction
+//  - out: the buffer to write to. The text is not null terminated
+//  - outSize: the size of the buffer. Lines are only written while CRISP8_DISASSEMBLY_MAX_LINE characters fit
+//  - consumed: set to the number of bytes of code that were disassembled
+//
+// Return value:
+//  The number of characters written
+size_t crisp8DisassembleRange (const uint8_t* code, uint32_t size, uint16_t address, char* out, size_t outSize,
+                               uint32_t* consumed);
+#endif
@@ -0,0 +1,109 @@
+// This is the public API of the draw command stream. While it's enabled, every instruction that changes the display
+// (clearing, drawing a sprite, scrolling and changing the resolution) appends a small command to a per emulator buffer.
+// A frontend drains the buffer in batches and sends it to a remote viewer, which replays the commands against its own
+// display with crisp8DrawCommandsReplay. A sprite costs 8 bytes plus its sprite data, instead of a whole frame.
+//
+// The emulator can also be made headless, which stops it from maintaining the byte per pixel framebuffer every cycle.
+// The packed display is still updated, since collisions (VF) depend on it.
+#ifndef CRISP8_DRAWCOMMANDS_H
+#define CRISP8_DRAWCOMMANDS_H
+
+#include "crisp8.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The most sprite data a single command carries: a 16x16 sprite on both XO-CHIP planes
+#define CRISP8_DRAW_COMMAND_MAX_SPRITE_SIZE 64
+
+enum crisp8DrawCommandType
+{
+    // 00E0. Clears the planes
+    CRISP8_DRAW_CLEAR,
+    // DXYN. Xors the sprite data following the command onto the planes at (x, y)
+    CRISP8_DRAW_SPRITE,
+    // 00CN and 00DN. Scrolls the planes down or up by x rows
+    CRISP8_DRAW_SCROLL_DOWN,
+    CRISP8_DRAW_SCROLL_UP,
+    // 00FB and 00FC. Scrolls the planes right or left by 4 pixels
+    CRISP8_DRAW_SCROLL_RIGHT,
+    CRISP8_DRAW_SCROLL_LEFT,
+    // 00FE and 00FF. Switches to low (x = 0) or high (x = 1) resolution, which clears every plane
+    CRISP8_DRAW_RESOLUTION
+};
+
+// A single command in the buffer. Sprite commands are followed by spriteSize bytes of sprite data (one plane after the
+// other, like in memory); every other command has a spriteSize of 0, so the next command starts right after it.
+struct crisp8DrawCommand
+{
+    // An enum crisp8DrawCommandType
+    uint8_t type;
+
+    // The bitmask of the planes the command operates on (XO-CHIP FN01)
+    uint8_t planes;
+
+    // Sprite commands: the position of the sprite (VX and VY). Others: see enum crisp8DrawCommandType
+    uint8_t x;
+    uint8_t y;
+
+    // Sprite commands: the size of the sprite
+    uint8_t width;
+    uint8_t height;
+
+    // Sprite commands: 1 if the sprite turned off a pixel (the value of VF after the draw)
+    uint8_t collision;
+
+    // The number of sprite data bytes following the command
+    uint8_t spriteSize;
+};
+
+// Allocates a command buffer for the emulator and starts recording draw commands. Any previous commands are discarded.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - capacity: the size of the buffer in bytes. At least the size of the largest command
+//  - headless: true to stop fading the framebuffer every cycle. crisp8GetFramebuffer still works, but pixels that
+//    are turned off disappear at once instead of fading
+//
+// Return value:
+//  Negative if the capacity is too small or the buffer could not be allocated
+int8_t crisp8DrawCommandsEnable (chip8 emulator, uint32_t capacity, bool headless);
+
+// Stops recording draw commands, frees the buffer and turns headless mode off
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8DrawCommandsDisable (chip8 emulator);
+
+// Returns the commands recorded since the buffer was last cleared
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - size: set to the size of the commands in bytes
+//  - lost: set to true if commands were lost since the buffer was last cleared, either because the buffer was full or
+//    because a saved state was loaded. A viewer has to resync from crisp8GetPackedFramebuffer before replaying more
+//    commands
+//
+// Return value:
+//  The commands, or NULL if recording is disabled
+const uint8_t* crisp8DrawCommandsGet (chip8 emulator, uint32_t* size, bool* lost);
+
+// Empties the command buffer and resets the lost flag. Call it once the commands returned by crisp8DrawCommandsGet
+// have been sent
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8DrawCommandsClear (chip8 emulator);
+
+// Applies commands to the display of another emulator, which ends up with the same packed display as the recording
+// one. The viewer's selected planes are changed by the commands.
+//
+// Parameters:
+//  - viewer: the emulator whose display the commands are applied to
+//  - commands: commands returned by crisp8DrawCommandsGet
+//  - size: the size of the commands in bytes
+//
+// Return value:
+//  The number of commands applied, or negative if a command was malformed. The commands before it were applied
+int32_t crisp8DrawCommandsReplay (chip8 viewer, const uint8_t* commands, uint32_t size);
+#endif
@@ -0,0 +1,107 @@
+// This is the public API for running many copies of a program in lockstep, as environments for reinforcement learning.
+// A batch holds n emulators that all start from the same boot state. One call to crisp8EnvStep applies a key mask to
+// every environment, runs each for a number of frames and writes all their observations into one caller owned array,
+// so a training loop written in another language makes one foreign call per step instead of one per emulator per
+// cycle.
+//
+// The boot state is taken from a prototype emulator when the batch is created: attach the ROM to it, set the quirks
+// with config.h, and run it for as long as the program needs to boot if that isn't worth repeating every episode.
+// Resetting an environment restores this state.
+//
+// Environments don't fade their framebuffer (see drawcommands.h), so crisp8GetFramebuffer on one of them shows pixels
+// that were turned off as off at once.
+#ifndef CRISP8_ENV_H
+#define CRISP8_ENV_H
+
+#include "crisp8.h"
+#include "defs.h"
+
+#include <stdint.h>
+
+typedef struct crisp8Env_s* crisp8Env;
+
+// What crisp8EnvStep and crisp8EnvReset write for each environment
+enum crisp8EnvObservation
+{
+    // Nothing. The observations array may be NULL
+    CRISP8_ENV_OBSERVE_NONE,
+    // The packed display, laid out like crisp8GetPackedFramebuffer: CRISP8_ENV_PACKED_SIZE bytes
+    CRISP8_ENV_OBSERVE_PACKED,
+    // One byte per pixel at high resolution, holding the bitmask of the planes the pixel is set on, row by row:
+    // CRISP8_ENV_PIXELS_SIZE bytes. In low resolution every pixel covers 2x2 bytes
+    CRISP8_ENV_OBSERVE_PIXELS
+};
+
+#define CRISP8_ENV_PACKED_SIZE (CRISP8_DISPLAY_PLANES * CRISP8_DISPLAY_HIRES_HEIGHT * \
+                                CRISP8_DISPLAY_PACKED_ROW_WORDS * 8)
+#define CRISP8_ENV_PIXELS_SIZE (CRISP8_DISPLAY_HIRES_WIDTH * CRISP8_DISPLAY_HIRES_HEIGHT)
+
+// Creates a batch of environments, all starting from the prototype's current state
+//
+// Parameters:
+//  - env: set to the new batch
+//  - prototype: the emulator whose state every environment starts from. It isn't changed and can be destroyed after
+//  - count: the number of environments
+//  - instructionsPerFrame: the number of instructions in a 60 Hz frame, at most 1092
+//  - observation: what to observe
+//
+// Return value:
+//  Negative if an argument is out of range or memory could not be allocated
+int8_t crisp8EnvCreate (crisp8Env* env, chip8 prototype, uint32_t count, uint16_t instructionsPerFrame,
+                        enum crisp8EnvObservation observation);
+
+// Destroys every environment of a batch
+//
+// Parameters:
+//  - env: the batch. Set to NULL
+void crisp8EnvDestroy (crisp8Env* env);
+
+// Chooses the seed the random number generators of the environments are derived from. Each environment gets a
+// different generator for every episode, worked out from the seed, its index and the number of times it was reset, so
+// a batch started with the same seed and fed the same actions always plays out the same way. The seed is 0 by default
+//
+// Parameters:
+//  - env: the batch
+//  - seed: the seed
+void crisp8EnvSetSeed (crisp8Env env, uint64_t seed);
+
+// Returns the size of one environment's observation
+//
+// Parameters:
+//  - env: the batch
+//
+// Return value:
+//  The size in bytes. The observations array of the batch is this times the number of environments
+uint32_t crisp8EnvObservationSize (crisp8Env env);
+
+// Runs every environment that isn't done for a number of frames, holding down the keys given for it
+//
+// Parameters:
+//  - env: the batch
+//  - actions: one key mask per environment, bit N set while key N is held
+//  - framesPerStep: the number of frames to run
+//  - observations: filled in with every environment's observation after the step, one after the other. May be NULL
+//    when observing nothing
+//  - done: one byte per environment, set to 1 if the environment is done (its program exited) and 0 otherwise. An
+//    environment that is done isn't run any more until it's reset. May be NULL
+void crisp8EnvStep (crisp8Env env, const uint32_t* actions, uint32_t framesPerStep, void* observations,
+                    uint8_t* done);
+
+// Puts environments back into the boot state and starts a new episode for them
+//
+// Parameters:
+//  - env: the batch
+//  - which: one byte per environment, non zero for the ones to reset. NULL resets all of them
+//  - observations: filled in with the observation of every reset environment; the others are left alone. May be NULL
+void crisp8EnvReset (crisp8Env env, const uint8_t* which, void* observations);
+
+// Returns one of the emulators of a batch, to inspect it. It must not be destroyed
+//
+// Parameters:
+//  - env: the batch
+//  - index: the index of the environment
+//
+// Return value:
+//  The emulator
+chip8 crisp8EnvGetEmulator (crisp8Env env, uint32_t index);
+#endif
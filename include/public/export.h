@@ -0,0 +1,106 @@
+// This is the public API for exporting an emulator's state to other processes. An exporter publishes the registers,
+// timers, stack and packed display of one emulator into a POSIX shared memory object, usually once per frame, and any
+// number of viewer processes map the object and read the latest snapshot with the reader functions below. Publishing
+// is a copy of a few KiB into the mapping with no system call, and a viewer that isn't reading costs the emulator
+// nothing.
+//
+// Snapshots are protected by a sequence counter (a seqlock): the exporter makes the counter odd before writing and even
+// again after, and a reader retries if the counter was odd or changed while it copied. Readers never block the
+// exporter. The layout of the shared memory is private to this library, so viewers should read it through the reader
+// functions.
+//
+// Shared memory is only available on POSIX systems; elsewhere the functions fail.
+#ifndef CRISP8_EXPORT_H
+#define CRISP8_EXPORT_H
+
+#include "crisp8.h"
+#include "defs.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CRISP8_EXPORT_MAGIC "C8SHM"
+#define CRISP8_EXPORT_VERSION 1
+
+typedef struct crisp8Exporter_s* crisp8Exporter;
+typedef struct crisp8ExportReader_s* crisp8ExportReader;
+
+// The state of an emulator at the time it was published
+struct crisp8ExportSnapshot
+{
+    // The number of snapshots published before this one
+    uint64_t sequence;
+
+    // The number of cycles the emulator had executed
+    uint64_t cycleCount;
+
+    uint16_t PC;
+    uint16_t I;
+    uint8_t V [16];
+
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    uint8_t soundPlaying;
+    uint8_t exited;
+
+    // The number of items on the stack and the items, oldest first
+    uint8_t stackDepth;
+    uint16_t stack [16];
+
+    // The current resolution and the packed display, laid out like crisp8GetPackedFramebuffer
+    uint8_t displayWidth;
+    uint8_t displayHeight;
+    uint64_t displayRows [CRISP8_DISPLAY_PLANES][CRISP8_DISPLAY_HIRES_HEIGHT][CRISP8_DISPLAY_PACKED_ROW_WORDS];
+};
+
+// Creates a shared memory object and ties it to an emulator. An existing object with the same name is replaced
+//
+// Parameters:
+//  - exporter: set to the new exporter
+//  - emulator: the emulator whose state is published
+//  - name: the name of the shared memory object, starting with a slash (such as "/crisp8-0")
+//
+// Return value:
+//  Negative if shared memory is unavailable or the object could not be created
+int8_t crisp8ExporterOpen (crisp8Exporter* exporter, chip8 emulator, const char* name);
+
+// Publishes the emulator's current state. It must not be called while the emulator is running on another thread
+//
+// Parameters:
+//  - exporter: the exporter
+void crisp8ExporterPublish (crisp8Exporter exporter);
+
+// Unmaps the shared memory object and frees the exporter. Viewers that have mapped the object keep their mapping
+//
+// Parameters:
+//  - exporter: the exporter. Set to NULL
+//  - unlink: true to remove the object's name, so no new viewer can open it
+void crisp8ExporterClose (crisp8Exporter* exporter, bool unlink);
+
+// Maps a shared memory object created by crisp8ExporterOpen for reading
+//
+// Parameters:
+//  - reader: set to the new reader
+//  - name: the name the object was created with
+//
+// Return value:
+//  Negative if the object doesn't exist or wasn't written by a compatible exporter
+int8_t crisp8ExportReaderOpen (crisp8ExportReader* reader, const char* name);
+
+// Copies the latest published snapshot
+//
+// Parameters:
+//  - reader: the reader
+//  - snapshot: filled in with the snapshot
+//
+// Return value:
+//  1 if the snapshot is new since the last call, 0 if nothing was published since, or negative if nothing was
+//  published yet or no consistent copy could be made (such as when the exporter died while publishing)
+int8_t crisp8ExportReaderRead (crisp8ExportReader reader, struct crisp8ExportSnapshot* snapshot);
+
+// Unmaps the shared memory object and frees the reader
+//
+// Parameters:
+//  - reader: the reader. Set to NULL
+void crisp8ExportReaderClose (crisp8ExportReader* reader);
+#endif
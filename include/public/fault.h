@@ -0,0 +1,84 @@
+// This is the public API for faults. Faults are things a correct program never does, such as overflowing the stack or
+// executing an invalid instruction. The emulator never crashes because of them (memory accesses wrap around at the end
+// of memory), but it records them in a small per emulator queue so a frontend or debugger can find out what went
+// wrong.
+#ifndef CRISP8_FAULT_H
+#define CRISP8_FAULT_H
+
+#include "crisp8.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The number of faults the queue holds. Faults recorded while it's full are counted, but otherwise dropped
+#define CRISP8_FAULT_QUEUE_SIZE 16
+
+enum crisp8FaultType
+{
+    // 2NNN with a full stack. The jump is still made
+    CRISP8_FAULT_STACK_OVERFLOW,
+    // 00EE with an empty stack. Execution continues with the next instruction
+    CRISP8_FAULT_STACK_UNDERFLOW,
+    // An instruction that doesn't exist. It's ignored
+    CRISP8_FAULT_INVALID_OPCODE,
+    // An instruction accessed memory past its end through I. The access wraps around to the start of memory
+    CRISP8_FAULT_INDEX_OUT_OF_RANGE
+};
+
+struct crisp8Fault
+{
+    enum crisp8FaultType type;
+
+    // The number of cycles executed before the faulting instruction
+    uint64_t cycle;
+
+    // The address and value of the faulting instruction
+    uint16_t PC;
+    uint16_t opcode;
+
+    // The index register when the fault happened
+    uint16_t I;
+};
+
+// Removes the oldest fault from the queue
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - fault: filled in with the removed fault
+//
+// Return value:
+//  False if the queue was empty
+bool crisp8FaultPop (chip8 emulator, struct crisp8Fault* fault);
+
+// Returns the number of faults in the queue
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  The number of queued faults
+uint8_t crisp8FaultCount (chip8 emulator);
+
+// Returns the number of faults that were dropped because the queue was full
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  The number of dropped faults since the queue was last cleared
+uint32_t crisp8FaultDropped (chip8 emulator);
+
+// Empties the queue and resets the dropped counter
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8FaultClear (chip8 emulator);
+
+// Chooses if batched runs (such as crisp8RunCycles) should stop with CRISP8_STOP_FAULT after an instruction that
+// faulted. This is off by default
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - stop: true to stop on faults
+void crisp8SetStopOnFault (chip8 emulator, bool stop);
+#endif
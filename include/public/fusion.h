@@ -0,0 +1,34 @@
+// This is the public API of macro-op fusion. Programs spend most of their time in a few idioms: positioning and drawing
+// a sprite (6XNN 6YNN ANNN DXYN), counted loops (7XNN 3XNN 1NNN jumping back to the 7XNN), polling the delay timer
+// (FX07 3XNN 1NNN jumping back to the FX07) and jumping to the same address forever (1NNN). With fusion enabled, the
+// batched run functions recognize these sequences in memory and run each one, loops included, as a single operation
+// instead of fetching and dispatching every instruction.
+//
+// Fusion never changes what a program observes: every instruction still takes one cycle, the timers, the sound and the
+// input callback are updated every cycle as usual, and runs stop after the same instruction they would without it.
+// Fused sequences are looked up the first time execution reaches them and forgotten when an instruction writes to them.
+// Only runs without breakpoints, watchpoints or tracing are fused; crisp8RunCycle never is.
+#ifndef CRISP8_FUSION_H
+#define CRISP8_FUSION_H
+
+#include "crisp8.h"
+
+#include <stdint.h>
+
+// Starts fusing instruction sequences in crisp8RunCycles and crisp8RunUntilEvent. Costs a byte per byte of emulator
+// memory. Memory changed through crisp8InitDebugStruct isn't noticed; enable fusion again after such a change, which
+// forgets every sequence found so far
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  Negative if memory could not be allocated
+int8_t crisp8FusionEnable (chip8 emulator);
+
+// Stops fusing instruction sequences
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8FusionDisable (chip8 emulator);
+#endif
@@ -0,0 +1,93 @@
+// This is the public API for exporting the performance counters (see counters.h) of many emulators in the Prometheus
+// text format. Emulators are added to a collection under a group name; the counters of every emulator in a group are
+// summed into one series labelled emulator="<group>" (the stack high water mark takes the maximum instead). Give every
+// emulator its own group to see each one, or one group per program to keep the output small for large fleets.
+//
+// The metrics can be written to any stream, to a file that is replaced atomically (for node_exporter's textfile
+// collector), or to whoever connects to a Unix socket (such as "socat - UNIX-CONNECT:<path>"). Like the counters
+// themselves, they must be written on the thread that runs the emulators, or while they aren't running.
+#ifndef CRISP8_METRICS_H
+#define CRISP8_METRICS_H
+
+#include "crisp8.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct crisp8Metrics_s* crisp8Metrics;
+
+// Creates an empty collection
+//
+// Parameters:
+//  - metrics: set to the new collection
+//
+// Return value:
+//  Negative if memory could not be allocated
+int8_t crisp8MetricsCreate (crisp8Metrics* metrics);
+
+// Frees a collection and closes its socket. The emulators are left alone
+//
+// Parameters:
+//  - metrics: the collection. Set to NULL
+void crisp8MetricsDestroy (crisp8Metrics* metrics);
+
+// Adds an emulator to a collection
+//
+// Parameters:
+//  - metrics: the collection
+//  - emulator: the emulator. It must be removed before it's destroyed
+//  - group: the name of the group to count the emulator in. It's copied
+//
+// Return value:
+//  Negative if memory could not be allocated
+int8_t crisp8MetricsAdd (crisp8Metrics metrics, chip8 emulator, const char* group);
+
+// Removes an emulator from a collection. Its counts no longer show up in its group
+//
+// Parameters:
+//  - metrics: the collection
+//  - emulator: the emulator
+void crisp8MetricsRemove (crisp8Metrics metrics, chip8 emulator);
+
+// Writes the metrics of every group
+//
+// Parameters:
+//  - metrics: the collection
+//  - file: the stream to write to
+//
+// Return value:
+//  Negative if writing failed
+int8_t crisp8MetricsWrite (crisp8Metrics metrics, FILE* file);
+
+// Writes the metrics to a temporary file next to a path and renames it over the path, so readers never see a partly
+// written file
+//
+// Parameters:
+//  - metrics: the collection
+//  - path: the file to replace
+//
+// Return value:
+//  Negative if the file could not be written
+int8_t crisp8MetricsWriteFile (crisp8Metrics metrics, const char* path);
+
+// Starts listening on a Unix socket. An existing socket file at the path is replaced
+//
+// Parameters:
+//  - metrics: the collection
+//  - path: the path of the socket
+//
+// Return value:
+//  Negative if Unix sockets are unavailable or the socket could not be created
+int8_t crisp8MetricsListen (crisp8Metrics metrics, const char* path);
+
+// Answers every connection waiting on the socket with the metrics and closes it. This never waits for a connection or
+// for a client to read, so it can be called once in a while from the loop running the emulators. A client whose socket
+// buffer fills up before it has all the metrics is dropped
+//
+// Parameters:
+//  - metrics: the collection
+//
+// Return value:
+//  The number of connections answered in full, or negative if the collection isn't listening
+int32_t crisp8MetricsServe (crisp8Metrics metrics);
+#endif
@@ -0,0 +1,69 @@
+// This is the public API of the optional realtime runner. It owns the loop every frontend otherwise writes around
+// crisp8RunCycle: it executes a batch of instructions per frame, hands the frame to the frontend and then sleeps until
+// the next frame is due instead of busy waiting. Frames are scheduled against absolute deadlines, so time spent
+// executing and drawing doesn't make the emulator drift.
+//
+// The runner needs clock_nanosleep, so it's only available on POSIX systems that have it (Linux and the BSDs, but not
+// macOS or Windows). Elsewhere crisp8RunRealtime returns -1 right away.
+#ifndef CRISP8_REALTIME_H
+#define CRISP8_REALTIME_H
+
+#include "crisp8.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Called once per frame after its instructions were executed. This is where a frontend draws the framebuffer and
+// polls its input
+//
+// Parameters:
+//  - emulator: the running emulator
+//  - userdata: the pointer passed to crisp8RunRealtime
+//
+// Return value:
+//  False to stop the runner
+typedef bool (*crisp8FrameCallback) (chip8 emulator, void* userdata);
+
+// Timing statistics of a realtime run. Lateness is how long after its deadline a frame actually started
+struct crisp8RealtimeStats
+{
+    // The number of frames executed
+    uint64_t frames;
+
+    // The number of frames whose instructions and frame callback took longer than a frame, so the next frame started
+    // late
+    uint64_t overruns;
+
+    // The number of frames skipped to catch up after falling more than a frame behind. The emulator runs slower than
+    // requested while this happens, rather than running frames back to back to make up for lost time
+    uint64_t skippedFrames;
+
+    // Lateness of the frames that didn't overrun, in nanoseconds. This is the jitter of the sleep itself
+    uint64_t jitterMaxNs;
+    uint64_t jitterMeanNs;
+
+    // The longest time spent executing instructions and in the frame callback for a single frame, in nanoseconds
+    uint64_t workMaxNs;
+
+    // Why the last batch of instructions stopped. A reason other than CRISP8_STOP_CYCLES ended the run
+    struct crisp8StopInfo stop;
+};
+
+// Runs the emulator in real time until the frame callback returns false, the program exits (SUPER-CHIP 00FD) or a
+// breakpoint, watchpoint or fault (see crisp8SetStopOnFault) stops a batch of instructions. The emulator's framerate is
+// set to ipf * hz so the timers decrement at 60 hz.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - ipf: the number of instructions executed per frame
+//  - hz: the number of frames per second
+//  - callback: called after every frame. May be NULL
+//  - userdata: passed to the callback
+//  - stats: filled in with timing statistics when the run ends. May be NULL
+//
+// Return value:
+//  0 when the run ended, or -1 if ipf or hz are zero, ipf * hz doesn't fit a framerate or the runner isn't available
+//  on this platform
+int8_t crisp8RunRealtime (chip8 emulator, uint32_t ipf, uint16_t hz, crisp8FrameCallback callback, void* userdata,
+                          struct crisp8RealtimeStats* stats);
+#endif
@@ -0,0 +1,139 @@
+// This is the public API for recording the display. A recorder appends one frame per call to a stream, usually once
+// every 60 hz tick, and a reader plays the stream back. The crisp8-recording tool turns recordings into PNG files or
+// raw video.
+//
+// Frames are the packed framebuffer (see crisp8GetPackedFramebuffer), CRISP8_RECORDING_FRAME_SIZE bytes covering both
+// bitplanes. Each frame is stored as the XOR of it and the previous frame, run length encoded, so unchanged parts of
+// the display take next to no space and an unchanged frame takes none besides its header. Every keyframeInterval frames
+// the frame is stored on its own instead (a keyframe), which is where a reader can start decoding when seeking.
+//
+// A recording is a crisp8RecordingHeader followed by frames, each a crisp8RecordingFrameHeader followed by its encoded
+// data. Like trace files, everything is written in the byte order of the machine that wrote it.
+//
+// The encoding: a control byte with the top bit clear is followed by nothing and stands for (control + 1) zero bytes.
+// A control byte with the top bit set is followed by ((control & 0x7F) + 1) bytes that are copied as they are.
+#ifndef CRISP8_RECORD_H
+#define CRISP8_RECORD_H
+
+#include "crisp8.h"
+#include "defs.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define CRISP8_RECORDING_MAGIC "C8REC"
+#define CRISP8_RECORDING_VERSION 1
+
+// The size of a decoded frame in bytes
+#define CRISP8_RECORDING_FRAME_SIZE (CRISP8_DISPLAY_PLANES * CRISP8_DISPLAY_HIRES_HEIGHT * \
+                                     CRISP8_DISPLAY_PACKED_ROW_WORDS * 8)
+
+typedef struct crisp8Recorder_s* crisp8Recorder;
+typedef struct crisp8RecordingReader_s* crisp8RecordingReader;
+
+struct crisp8RecordingHeader
+{
+    char magic [8];
+    uint32_t version;
+    uint32_t frameSize;
+    uint32_t keyframeInterval;
+    // 0x0102 in the byte order of the writer
+    uint16_t byteOrderMark;
+    uint16_t reserved;
+};
+
+enum crisp8RecordingFrameType
+{
+    // The data is the frame itself
+    CRISP8_RECORDING_KEYFRAME,
+    // The data is the XOR of the frame and the one before it
+    CRISP8_RECORDING_DELTA
+};
+
+struct crisp8RecordingFrameHeader
+{
+    uint8_t type;
+    // The resolution of the display in the frame
+    uint8_t width;
+    uint8_t height;
+    uint8_t reserved;
+    // The size of the encoded data that follows. Zero for a delta means the frame didn't change
+    uint32_t size;
+};
+
+// Starts a recording
+//
+// Parameters:
+//  - recorder: set to the new recorder
+//  - file: the stream to write to, opened for binary writing. It's not closed by the recorder
+//  - keyframeInterval: the number of frames from one keyframe to the next. 0 only makes the first frame a keyframe
+//
+// Return value:
+//  Negative if memory could not be allocated or the header could not be written
+int8_t crisp8RecorderOpen (crisp8Recorder* recorder, FILE* file, uint32_t keyframeInterval);
+
+// Appends the emulator's current display to the recording
+//
+// Parameters:
+//  - recorder: the recorder
+//  - emulator: the emulator to capture
+//
+// Return value:
+//  Negative if writing failed
+int8_t crisp8RecorderCapture (crisp8Recorder recorder, chip8 emulator);
+
+// Returns the number of bytes written so far, headers included
+//
+// Parameters:
+//  - recorder: the recorder
+//
+// Return value:
+//  The size of the recording
+uint64_t crisp8RecorderGetSize (crisp8Recorder recorder);
+
+// Flushes the stream and frees the recorder
+//
+// Parameters:
+//  - recorder: the recorder to close
+void crisp8RecorderClose (crisp8Recorder* recorder);
+
+// Opens a recording for reading
+//
+// Parameters:
+//  - reader: set to the new reader
+//  - file: the recording, opened for binary reading. It's not closed by the reader. Seeking needs a seekable stream
+//
+// Return value:
+//  Negative if the stream isn't a recording this version of crisp8 can read or memory could not be allocated
+int8_t crisp8RecordingOpen (crisp8RecordingReader* reader, FILE* file);
+
+// Decodes the next frame
+//
+// Parameters:
+//  - reader: the reader
+//  - frame: filled in with the frame, laid out like crisp8GetPackedFramebuffer. Must hold
+//           CRISP8_RECORDING_FRAME_SIZE bytes
+//  - width: set to the width of the display in the frame
+//  - height: set to the height of the display in the frame
+//
+// Return value:
+//  False at the end of the recording or if it is damaged
+bool crisp8RecordingRead (crisp8RecordingReader reader, uint64_t* frame, uint8_t* width, uint8_t* height);
+
+// Moves to a frame, so the next crisp8RecordingRead returns it. Decoding starts at the nearest keyframe before it
+//
+// Parameters:
+//  - reader: the reader
+//  - frameNumber: the number of the frame, counting from 0
+//
+// Return value:
+//  Negative if the recording has fewer frames or the stream can't seek
+int8_t crisp8RecordingSeek (crisp8RecordingReader reader, uint64_t frameNumber);
+
+// Frees a reader
+//
+// Parameters:
+//  - reader: the reader to close
+void crisp8RecordingClose (crisp8RecordingReader* reader);
+#endif
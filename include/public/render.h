@@ -0,0 +1,96 @@
+// This is the public API for turning the framebuffer into pixels a frontend can show. The kernels convert the byte
+// framebuffer (crisp8GetFramebuffer) or the packed one (crisp8GetPackedFramebuffer) to RGBA8888 or RGB565 through a
+// palette, scale it up by an integer factor and write it straight into a surface owned by the frontend, optionally
+// darkening every scaled row's last line to imitate scanlines.
+//
+// The work is done with AVX2 or SSE2 when the processor has them, and with plain C otherwise.
+#ifndef CRISP8_RENDER_H
+#define CRISP8_RENDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The largest supported scaling factor
+#define CRISP8_RENDER_MAX_SCALE 16
+
+enum crisp8PixelFormat
+{
+    // 32 bits per pixel, 0xRRGGBBAA in the machine's byte order
+    CRISP8_PIXEL_RGBA8888,
+    // 16 bits per pixel, 5 bits of red in the most significant bits, 6 of green and 5 of blue
+    CRISP8_PIXEL_RGB565
+};
+
+// How the values of the byte framebuffer are turned into colors. The packed framebuffer always uses the palette
+// directly
+enum crisp8RenderMapping
+{
+    // Values 0 to 3 pick a palette entry. This is what crisp8 compiled without CRISP8_DISPLAY_USE_ALPHA produces (bit N
+    // is set if the pixel is on in plane N)
+    CRISP8_RENDER_INDEXED,
+    // Values are the brightness of a fading pixel (CRISP8_DISPLAY_USE_ALPHA): 0 gives palette entry 0, 255 gives entry
+    // 1 and the values in between blend the two
+    CRISP8_RENDER_FADE_BLEND,
+    // Like CRISP8_RENDER_FADE_BLEND, but palette entry 1 is kept and its alpha is scaled by the value instead, for
+    // frontends that composite the display over something. RGB565 has no alpha, so it blends instead
+    CRISP8_RENDER_FADE_ALPHA
+};
+
+// Colors prepared by crisp8RendererInit, already in the output format. Treat it as opaque
+struct crisp8Renderer
+{
+    enum crisp8PixelFormat format;
+
+    // Colors for every byte framebuffer value, and for the palette indices of the packed framebuffer. The second set
+    // is the darkened one used on scanlines
+    uint32_t colors [2][256];
+    uint32_t paletteColors [2][4];
+
+    // True if scaled rows end with a darkened line
+    bool scanlines;
+};
+
+// Prepares a renderer
+//
+// Parameters:
+//  - renderer: the renderer to prepare
+//  - format: the pixel format of the surfaces it will draw to
+//  - palette: four colors as 0xRRGGBBAA: the background, plane 1, plane 2 and pixels on in both planes
+//  - mapping: how values of the byte framebuffer are turned into colors
+//  - scanlineBrightness: the brightness of the scanlines, from 0 (black) to 255 (no scanlines at all)
+void crisp8RendererInit (struct crisp8Renderer* renderer, enum crisp8PixelFormat format, const uint32_t palette [4],
+                         enum crisp8RenderMapping mapping, uint8_t scanlineBrightness);
+
+// Draws the byte framebuffer into a surface
+//
+// Parameters:
+//  - renderer: a prepared renderer
+//  - framebuffer: the framebuffer, as returned by crisp8GetFramebuffer
+//  - width: the width of the framebuffer (crisp8GetDisplayWidth)
+//  - height: the height of the framebuffer (crisp8GetDisplayHeight)
+//  - scale: the scaling factor, from 1 to CRISP8_RENDER_MAX_SCALE. Scanlines need at least 2
+//  - surface: the first pixel of the surface. It has to be at least width * scale by height * scale pixels
+//  - pitch: the distance between the rows of the surface in bytes
+//
+// Return value:
+//  Negative if the scale or size is out of range
+int8_t crisp8RenderFramebuffer (const struct crisp8Renderer* renderer, const uint8_t* framebuffer, uint8_t width,
+                                uint8_t height, uint8_t scale, void* surface, size_t pitch);
+
+// Draws the packed framebuffer into a surface. This skips building the byte framebuffer altogether
+//
+// Parameters:
+//  - renderer: a prepared renderer
+//  - packed: the packed framebuffer, as returned by crisp8GetPackedFramebuffer
+//  - width: the width of the display (crisp8GetDisplayWidth)
+//  - height: the height of the display (crisp8GetDisplayHeight)
+//  - scale: the scaling factor, from 1 to CRISP8_RENDER_MAX_SCALE. Scanlines need at least 2
+//  - surface: the first pixel of the surface. It has to be at least width * scale by height * scale pixels
+//  - pitch: the distance between the rows of the surface in bytes
+//
+// Return value:
+//  Negative if the scale or size is out of range
+int8_t crisp8RenderPacked (const struct crisp8Renderer* renderer, const uint64_t* packed, uint8_t width,
+                           uint8_t height, uint8_t scale, void* surface, size_t pitch);
+#endif
@@ -0,0 +1,85 @@
+// This is the public API for shared ROM images. Use this in your frontend if you run many emulators with the same
+// program.
+//
+// A ROM is read from disk once by crisp8RomOpen. Any number of emulators can then attach to it with crisp8AttachRom;
+// they all share one read only memory image with the font and the program already in place, and an emulator only
+// gets its own copy of memory the first time the program writes to it. All functions in this header may be called
+// from different threads for the same ROM.
+#ifndef CRISP8_ROM_H
+#define CRISP8_ROM_H
+
+#include "analysis.h"
+#include "crisp8.h"
+
+#include <stdint.h>
+
+typedef struct crisp8Rom_s* crisp8Rom;
+
+// Maps a program file into memory, checks that it fits in the largest chip-8 memory and hashes it
+//
+// Parameters:
+//  - rom: a pointer to the ROM being opened
+//  - path: the path of the program file
+//
+// Return value:
+//  Negative if the file could not be read, is empty or is too big for CRISP8_XO_MEMORY_SIZE. The ROM is not opened in
+//  that case
+int8_t crisp8RomOpen (crisp8Rom* rom, const char* path);
+
+// Releases the caller's reference to a ROM. The ROM itself is freed once no emulator shares its memory image anymore,
+// so this may be called right after attaching it to all emulators
+//
+// Parameters:
+//  - rom: a pointer to the ROM to close
+void crisp8RomClose (crisp8Rom* rom);
+
+// Returns the size of the program in bytes
+//
+// Parameters:
+//  - rom: the ROM
+//
+// Return value:
+//  The size of the program
+uint32_t crisp8RomGetSize (crisp8Rom rom);
+
+// Returns the raw bytes of the program
+//
+// Parameters:
+//  - rom: the ROM
+//
+// Return value:
+//  A read only pointer to crisp8RomGetSize bytes
+const uint8_t* crisp8RomGetData (crisp8Rom rom);
+
+// Returns a 64 bit hash (FNV-1a) of the program's contents. Use it to identify a program, for example as a cache key
+//
+// Parameters:
+//  - rom: the ROM
+//
+// Return value:
+//  The hash of the program
+uint64_t crisp8RomGetHash (crisp8Rom rom);
+
+// Returns the static analysis of the program (see analysis.h), analysing it with the smallest memory it fits in the
+// first time this is called. The analysis belongs to the ROM and is freed with it
+//
+// Parameters:
+//  - rom: the ROM
+//
+// Return value:
+//  The analysis, or NULL if memory could not be allocated
+crisp8Analysis crisp8RomGetAnalysis (crisp8Rom rom);
+
+// Loads a ROM into an emulator without copying it. This does the same as crisp8InitializeProgram, except that the
+// emulator's memory is shared with every other emulator attached to the ROM until the program writes to it. Call
+// crisp8InitDebugStruct again after attaching, since it gives the emulator its own memory.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - rom: the ROM to attach
+//
+// Return value:
+//  Negative if the program doesn't fit in the emulator's memory or memory could not be allocated. The emulator is
+//  left as it was in that case
+int8_t crisp8AttachRom (chip8 emulator, crisp8Rom rom);
+#endif
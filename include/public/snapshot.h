@@ -0,0 +1,107 @@
+// This is the public API of snapshot stores: files holding one fixed size slot of saved state (see state.h) for each
+// of many emulators. The file is memory mapped, so a checkpoint is a crisp8StateSave straight into the mapping with no
+// system call, and after a restart every emulator resumes from its slot with a crisp8StateLoad out of the mapping,
+// without reading or parsing the file first.
+//
+// Every slot holds two copies of the state. A checkpoint always overwrites the older copy, and only gives it a new,
+// higher sequence number after the state and its checksum are written. Restoring picks the copy with the highest
+// sequence number whose checksum matches, so a process dying halfway through a checkpoint leaves the slot at its
+// previous checkpoint. What has been written to the mapping survives the process crashing; crisp8SnapshotStoreSync
+// also makes it survive the machine going down.
+//
+// A store is opened by one process at a time. Different slots may be used from different threads at the same time, but
+// one slot must only be used by one thread at a time. Like saved states, stores are only meant to be opened by the same
+// build of crisp8 that created them.
+//
+// Snapshot stores are only available on POSIX systems; elsewhere the functions fail.
+#ifndef CRISP8_SNAPSHOT_H
+#define CRISP8_SNAPSHOT_H
+
+#include "crisp8.h"
+
+#include <stdint.h>
+
+#define CRISP8_SNAPSHOT_MAGIC "C8SNAP"
+#define CRISP8_SNAPSHOT_VERSION 1
+
+typedef struct crisp8SnapshotStore_s* crisp8SnapshotStore;
+
+// Opens a snapshot store, creating it with all slots empty if the file doesn't exist
+//
+// Parameters:
+//  - store: a pointer to the store being opened
+//  - path: the path of the file
+//  - slots: the number of slots
+//  - memorySize: the memory size of the emulators saved in the store
+//
+// Return value:
+//  Negative if the file could not be created or mapped, is open in another process, or was created with a different
+//  number of slots, memory size or build of crisp8. The store is not opened in that case
+int8_t crisp8SnapshotStoreOpen (crisp8SnapshotStore* store, const char* path, uint32_t slots, uint32_t memorySize);
+
+// Unmaps and closes a snapshot store. Checkpoints stay in the file
+//
+// Parameters:
+//  - store: a pointer to the store to close
+void crisp8SnapshotStoreClose (crisp8SnapshotStore* store);
+
+// Saves the state of an emulator into a slot
+//
+// Parameters:
+//  - store: the store
+//  - slot: the slot to save into
+//  - emulator: the emulator to save
+//
+// Return value:
+//  Negative if the slot doesn't exist or the emulator's memory size isn't the store's. The slot is left as it was in
+//  that case
+int8_t crisp8SnapshotStoreCommit (crisp8SnapshotStore store, uint32_t slot, chip8 emulator);
+
+// Restores an emulator from the latest intact checkpoint in a slot
+//
+// Parameters:
+//  - store: the store
+//  - slot: the slot to restore from
+//  - emulator: the emulator to restore
+//
+// Return value:
+//  Negative if the slot doesn't exist, holds no intact checkpoint or the emulator's memory size isn't the store's. The
+//  emulator is left untouched in that case
+int8_t crisp8SnapshotStoreRestore (crisp8SnapshotStore store, uint32_t slot, chip8 emulator);
+
+// Returns the sequence number of the latest intact checkpoint in a slot. It counts up from 1 with every commit
+//
+// Parameters:
+//  - store: the store
+//  - slot: the slot
+//
+// Return value:
+//  The sequence number, or 0 if the slot doesn't exist or holds no intact checkpoint
+uint64_t crisp8SnapshotStoreGetSequence (crisp8SnapshotStore store, uint32_t slot);
+
+// Empties a slot
+//
+// Parameters:
+//  - store: the store
+//  - slot: the slot to empty
+void crisp8SnapshotStoreClear (crisp8SnapshotStore store, uint32_t slot);
+
+// Returns the number of slots in a store
+//
+// Parameters:
+//  - store: the store
+//
+// Return value:
+//  The number of slots
+uint32_t crisp8SnapshotStoreGetSlots (crisp8SnapshotStore store);
+
+// Writes the checkpoints committed so far to disk and waits for them, so they survive a power loss or a crash of the
+// operating system. This is a system call and a disk flush, so call it less often than crisp8SnapshotStoreCommit
+//
+// Parameters:
+//  - store: the store
+//
+// Return value:
+//  Negative if writing to disk failed
+int8_t crisp8SnapshotStoreSync (crisp8SnapshotStore store);
+#endif
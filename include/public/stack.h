@@ -8,7 +8,8 @@ typedef struct chip8Stack_s* chip8Stack;
 
 // Used by crisp8 ------------------------------------------------------
 
-// Performs neccesary initialization of the stack. This must be the first operation performed on a new stack
+// Performs neccesary initialization of the stack. This must be the first operation performed on a new stack. It prints
+// a message and aborts the process if memory could not be allocated. Emulators embed their stack and never call this
 //
 // Parameters:
 //  - stack: a pointer to the stack to be initialized
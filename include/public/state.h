@@ -0,0 +1,84 @@
+// This is the public API for saving and restoring the state of an emulator. A saved state holds everything the
+// emulated program can observe: memory, registers, stack, timers, the display, the random number generator and the
+// configuration. Debugging state (breakpoints, watchpoints, faults and traces) and the callbacks are not part of it.
+//
+// States are meant to be restored by the same build of crisp8 they were saved by, for things like save slots, rewinding
+// and forking emulators. They are not a portable file format.
+#ifndef CRISP8_STATE_H
+#define CRISP8_STATE_H
+
+#include "crisp8.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Returns the size of the buffer needed to save the state of an emulator. It only depends on the emulator's memory size
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  The size of a saved state in bytes
+size_t crisp8StateSize (chip8 emulator);
+
+// Saves the state of an emulator into a buffer
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - buffer: the buffer to save into
+//  - size: the size of the buffer
+//
+// Return value:
+//  Negative if the buffer is smaller than crisp8StateSize
+int8_t crisp8StateSave (chip8 emulator, void* buffer, size_t size);
+
+// Restores a state saved by crisp8StateSave. The emulator must have the same memory size as the one it was saved from
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - buffer: the saved state
+//  - size: the size of the saved state
+//
+// Return value:
+//  Negative if the buffer doesn't hold a state that fits the emulator. The emulator is left untouched in that case
+int8_t crisp8StateLoad (chip8 emulator, const void* buffer, size_t size);
+
+// Returns a 64 bit hash of what the program can observe: memory, the display, the registers (including the SUPER-CHIP
+// flag registers), the timers and the stack. The cycle count, the state of the random number generator and the
+// configuration are left out, so the same state reached at different times hashes the same. Equal states always have
+// equal hashes; different states have different ones with overwhelming probability.
+//
+// While the hash is tracked (see crisp8StateHashEnable) this only hashes the registers and the stack. Otherwise it
+// hashes the whole of memory and the display.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  The hash
+uint64_t crisp8StateHash (chip8 emulator);
+
+// Returns a 64 bit hash of the display alone: its resolution and the pixels on every plane. Two emulators showing the
+// same picture have the same frame hash, whatever else differs between them. Cheap while the state hash is tracked.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//
+// Return value:
+//  The hash
+uint64_t crisp8FrameHash (chip8 emulator);
+
+// Starts keeping the memory and display parts of the state hash up to date as instructions write them, which makes
+// crisp8StateHash cheap at the cost of a little work per memory write and drawn sprite row. Memory changed through
+// crisp8InitDebugStruct is not noticed; enable the hash again after such a change.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8StateHashEnable (chip8 emulator);
+
+// Stops keeping the state hash up to date
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8StateHashDisable (chip8 emulator);
+#endif
@@ -0,0 +1,171 @@
+// This is the public API of the threaded runner. It runs an emulator in real time on a thread of its own. The host
+// never touches the emulator again after handing it over; it sends commands and receives events through lock-free
+// single producer single consumer queues, and picks up the latest frame from a triple buffer. None of these functions
+// ever wait for the emulator thread, so UI and network threads can't be held up by emulation.
+//
+// Every function taking a crisp8Thread must be called from the same host thread (the queues have one producer and one
+// consumer), except that a thread sending commands and one polling events may be different.
+//
+// The runner is available where the realtime runner is (see realtime.h). Elsewhere crisp8ThreadCreate returns -1.
+#ifndef CRISP8_THREAD_H
+#define CRISP8_THREAD_H
+
+#include "crisp8.h"
+#include "defs.h"
+#include "fault.h"
+#include "rom.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct crisp8Thread_s* crisp8Thread;
+
+// The number of commands and events the queues hold
+#define CRISP8_THREAD_QUEUE_SIZE 256
+
+enum crisp8CommandType
+{
+    // Sets the state of the keypad, a bitmask like the input callback returns (see defs.h)
+    CRISP8_COMMAND_KEYS,
+    // Stops executing instructions. Frames are still paced, so commands keep being handled
+    CRISP8_COMMAND_PAUSE,
+    // Continues executing instructions
+    CRISP8_COMMAND_RESUME,
+    // Executes a number of instructions right away, typically while paused
+    CRISP8_COMMAND_STEP,
+    // Saves the state of the emulator (see state.h) and sends it back with a CRISP8_THREAD_EVENT_SNAPSHOT
+    CRISP8_COMMAND_SNAPSHOT,
+    // Restores a state saved by crisp8StateSave or received in a snapshot event
+    CRISP8_COMMAND_RESTORE,
+    // Resets the emulator to the state it was in when the thread was created and attaches a ROM (see rom.h). If the ROM
+    // can't be attached, a CRISP8_THREAD_EVENT_LOAD_FAILED event is sent
+    CRISP8_COMMAND_LOAD_ROM
+};
+
+struct crisp8Command
+{
+    enum crisp8CommandType type;
+
+    // For CRISP8_COMMAND_KEYS: the keypad state
+    uint32_t keys;
+
+    // For CRISP8_COMMAND_STEP: the number of instructions to execute
+    uint32_t cycles;
+
+    // For CRISP8_COMMAND_LOAD_ROM: the ROM to load. The emulator thread takes over this handle and closes it
+    crisp8Rom rom;
+
+    // For CRISP8_COMMAND_RESTORE: the state to restore. It must be allocated with malloc; the emulator thread frees it
+    void* state;
+    size_t stateSize;
+};
+
+enum crisp8ThreadEventType
+{
+    // A new frame was published and can be picked up with crisp8ThreadGetFrame
+    CRISP8_THREAD_EVENT_FRAME,
+    // The sound started or stopped playing
+    CRISP8_THREAD_EVENT_SOUND_ON,
+    CRISP8_THREAD_EVENT_SOUND_OFF,
+    // An instruction faulted
+    CRISP8_THREAD_EVENT_FAULT,
+    // A breakpoint or watchpoint stopped execution. The emulator is paused
+    CRISP8_THREAD_EVENT_STOPPED,
+    // The program exited (SUPER-CHIP 00FD). The emulator is paused
+    CRISP8_THREAD_EVENT_EXITED,
+    // The answer to CRISP8_COMMAND_SNAPSHOT
+    CRISP8_THREAD_EVENT_SNAPSHOT,
+    // CRISP8_COMMAND_LOAD_ROM failed because the ROM doesn't fit in the emulator's memory or memory could not be
+    // allocated. The emulator is left in its reset state and paused
+    CRISP8_THREAD_EVENT_LOAD_FAILED
+};
+
+struct crisp8ThreadEvent
+{
+    enum crisp8ThreadEventType type;
+
+    // The number of frames the emulator thread had run when the event happened
+    uint64_t frame;
+
+    // For CRISP8_THREAD_EVENT_FAULT: the fault
+    struct crisp8Fault fault;
+
+    // For CRISP8_THREAD_EVENT_STOPPED: where and why execution stopped
+    struct crisp8StopInfo stop;
+
+    // For CRISP8_THREAD_EVENT_SNAPSHOT: the saved state (see state.h). The host owns it and must free it with free
+    void* state;
+    size_t stateSize;
+};
+
+// A frame published by the emulator thread. The pixels are laid out like crisp8GetFramebuffer's
+struct crisp8ThreadFrame
+{
+    // The number of frames the emulator thread had run when the frame was published
+    uint64_t number;
+
+    uint8_t width;
+    uint8_t height;
+    uint8_t pixels [CRISP8_DISPLAY_HIRES_WIDTH * CRISP8_DISPLAY_HIRES_HEIGHT];
+};
+
+// Starts a thread running an emulator. The thread owns the emulator from now on: it installs its own audio and input
+// callbacks and event mask (see crisp8SetEventMask), and the emulator is destroyed together with the thread. Configure
+// it and load a program before handing it over.
+//
+// Parameters:
+//  - thread: set to the new thread
+//  - emulator: the emulator to run
+//  - ipf: the number of instructions executed per frame
+//  - hz: the number of frames per second
+//
+// Return value:
+//  Negative if the thread could not be started, in which case the caller still owns the emulator
+int8_t crisp8ThreadCreate (crisp8Thread* thread, chip8 emulator, uint32_t ipf, uint16_t hz);
+
+// Stops the thread and destroys it and its emulator. Commands and events still in the queues are discarded
+//
+// Parameters:
+//  - thread: the thread to destroy
+void crisp8ThreadDestroy (crisp8Thread* thread);
+
+// Sends a command to the emulator thread. It's handled at the start of the next frame
+//
+// Parameters:
+//  - thread: the thread
+//  - command: the command
+//
+// Return value:
+//  Negative if the command queue is full. The host keeps ownership of the command's ROM or state in that case
+int8_t crisp8ThreadSend (crisp8Thread thread, const struct crisp8Command* command);
+
+// Takes the oldest event from the event queue
+//
+// Parameters:
+//  - thread: the thread
+//  - event: filled in with the event
+//
+// Return value:
+//  False if there were no events
+bool crisp8ThreadPollEvent (crisp8Thread thread, struct crisp8ThreadEvent* event);
+
+// Returns the number of events the emulator thread had to drop because the event queue was full. Frames are never
+// lost this way, only the events announcing them
+//
+// Parameters:
+//  - thread: the thread
+//
+// Return value:
+//  The number of dropped events
+uint64_t crisp8ThreadEventsDropped (crisp8Thread thread);
+
+// Returns the most recently published frame. It stays valid and unchanged until the next call
+//
+// Parameters:
+//  - thread: the thread
+//
+// Return value:
+//  The frame
+const struct crisp8ThreadFrame* crisp8ThreadGetFrame (crisp8Thread thread);
+#endif
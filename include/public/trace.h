@@ -0,0 +1,90 @@
+// This is the public API of the execution tracer. It is only functional if crisp8 is compiled with the TRACE option
+// (CRISP8_TRACE defined); otherwise every function reports that tracing is unavailable.
+//
+// The tracer writes one fixed size record per executed instruction into a per emulator ring buffer. Writing a record
+// is a handful of stores, so it can be left enabled while the emulator runs at full speed. The ring buffer has a
+// single writer (the thread running the emulator) and may be read from any thread while the emulator is running.
+#ifndef CRISP8_TRACE_H
+#define CRISP8_TRACE_H
+
+#include "crisp8.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Identifies a trace file written by crisp8TraceDump
+#define CRISP8_TRACE_FILE_MAGIC "C8TRACE"
+#define CRISP8_TRACE_FILE_VERSION 1
+
+// A single executed instruction. The record is 32 bytes big so that two of them fit in a cache line
+struct crisp8TraceRecord
+{
+    // The number of cycles executed before this instruction
+    uint64_t cycle;
+
+    // PC before the instruction was fetched
+    uint16_t PC;
+    uint16_t opcode;
+
+    // I after the instruction was executed
+    uint16_t I;
+
+    // Bit N is set if the instruction changed register VN
+    uint16_t changedRegisters;
+
+    // All registers (including VF) after the instruction was executed
+    uint8_t V [16];
+};
+
+// The header of a trace file. It is followed by numRecords records, oldest first. All fields are written in the byte
+// order of the machine that wrote the file; recordSize and byteOrderMark can be used to detect a mismatch.
+struct crisp8TraceFileHeader
+{
+    char magic [8];
+    uint32_t version;
+    uint32_t recordSize;
+    // 0x0102 in the byte order of the writer
+    uint16_t byteOrderMark;
+    uint16_t reserved [3];
+    uint64_t numRecords;
+};
+
+// Allocates a ring buffer for the emulator and starts tracing. Any previous trace is discarded.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - capacity: the number of records to keep. It is rounded up to the nearest power of two
+//
+// Return value:
+//  Negative if crisp8 was compiled without tracing or the ring buffer could not be allocated
+int8_t crisp8TraceEnable (chip8 emulator, uint32_t capacity);
+
+// Stops tracing and frees the ring buffer
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+void crisp8TraceDisable (chip8 emulator);
+
+// Copies the most recent records out of the ring buffer, oldest first. This may be called from another thread while
+// the emulator is running; records that are overwritten while being copied are left out.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - records: an array to copy the records into
+//  - maxRecords: the size of records
+//
+// Return value:
+//  The number of records copied
+uint32_t crisp8TraceRead (chip8 emulator, struct crisp8TraceRecord* records, uint32_t maxRecords);
+
+// Writes the whole contents of the ring buffer to a file, preceded by a crisp8TraceFileHeader. Use the crisp8-trace
+// tool to turn the file into text.
+//
+// Parameters:
+//  - emulator: the used chip-8 emulator
+//  - file: a file opened for binary writing
+//
+// Return value:
+//  Negative if tracing is not enabled, memory could not be allocated or writing failed
+int8_t crisp8TraceDump (chip8 emulator, FILE* file);
+#endif
@@ -0,0 +1,674 @@
+// Checks that a faster way of running programs behaves exactly like the reference, which executes one instruction at a
+// time with crisp8RunCycle. A reference emulator and a candidate emulator run the same program in lockstep, in blocks
+// of random length, and their complete saved states (see state.h) are compared after every block. Programs are either
+// generated at random, biased towards the instruction sequences fast engines like to special case, or real programs.
+//
+// Usage: crisp8-conform [options] [rom...]
+//
+//   -e engine     the candidate: batched, fusion (the default) or events. See engines below
+//   -p programs   the number of random programs to run, if no ROMs are given (1000 by default)
+//   -n length     the number of instructions in a random program (64 by default)
+//   -c cycles     the number of cycles to run every program for (2000 by default)
+//   -b cycles     the longest block run between comparisons (100 by default)
+//   -s seed       the seed of the random programs, block lengths and key presses (1 by default)
+//   -o file       write the smallest failing random program to a file, to run it again as a ROM
+//
+// When a random program fails, it's shrunk to a small reproducer: instructions are removed (moving the addresses of
+// jumps, calls and I along) or replaced by 8000 (V0 = V0, which does nothing) as long as the failure stays, and the
+// number of cycles is cut down to the first block that differs. ROMs are only cut down in cycles. A ROM runs with the
+// seed given by -s, so a reproducer written by -o fails again with the seed and cycles printed for it. The exit status
+// is 2 if any program failed.
+//
+// To check a new engine, add it to engines.
+
+#include "crisp8.h"
+#include "fusion.h"
+#include "state.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// The largest random program, which has to fit in 4 KiB of memory after 0x200
+#define MAX_PROGRAM_LENGTH 1792
+
+// A no-op: V0 = V0
+#define NOP 0x8000
+
+struct engine
+{
+    const char* name;
+
+    // Sets up an emulator for the engine, after the program is loaded. May be NULL
+    void (*prepare) (chip8 emulator);
+
+    // Runs exactly the given number of cycles
+    void (*run) (chip8 emulator, uint32_t cycles);
+};
+
+static void runBatched (chip8 emulator, uint32_t cycles)
+{
+    crisp8RunCycles (emulator, cycles, NULL);
+}
+
+static void prepareFusion (chip8 emulator)
+{
+    crisp8FusionEnable (emulator);
+}
+
+// Stops for every event, the way a frontend does, and carries on until the block is done
+static void runEvents (chip8 emulator, uint32_t cycles)
+{
+    while (cycles > 0)
+    {
+        struct crisp8Event event;
+        crisp8RunUntilEvent (emulator, cycles, &event);
+
+        if (event.cyclesExecuted == 0)
+        {
+            return;
+        }
+
+        cycles -= event.cyclesExecuted;
+    }
+}
+
+static const struct engine engines [] = {
+    // crisp8RunCycles, which runs without looking at breakpoints
+    {"batched", NULL, runBatched},
+    // crisp8RunCycles with macro-op fusion (see fusion.h)
+    {"fusion", prepareFusion, runBatched},
+    // crisp8RunUntilEvent with fusion, stopping for every event
+    {"events", prepareFusion, runEvents},
+};
+
+// Random numbers for the generator, the block lengths and the keys (xorshift64*)
+static uint64_t nextRandom (uint64_t* state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1D;
+}
+
+// What the input callback of an emulator reports. Both emulators of a pair see the same key presses, since the keys
+// only depend on how often the callback was called
+struct input
+{
+    uint64_t seed;
+    uint64_t calls;
+};
+
+static uint32_t inputCallback (void* userdata)
+{
+    struct input* input = userdata;
+
+    // The keys change every 64 cycles, so waits for a key (FX0A) end
+    uint64_t state = input->seed ^ (input->calls++ >> 6) * 0x9E3779B97F4A7C15;
+    nextRandom (&state);
+    return nextRandom (&state) & 0xFFFF;
+}
+
+static void audioCallback (void* userdata)
+{
+}
+
+// A pair of emulators running the same program, one with the reference and one with the candidate engine
+struct pair
+{
+    chip8 reference;
+    chip8 candidate;
+    struct input referenceInput;
+    struct input candidateInput;
+};
+
+// Creates both emulators of a pair and loads the program
+//
+// Parameters:
+//  pair: the pair to set up
+//  engine: the candidate engine
+//  program: the program
+//  size: its size in bytes
+//  seed: the seed of the keys and the random number generators
+//
+// Return value:
+//  Negative if the program doesn't fit in memory
+static int pairCreate (struct pair* pair, const struct engine* engine, uint8_t* program, uint32_t size, uint64_t seed)
+{
+    uint32_t memorySize = size <= 4096 - 0x200 ? 4096 : 65536;
+    chip8* emulators [2] = {&pair->reference, &pair->candidate};
+    struct input* inputs [2] = {&pair->referenceInput, &pair->candidateInput};
+
+    for (int i = 0; i < 2; i++)
+    {
+        crisp8InitWithMemorySize (emulators [i], memorySize);
+        crisp8SetFramerate (*emulators [i], 600);
+        crisp8SetRandomSeed (*emulators [i], seed);
+        crisp8SetAudioCallbackWithData (*emulators [i], audioCallback, NULL);
+        crisp8SetInputCallbackWithData (*emulators [i], inputCallback, inputs [i]);
+        inputs [i]->seed = seed;
+        inputs [i]->calls = 0;
+
+        if (size > memorySize - 0x200 || crisp8InitializeProgram (*emulators [i], program, size) < 0)
+        {
+            crisp8Destroy (&pair->reference);
+            if (i == 1)
+            {
+                crisp8Destroy (&pair->candidate);
+            }
+
+            return -1;
+        }
+    }
+
+    if (engine->prepare)
+    {
+        engine->prepare (pair->candidate);
+    }
+
+    return 0;
+}
+
+static void pairDestroy (struct pair* pair)
+{
+    crisp8Destroy (&pair->reference);
+    crisp8Destroy (&pair->candidate);
+}
+
+// Compares the complete states of a pair
+//
+// Parameters:
+//  pair: the pair
+//  buffers: two buffers of crisp8StateSize bytes
+//
+// Return value:
+//  True if the states are the same
+static bool pairMatches (struct pair* pair, uint8_t* buffers [2])
+{
+    size_t size = crisp8StateSize (pair->reference);
+
+    // The stack can't be saved if it overflowed, in which case the cheaper hash has to do
+    if (crisp8StateSave (pair->reference, buffers [0], size) < 0 ||
+        crisp8StateSave (pair->candidate, buffers [1], size) < 0)
+    {
+        return crisp8StateHash (pair->reference) == crisp8StateHash (pair->candidate);
+    }
+
+    return memcmp (buffers [0], buffers [1], size) == 0;
+}
+
+// Runs a program with the reference and the candidate in lockstep
+//
+// Parameters:
+//  engine: the candidate engine
+//  program: the program
+//  size: its size in bytes
+//  cycles: the number of cycles to run
+//  maxBlock: the longest block between comparisons
+//  seed: decides the block lengths and the key presses
+//
+// Return value:
+//  0 if the emulators agreed throughout, otherwise the number of cycles after which they first differed. -1 if the
+//  program couldn't be run
+static int64_t runPair (const struct engine* engine, uint8_t* program, uint32_t size, uint32_t cycles,
+                        uint32_t maxBlock, uint64_t seed)
+{
+    struct pair pair;
+    if (pairCreate (&pair, engine, program, size, seed) < 0)
+    {
+        return -1;
+    }
+
+    size_t stateSize = crisp8StateSize (pair.reference);
+    uint8_t* buffers [2] = {malloc (stateSize), malloc (stateSize)};
+    int64_t result = buffers [0] && buffers [1] ? 0 : -1;
+
+    uint64_t random = seed | 1;
+    for (uint32_t done = 0; done < cycles && result == 0;)
+    {
+        uint32_t block = 1 + nextRandom (&random) % maxBlock;
+        if (block > cycles - done)
+        {
+            block = cycles - done;
+        }
+
+        for (uint32_t i = 0; i < block; i++)
+        {
+            crisp8RunCycle (pair.reference);
+        }
+
+        engine->run (pair.candidate, block);
+        done += block;
+
+        if (!pairMatches (&pair, buffers))
+        {
+            result = done;
+        }
+    }
+
+    free (buffers [0]);
+    free (buffers [1]);
+    pairDestroy (&pair);
+
+    return result;
+}
+
+// Writes a random instruction, or a short sequence, at the given instruction slot
+//
+// Parameters:
+//  program: the program, as big endian instructions
+//  slot: the index of the instruction to write
+//  length: the number of instructions in the program
+//  random: the random number generator
+//
+// Return value:
+//  The number of instructions written
+static uint32_t generateInstruction (uint16_t* program, uint32_t slot, uint32_t length, uint64_t* random)
+{
+    uint64_t r = nextRandom (random);
+    uint16_t x = (r >> 8) & 0xF;
+    uint16_t y = (r >> 12) & 0xF;
+    uint16_t n = (r >> 16) & 0xF;
+    uint16_t nn = (r >> 16) & 0xFF;
+    uint16_t address = 0x200 + slot * 2;
+    uint16_t target = 0x200 + ((r >> 24) % length) * 2;
+
+    // Addresses for I: mostly in the program, so stores hit the code, sometimes the font
+    uint16_t data = (r >> 40) & 1 ? target : (r >> 41) % 0x200;
+
+    // The sequences fast engines special case, which need room for all their instructions
+    uint32_t kind = r % 64;
+    if (kind == 0 && slot + 4 <= length)
+    {
+        program [slot] = 0x6000 | x << 8 | nn;
+        program [slot + 1] = 0x6000 | y << 8 | (uint8_t)(r >> 32);
+        program [slot + 2] = 0xA000 | data;
+        program [slot + 3] = 0xD000 | x << 8 | y << 4 | n;
+        return 4;
+    }
+
+    if ((kind == 1 || kind == 2) && slot + 3 <= length)
+    {
+        program [slot] = kind == 1 ? 0x7000 | x << 8 | (uint8_t)(r >> 32) : 0xF007 | x << 8;
+        program [slot + 1] = 0x3000 | x << 8 | nn;
+        program [slot + 2] = 0x1000 | address;
+        return 3;
+    }
+
+    if (kind == 3)
+    {
+        program [slot] = 0x1000 | address;
+        return 1;
+    }
+
+    // Every other instruction, with random operands
+    static const uint16_t templates [] = {
+        0x00E0, 0x00EE, 0x00FB, 0x00FC, 0x00FE, 0x00FF, 0x00C0, 0x00D0, 0x1000, 0x2000, 0x3000, 0x4000, 0x5000,
+        0x5002, 0x5003, 0x6000, 0x7000, 0x8000, 0x8001, 0x8002, 0x8003, 0x8004, 0x8005, 0x8006, 0x8007, 0x800E,
+        0x9000, 0xA000, 0xB000, 0xC000, 0xD000, 0xE09E, 0xE0A1, 0xF001, 0xF002, 0xF007, 0xF00A, 0xF015, 0xF018,
+        0xF01E, 0xF029, 0xF030, 0xF033, 0xF03A, 0xF055, 0xF065, 0xF075, 0xF085, 0x00FD,
+    };
+
+    uint16_t instruction = templates [(r >> 44) % (sizeof (templates) / sizeof (templates [0]))];
+    switch (instruction >> 12)
+    {
+        case 0x0:
+            // The scroll amount of 00CN and 00DN
+            instruction |= (instruction & 0xFFF0) == 0x00C0 || (instruction & 0xFFF0) == 0x00D0 ? n : 0;
+            break;
+        case 0x1:
+        case 0x2:
+        case 0xB:
+            instruction |= target;
+            break;
+        case 0xA:
+            instruction |= data;
+            break;
+        case 0x3:
+        case 0x4:
+        case 0x6:
+        case 0x7:
+        case 0xC:
+            instruction |= x << 8 | nn;
+            break;
+        case 0x5:
+        case 0x8:
+        case 0x9:
+        case 0xD:
+            instruction |= x << 8 | y << 4 | (instruction >> 12 == 0xD ? n : 0);
+            break;
+        default:
+            instruction |= x << 8;
+            break;
+    }
+
+    program [slot] = instruction;
+    return 1;
+}
+
+// Turns instructions into the bytes of a program
+static void encode (const uint16_t* instructions, uint32_t length, uint8_t* bytes)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        bytes [i * 2] = instructions [i] >> 8;
+        bytes [i * 2 + 1] = instructions [i] & 0xFF;
+    }
+}
+
+// Runs instructions as a program
+static int64_t runInstructions (const struct engine* engine, const uint16_t* instructions, uint32_t length,
+                                uint32_t cycles, uint32_t maxBlock, uint64_t seed)
+{
+    uint8_t bytes [MAX_PROGRAM_LENGTH * 2];
+    encode (instructions, length, bytes);
+    return runPair (engine, bytes, length * 2, cycles, maxBlock, seed);
+}
+
+// Removes an instruction from a program. Jumps, calls and I pointing past it are moved along with the code
+//
+// Parameters:
+//  instructions: the program
+//  length: its length
+//  slot: the index of the instruction to remove
+//  shorter: gets the program without it
+static void removeInstruction (const uint16_t* instructions, uint32_t length, uint32_t slot, uint16_t* shorter)
+{
+    uint16_t removed = 0x200 + slot * 2;
+
+    for (uint32_t i = 0, j = 0; i < length; i++)
+    {
+        if (i == slot)
+        {
+            continue;
+        }
+
+        uint16_t instruction = instructions [i];
+        uint16_t type = instruction >> 12;
+
+        if ((type == 0x1 || type == 0x2 || type == 0xA || type == 0xB) && (instruction & 0x0FFF) > removed)
+        {
+            instruction -= 2;
+        }
+
+        shorter [j++] = instruction;
+    }
+}
+
+// Shrinks a failing random program while it keeps failing
+//
+// Parameters:
+//  instructions: the program, shrunk in place
+//  length: its length, updated
+//  cycles: the cycles it fails within, updated
+static void minimize (const struct engine* engine, uint16_t* instructions, uint32_t* length, uint32_t* cycles,
+                      uint32_t maxBlock, uint64_t seed)
+{
+    uint16_t shorter [MAX_PROGRAM_LENGTH];
+    bool shrunk = true;
+
+    while (shrunk)
+    {
+        shrunk = false;
+
+        for (uint32_t i = 0; i < *length; i++)
+        {
+            if (*length > 1)
+            {
+                removeInstruction (instructions, *length, i, shorter);
+
+                int64_t failed = runInstructions (engine, shorter, *length - 1, *cycles, maxBlock, seed);
+                if (failed > 0)
+                {
+                    (*length)--;
+                    memcpy (instructions, shorter, *length * sizeof (uint16_t));
+                    *cycles = failed;
+                    shrunk = true;
+                    i--;
+                    continue;
+                }
+            }
+
+            uint16_t original = instructions [i];
+            if (original != NOP)
+            {
+                instructions [i] = NOP;
+
+                int64_t failed = runInstructions (engine, instructions, *length, *cycles, maxBlock, seed);
+                if (failed > 0)
+                {
+                    *cycles = failed;
+                    shrunk = true;
+                }
+                else
+                {
+                    instructions [i] = original;
+                }
+            }
+        }
+    }
+}
+
+// Prints the registers of both emulators of a pair after running a program for the given number of cycles
+static void printDifference (const struct engine* engine, uint8_t* program, uint32_t size, uint32_t cycles,
+                             uint32_t maxBlock, uint64_t seed)
+{
+    struct pair pair;
+    if (pairCreate (&pair, engine, program, size, seed) < 0)
+    {
+        return;
+    }
+
+    // The same blocks as runPair, so the candidate is in the same state
+    uint64_t random = seed | 1;
+    for (uint32_t done = 0; done < cycles;)
+    {
+        uint32_t block = 1 + nextRandom (&random) % maxBlock;
+        if (block > cycles - done)
+        {
+            block = cycles - done;
+        }
+
+        for (uint32_t i = 0; i < block; i++)
+        {
+            crisp8RunCycle (pair.reference);
+        }
+
+        engine->run (pair.candidate, block);
+        done += block;
+    }
+
+    chip8 emulators [2] = {pair.reference, pair.candidate};
+    struct crisp8Debug debug [2];
+
+    for (int i = 0; i < 2; i++)
+    {
+        crisp8InitDebugStruct (&debug [i], emulators [i]);
+        printf ("  %-9s PC=%03X I=%03X", i == 0 ? "reference" : engine->name, *debug [i].PC, *debug [i].I);
+        for (int reg = 0; reg < 16; reg++)
+        {
+            printf (" %02X", debug [i].V [reg]);
+        }
+
+        printf ("  state hash %016llx  frame hash %016llx\n", (unsigned long long)crisp8StateHash (emulators [i]),
+                (unsigned long long)crisp8FrameHash (emulators [i]));
+    }
+
+    uint32_t memorySize = crisp8GetMemorySize (pair.reference);
+    int differences = 0;
+    for (uint32_t address = 0; address < memorySize; address++)
+    {
+        if (debug [0].memory [address] != debug [1].memory [address] && differences++ < 8)
+        {
+            printf ("  memory %04X: %02X vs %02X\n", address, debug [0].memory [address], debug [1].memory [address]);
+        }
+    }
+
+    pairDestroy (&pair);
+}
+
+static void usage (const char* program)
+{
+    fprintf (stderr, "Usage: %s [-e engine] [-p programs] [-n length] [-c cycles] [-b cycles] [-s seed] [-o file] "
+                     "[rom...]\n", program);
+}
+
+int main (int argc, char** argv)
+{
+    const struct engine* engine = &engines [1];
+    long programs = 1000;
+    long length = 64;
+    long cycles = 2000;
+    long maxBlock = 100;
+    unsigned long long seed = 1;
+    const char* outputPath = NULL;
+
+    int option;
+    while ((option = getopt (argc, argv, "e:p:n:c:b:s:o:")) != -1)
+    {
+        switch (option)
+        {
+            case 'e':
+                engine = NULL;
+                for (size_t i = 0; i < sizeof (engines) / sizeof (engines [0]); i++)
+                {
+                    if (strcmp (engines [i].name, optarg) == 0)
+                    {
+                        engine = &engines [i];
+                    }
+                }
+
+                if (!engine)
+                {
+                    fprintf (stderr, "Unknown engine %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'p':
+                programs = atol (optarg);
+                break;
+            case 'n':
+                length = atol (optarg);
+                break;
+            case 'c':
+                cycles = atol (optarg);
+                break;
+            case 'b':
+                maxBlock = atol (optarg);
+                break;
+            case 's':
+                seed = strtoull (optarg, NULL, 0);
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            default:
+                usage (argv [0]);
+                return 1;
+        }
+    }
+
+    if (programs < 0 || length < 1 || length > MAX_PROGRAM_LENGTH || cycles < 1 || maxBlock < 1)
+    {
+        usage (argv [0]);
+        return 1;
+    }
+
+    int failures = 0;
+
+    // Real programs
+    for (int i = optind; i < argc; i++)
+    {
+        FILE* file = fopen (argv [i], "rb");
+        static uint8_t program [65536];
+        size_t size = file ? fread (program, 1, sizeof (program), file) : 0;
+
+        if (file)
+        {
+            fclose (file);
+        }
+
+        int64_t failed = size ? runPair (engine, program, size, cycles, maxBlock, seed) : -1;
+        if (failed < 0)
+        {
+            fprintf (stderr, "Could not run %s\n", argv [i]);
+            return 1;
+        }
+
+        if (failed > 0)
+        {
+            printf ("%s: %s differs from the reference after %lld cycles\n", argv [i], engine->name,
+                    (long long)failed);
+            printDifference (engine, program, size, failed, maxBlock, seed);
+            failures++;
+        }
+    }
+
+    if (optind < argc)
+    {
+        printf ("%d of %d programs failed with engine %s\n", failures, argc - optind, engine->name);
+        return failures ? 2 : 0;
+    }
+
+    // Random programs. The smallest reproducer is kept
+    uint16_t instructions [MAX_PROGRAM_LENGTH];
+    uint16_t smallest [MAX_PROGRAM_LENGTH];
+    uint32_t smallestLength = 0;
+
+    for (long p = 0; p < programs; p++)
+    {
+        uint64_t random = (seed + p) * 0x9E3779B97F4A7C15 | 1;
+        for (uint32_t slot = 0; slot < length;)
+        {
+            slot += generateInstruction (instructions, slot, length, &random);
+        }
+
+        uint64_t runSeed = nextRandom (&random);
+        int64_t failed = runInstructions (engine, instructions, length, cycles, maxBlock, runSeed);
+        if (failed <= 0)
+        {
+            continue;
+        }
+
+        uint32_t reproducerLength = length;
+        uint32_t reproducerCycles = failed;
+        minimize (engine, instructions, &reproducerLength, &reproducerCycles, maxBlock, runSeed);
+
+        printf ("program %ld: %s differs from the reference. Reproducer, run as a ROM with -s %llu -c %u:\n", p,
+                engine->name, (unsigned long long)runSeed, reproducerCycles);
+        for (uint32_t i = 0; i < reproducerLength; i++)
+        {
+            printf ("  %03X: %04X\n", 0x200 + i * 2, instructions [i]);
+        }
+
+        uint8_t bytes [MAX_PROGRAM_LENGTH * 2];
+        encode (instructions, reproducerLength, bytes);
+        printDifference (engine, bytes, reproducerLength * 2, reproducerCycles, maxBlock, runSeed);
+
+        if (smallestLength == 0 || reproducerLength < smallestLength)
+        {
+            memcpy (smallest, instructions, reproducerLength * sizeof (uint16_t));
+            smallestLength = reproducerLength;
+        }
+
+        failures++;
+    }
+
+    printf ("%d of %ld random programs failed with engine %s\n", failures, programs, engine->name);
+
+    if (outputPath && smallestLength)
+    {
+        uint8_t bytes [MAX_PROGRAM_LENGTH * 2];
+        encode (smallest, smallestLength, bytes);
+
+        FILE* file = fopen (outputPath, "wb");
+        if (!file || fwrite (bytes, 2, smallestLength, file) != smallestLength || fclose (file) != 0)
+        {
+            perror (outputPath);
+            return 1;
+        }
+    }
+
+    return failures ? 2 : 0;
+}
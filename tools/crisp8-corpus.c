@@ -0,0 +1,662 @@
+// Runs a whole directory of programs in parallel, checks the picture each one ends up with and measures how fast they
+// ran, so regressions in correctness or speed that only real programs hit show up on every build.
+//
+// Usage: crisp8-corpus [options] <directory>
+//
+//   -f frames     the number of 60 Hz frames to run each program for (600 by default)
+//   -s speed      instructions per second (600 by default; raise it to measure throughput)
+//   -j threads    the number of programs run at the same time (the number of processors by default)
+//   -n runs       run every program this many times and keep the fastest (1 by default)
+//   -b baseline   compare the speed of every program against a baseline written by -o
+//   -p percent    how much slower than the baseline a program may get before it's a regression (10 by default)
+//   -o file       write the speed of every program to a file, to use as a baseline later
+//   -w            write the frame hashes of this run to the manifest instead of checking them
+//
+// Every file in the directory ending in .ch8, .c8, .sc8 or .xo8 is run headless, without input, as fast as possible,
+// until the frames run out or it exits. The manifest, hashes.txt in the directory, holds a line per program: its file
+// name, the frame hash (see crisp8FrameHash in state.h) it should end with and optionally the quirks it needs as
+// quirk=old|new (see config.h: shift, jump and memory). For example:
+//
+//   pong.ch8      1f2e3d4c5b6a7988
+//   blinky.ch8    0a1b2c3d4e5f6071  shift=new memory=new
+//
+// Speeds are instructions per second of processor time of the thread running the program, which is less affected by
+// the other threads than wall time. The exit status is 2 if any hash didn't match or any program got slower than the
+// baseline allows, 1 if the tool couldn't do its job and 0 otherwise.
+
+#include "config.h"
+#include "crisp8.h"
+#include "defs.h"
+#include "fusion.h"
+#include "rom.h"
+#include "state.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_NAME_LENGTH 256
+
+// The quirks a manifest can set, in the order of quirkNames
+#define NUM_QUIRKS 3
+
+static const char* quirkNames [NUM_QUIRKS] = {"shift", "jump", "memory"};
+
+struct program
+{
+    char name [MAX_NAME_LENGTH];
+
+    // From the manifest. A quirk is -1 if the emulator's default is used, otherwise an enum crisp8ConfigValue
+    bool hasExpected;
+    uint64_t expectedHash;
+    int quirks [NUM_QUIRKS];
+
+    // From the baseline. 0 if the program isn't in it
+    double baselineSpeed;
+
+    // Results
+    bool failed;
+    uint64_t frameHash;
+    uint64_t instructions;
+    double wallSeconds;
+    double cpuSeconds;
+};
+
+struct corpus
+{
+    const char* directory;
+    struct program* programs;
+    size_t numPrograms;
+
+    uint64_t frames;
+    uint32_t cyclesPerFrame;
+    int runs;
+
+    // The next program a worker picks up
+    _Atomic size_t next;
+};
+
+static uint32_t inputCallback (void* userdata)
+{
+    return 0;
+}
+
+static void audioCallback (void* userdata)
+{
+}
+
+static double secondsBetween (const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Returns true if a file name has one of the extensions of chip-8 programs
+//
+// Parameters:
+//  name: the file name
+static bool isProgram (const char* name)
+{
+    static const char* extensions [] = {".ch8", ".c8", ".sc8", ".xo8"};
+
+    size_t length = strlen (name);
+    for (size_t i = 0; i < sizeof (extensions) / sizeof (extensions [0]); i++)
+    {
+        size_t extensionLength = strlen (extensions [i]);
+        if (length > extensionLength && strcmp (name + length - extensionLength, extensions [i]) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Orders programs by name
+static int compareNames (const void* a, const void* b)
+{
+    return strcmp (((const struct program*)a)->name, ((const struct program*)b)->name);
+}
+
+// Finds a program by name
+//
+// Parameters:
+//  corpus: the corpus, with its programs sorted by name
+//  name: the file name of the program
+//
+// Return value:
+//  The program, or NULL if there's no program with that name
+static struct program* findProgram (struct corpus* corpus, const char* name)
+{
+    struct program key;
+    snprintf (key.name, sizeof (key.name), "%s", name);
+    return bsearch (&key, corpus->programs, corpus->numPrograms, sizeof (struct program), compareNames);
+}
+
+// Lists the programs in the corpus directory
+//
+// Return value:
+//  Negative if the directory couldn't be read or holds no programs
+static int listPrograms (struct corpus* corpus)
+{
+    DIR* directory = opendir (corpus->directory);
+    if (!directory)
+    {
+        perror (corpus->directory);
+        return -1;
+    }
+
+    size_t capacity = 0;
+    struct dirent* entry;
+
+    while ((entry = readdir (directory)))
+    {
+        if (!isProgram (entry->d_name) || strlen (entry->d_name) >= MAX_NAME_LENGTH)
+        {
+            continue;
+        }
+
+        if (corpus->numPrograms == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            struct program* grown = realloc (corpus->programs, capacity * sizeof (struct program));
+            if (!grown)
+            {
+                fputs ("Out of memory\n", stderr);
+                closedir (directory);
+                return -1;
+            }
+
+            corpus->programs = grown;
+        }
+
+        struct program* program = &corpus->programs [corpus->numPrograms++];
+        memset (program, 0, sizeof (*program));
+        for (int i = 0; i < NUM_QUIRKS; i++)
+        {
+            program->quirks [i] = -1;
+        }
+
+        snprintf (program->name, sizeof (program->name), "%s", entry->d_name);
+    }
+
+    closedir (directory);
+
+    if (corpus->numPrograms == 0)
+    {
+        fprintf (stderr, "No programs in %s\n", corpus->directory);
+        return -1;
+    }
+
+    qsort (corpus->programs, corpus->numPrograms, sizeof (struct program), compareNames);
+    return 0;
+}
+
+// Reads the manifest, if the directory has one
+//
+// Parameters:
+//  corpus: the corpus, with its programs listed
+//  path: the manifest
+//
+// Return value:
+//  Negative if the manifest has a mistake in it, which is reported
+static int readManifest (struct corpus* corpus, const char* path)
+{
+    FILE* file = fopen (path, "r");
+    if (!file)
+    {
+        return 0;
+    }
+
+    char line [1024];
+    int lineNumber = 0;
+
+    while (fgets (line, sizeof (line), file))
+    {
+        lineNumber++;
+
+        char* comment = strchr (line, '#');
+        if (comment)
+        {
+            *comment = '\0';
+        }
+
+        char* name = strtok (line, " \t\n");
+        char* hash = strtok (NULL, " \t\n");
+        if (!name)
+        {
+            continue;
+        }
+
+        struct program* program = findProgram (corpus, name);
+        char* end = NULL;
+        uint64_t expectedHash = hash ? strtoull (hash, &end, 16) : 0;
+
+        if (!program || !hash || *end != '\0')
+        {
+            fprintf (stderr, "%s:%d: %s\n", path, lineNumber,
+                     !program ? "no such program in the directory" : "expected \"<file name> <frame hash>\"");
+            fclose (file);
+            return -1;
+        }
+
+        program->hasExpected = true;
+        program->expectedHash = expectedHash;
+
+        for (char* quirk = strtok (NULL, " \t\n"); quirk; quirk = strtok (NULL, " \t\n"))
+        {
+            char* value = strchr (quirk, '=');
+            int i = 0;
+
+            if (value)
+            {
+                *value++ = '\0';
+                while (i < NUM_QUIRKS && strcmp (quirk, quirkNames [i]) != 0)
+                {
+                    i++;
+                }
+            }
+
+            if (!value || i == NUM_QUIRKS || (strcmp (value, "old") != 0 && strcmp (value, "new") != 0))
+            {
+                fprintf (stderr, "%s:%d: quirks are written as shift, jump or memory =old or =new\n", path, lineNumber);
+                fclose (file);
+                return -1;
+            }
+
+            program->quirks [i] = strcmp (value, "old") == 0 ? OLD : NEW;
+        }
+    }
+
+    fclose (file);
+    return 0;
+}
+
+// Writes the frame hashes of the run to the manifest, keeping the quirks
+//
+// Parameters:
+//  corpus: the corpus, after running it
+//  path: the manifest
+//
+// Return value:
+//  Negative if the manifest couldn't be written
+static int writeManifest (struct corpus* corpus, const char* path)
+{
+    FILE* file = fopen (path, "w");
+    if (!file)
+    {
+        perror (path);
+        return -1;
+    }
+
+    for (size_t i = 0; i < corpus->numPrograms; i++)
+    {
+        struct program* program = &corpus->programs [i];
+        if (program->failed)
+        {
+            continue;
+        }
+
+        fprintf (file, "%s %016llx", program->name, (unsigned long long)program->frameHash);
+        for (int quirk = 0; quirk < NUM_QUIRKS; quirk++)
+        {
+            if (program->quirks [quirk] >= 0)
+            {
+                fprintf (file, " %s=%s", quirkNames [quirk], program->quirks [quirk] == OLD ? "old" : "new");
+            }
+        }
+
+        fputc ('\n', file);
+    }
+
+    return fclose (file) == 0 ? 0 : -1;
+}
+
+// Reads a baseline written by writeBaseline. Programs that aren't in the corpus anymore are ignored
+//
+// Parameters:
+//  corpus: the corpus, with its programs listed
+//  path: the baseline
+//
+// Return value:
+//  Negative if the baseline couldn't be read
+static int readBaseline (struct corpus* corpus, const char* path)
+{
+    FILE* file = fopen (path, "r");
+    if (!file)
+    {
+        perror (path);
+        return -1;
+    }
+
+    char name [MAX_NAME_LENGTH];
+    double speed;
+
+    while (fscanf (file, "%255s %lf", name, &speed) == 2)
+    {
+        struct program* program = findProgram (corpus, name);
+        if (program)
+        {
+            program->baselineSpeed = speed;
+        }
+    }
+
+    fclose (file);
+    return 0;
+}
+
+// Writes the speed of every program that ran, in instructions per second
+//
+// Parameters:
+//  corpus: the corpus, after running it
+//  path: the file to write
+//
+// Return value:
+//  Negative if the file couldn't be written
+static int writeBaseline (struct corpus* corpus, const char* path)
+{
+    FILE* file = fopen (path, "w");
+    if (!file)
+    {
+        perror (path);
+        return -1;
+    }
+
+    for (size_t i = 0; i < corpus->numPrograms; i++)
+    {
+        struct program* program = &corpus->programs [i];
+        if (!program->failed && program->cpuSeconds > 0)
+        {
+            fprintf (file, "%s %.0f\n", program->name, program->instructions / program->cpuSeconds);
+        }
+    }
+
+    return fclose (file) == 0 ? 0 : -1;
+}
+
+// Runs a program once and records how long it took and the picture it ended with
+//
+// Parameters:
+//  corpus: the corpus
+//  program: the program to run
+//  rom: the program, opened
+//
+// Return value:
+//  Negative if the program couldn't be run
+static int runProgram (struct corpus* corpus, struct program* program, crisp8Rom rom)
+{
+    uint32_t memorySize = crisp8RomGetSize (rom) <= CRISP8_MEMORY_SIZE - 0x200 ? CRISP8_MEMORY_SIZE
+                                                                             : CRISP8_XO_MEMORY_SIZE;
+    chip8 emulator;
+    if (crisp8InitWithMemorySize (&emulator, memorySize) < 0)
+    {
+        return -1;
+    }
+
+    crisp8SetFramerate (emulator, corpus->cyclesPerFrame * 60);
+    crisp8SetAudioCallbackWithData (emulator, audioCallback, NULL);
+    crisp8SetInputCallbackWithData (emulator, inputCallback, NULL);
+    crisp8SetRandomSeed (emulator, 0);
+    crisp8SetHeadless (emulator, true);
+    crisp8FusionEnable (emulator);
+
+    if (program->quirks [0] >= 0)
+    {
+        crisp8ConfigSetShift (program->quirks [0], emulator);
+    }
+    if (program->quirks [1] >= 0)
+    {
+        crisp8ConfigSetJumpOffset (program->quirks [1], emulator);
+    }
+    if (program->quirks [2] >= 0)
+    {
+        crisp8ConfigSetStoreLoadMemory (program->quirks [2], emulator);
+    }
+
+    if (crisp8AttachRom (emulator, rom) < 0)
+    {
+        crisp8Destroy (&emulator);
+        return -1;
+    }
+
+    struct timespec wallStart, wallEnd, cpuStart, cpuEnd;
+    clock_gettime (CLOCK_MONOTONIC, &wallStart);
+    clock_gettime (CLOCK_THREAD_CPUTIME_ID, &cpuStart);
+
+    uint64_t instructions = 0;
+    for (uint64_t frame = 0; frame < corpus->frames && !crisp8HasExited (emulator); frame++)
+    {
+        crisp8RunCycles (emulator, corpus->cyclesPerFrame, NULL);
+        instructions += corpus->cyclesPerFrame;
+    }
+
+    clock_gettime (CLOCK_THREAD_CPUTIME_ID, &cpuEnd);
+    clock_gettime (CLOCK_MONOTONIC, &wallEnd);
+
+    double cpuSeconds = secondsBetween (&cpuStart, &cpuEnd);
+    if (program->instructions == 0 || cpuSeconds < program->cpuSeconds)
+    {
+        program->cpuSeconds = cpuSeconds;
+        program->wallSeconds = secondsBetween (&wallStart, &wallEnd);
+    }
+
+    program->instructions = instructions;
+    program->frameHash = crisp8FrameHash (emulator);
+
+    crisp8Destroy (&emulator);
+    return 0;
+}
+
+// Runs programs until there are none left
+//
+// Parameters:
+//  userdata: the corpus
+static void* worker (void* userdata)
+{
+    struct corpus* corpus = userdata;
+    char path [4096];
+
+    for (;;)
+    {
+        size_t index = atomic_fetch_add_explicit (&corpus->next, 1, memory_order_relaxed);
+        if (index >= corpus->numPrograms)
+        {
+            return NULL;
+        }
+
+        struct program* program = &corpus->programs [index];
+        snprintf (path, sizeof (path), "%s/%s", corpus->directory, program->name);
+
+        crisp8Rom rom;
+        if (crisp8RomOpen (&rom, path) < 0)
+        {
+            program->failed = true;
+            continue;
+        }
+
+        for (int run = 0; run < corpus->runs && !program->failed; run++)
+        {
+            program->failed = runProgram (corpus, program, rom) < 0;
+        }
+
+        crisp8RomClose (&rom);
+    }
+}
+
+static void usage (const char* program)
+{
+    fprintf (stderr,
+             "Usage: %s [-f frames] [-s speed] [-j threads] [-n runs] [-b baseline] [-p percent] [-o file] [-w]\n"
+             "          <directory>\n",
+             program);
+}
+
+int main (int argc, char** argv)
+{
+    struct corpus corpus = {0};
+    corpus.frames = 600;
+    corpus.runs = 1;
+
+    long speed = 600;
+    long threads = sysconf (_SC_NPROCESSORS_ONLN);
+    const char* baselinePath = NULL;
+    const char* outputPath = NULL;
+    double tolerance = 10;
+    bool writeHashes = false;
+
+    int option;
+    while ((option = getopt (argc, argv, "f:s:j:n:b:p:o:w")) != -1)
+    {
+        switch (option)
+        {
+            case 'f':
+                corpus.frames = strtoull (optarg, NULL, 0);
+                break;
+            case 's':
+                speed = atol (optarg);
+                break;
+            case 'j':
+                threads = atol (optarg);
+                break;
+            case 'n':
+                corpus.runs = atoi (optarg);
+                break;
+            case 'b':
+                baselinePath = optarg;
+                break;
+            case 'p':
+                tolerance = atof (optarg);
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            case 'w':
+                writeHashes = true;
+                break;
+            default:
+                usage (argv [0]);
+                return 1;
+        }
+    }
+
+    // crisp8SetFramerate takes the speed, which has to be a whole number of instructions per frame here
+    if (optind != argc - 1 || speed < 60 || speed > 65535 || corpus.runs < 1 || tolerance < 0)
+    {
+        usage (argv [0]);
+        return 1;
+    }
+
+    corpus.directory = argv [optind];
+    corpus.cyclesPerFrame = speed / 60;
+    atomic_init (&corpus.next, 0);
+
+    char manifestPath [4096];
+    snprintf (manifestPath, sizeof (manifestPath), "%s/hashes.txt", corpus.directory);
+
+    if (listPrograms (&corpus) < 0 || readManifest (&corpus, manifestPath) < 0 ||
+        (baselinePath && readBaseline (&corpus, baselinePath) < 0))
+    {
+        free (corpus.programs);
+        return 1;
+    }
+
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    if ((size_t)threads > corpus.numPrograms)
+    {
+        threads = corpus.numPrograms;
+    }
+
+    pthread_t* workers = malloc (threads * sizeof (pthread_t));
+    if (!workers)
+    {
+        fputs ("Out of memory\n", stderr);
+        free (corpus.programs);
+        return 1;
+    }
+
+    struct timespec start, end;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    // The main thread is one of the workers, and does all the work if no other thread can be started
+    long started = 0;
+    while (started < threads - 1 && pthread_create (&workers [started], NULL, worker, &corpus) == 0)
+    {
+        started++;
+    }
+
+    worker (&corpus);
+
+    for (long i = 0; i < started; i++)
+    {
+        pthread_join (workers [i], NULL);
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &end);
+    free (workers);
+
+    int mismatches = 0;
+    int regressions = 0;
+    int failures = 0;
+    uint64_t totalInstructions = 0;
+
+    printf ("%-32s %12s %9s %11s %11s  %s\n", "program", "instructions", "wall s", "Minstr/s", "baseline", "hash");
+
+    for (size_t i = 0; i < corpus.numPrograms; i++)
+    {
+        struct program* program = &corpus.programs [i];
+        if (program->failed)
+        {
+            printf ("%-32s could not be run\n", program->name);
+            failures++;
+            continue;
+        }
+
+        double rate = program->cpuSeconds > 0 ? program->instructions / program->cpuSeconds : 0;
+        char baseline [32] = "-";
+        const char* hash = "new";
+
+        if (program->baselineSpeed > 0)
+        {
+            double change = (rate / program->baselineSpeed - 1) * 100;
+            bool regressed = change < -tolerance;
+
+            snprintf (baseline, sizeof (baseline), "%+.1f%%%s", change, regressed ? " SLOW" : "");
+            regressions += regressed;
+        }
+
+        if (program->hasExpected && !writeHashes)
+        {
+            bool matches = program->frameHash == program->expectedHash;
+            hash = matches ? "ok" : "MISMATCH";
+            mismatches += !matches;
+        }
+
+        totalInstructions += program->instructions;
+        printf ("%-32s %12llu %9.3f %11.2f %11s  %s\n", program->name, (unsigned long long)program->instructions,
+                program->wallSeconds, rate / 1e6, baseline, hash);
+    }
+
+    double seconds = secondsBetween (&start, &end);
+    printf ("%zu programs, %llu instructions in %.3f s on %ld threads (%.2f million instructions/s): %d mismatches, "
+            "%d regressions, %d failures\n",
+            corpus.numPrograms, (unsigned long long)totalInstructions, seconds, started + 1,
+            totalInstructions / seconds / 1e6, mismatches, regressions, failures);
+
+    int status = mismatches || regressions ? 2 : 0;
+
+    if ((writeHashes && writeManifest (&corpus, manifestPath) < 0) ||
+        (outputPath && writeBaseline (&corpus, outputPath) < 0))
+    {
+        status = 1;
+    }
+
+    free (corpus.programs);
+    return failures ? 1 : status;
+}
@@ -0,0 +1,160 @@
+// Benchmarks stepping a fleet of emulators round-robin, the way a server hosting lots of them does. Every emulator runs
+// the same small program (arithmetic, subroutine calls, memory accesses and a bit of drawing) from its own memory.
+//
+// Usage: crisp8-fleet [number of emulators] [rounds] [cycles per turn] [snapshot store]
+//
+// Each round gives every emulator a turn of the given number of cycles (1 by default, which is the worst case for the
+// caches since every instruction is executed by a different emulator than the one before).
+//
+// With a snapshot store (see snapshot.h), every emulator resumes from its slot if it has a checkpoint there, and is
+// checkpointed into it at the end, so running the tool again carries on where the last run stopped. The time taken to
+// resume and to checkpoint the whole fleet is printed too.
+
+#include "crisp8.h"
+#include "defs.h"
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static uint8_t program [] = {0x60, 0x00,   // 200: V0 = 0
+                             0x61, 0x01,   // 202: V1 = 1
+                             0x22, 0x10,   // 204: Call 210
+                             0x70, 0x01,   // 206: V0 += 1
+                             0x30, 0x40,   // 208: Skip if V0 == 0x40
+                             0x12, 0x04,   // 20A: Jump to 204
+                             0x12, 0x00,   // 20C: Jump to 200
+                             0x00, 0x00,   // 20E: Unused
+                             0x82, 0x14,   // 210: V2 += V1
+                             0x83, 0x24,   // 212: V3 += V2
+                             0xA3, 0x00,   // 214: I = 300
+                             0xF3, 0x33,   // 216: Store the decimal digits of V3 at I
+                             0xF2, 0x65,   // 218: Load V0 to V2 from I
+                             0x60, 0x00,   // 21A: V0 = 0 (put the loop counter back below)
+                             0x80, 0x34,   // 21C: V0 += V3
+                             0xD1, 0x21,   // 21E: Draw a row of a sprite at V1, V2
+                             0x00, 0xEE};  // 220: Return
+
+static uint32_t inputCallback (void* userdata)
+{
+    return 0;
+}
+
+static void audioCallback (void* userdata)
+{
+}
+
+// Returns the seconds between two points in time
+//
+// Parameters:
+//  start: the earlier point
+//  end: the later point
+static double elapsed (const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main (int argc, char** argv)
+{
+    long numEmulators = argc > 1 ? atol (argv [1]) : 4096;
+    long rounds = argc > 2 ? atol (argv [2]) : 2000;
+    long cyclesPerTurn = argc > 3 ? atol (argv [3]) : 1;
+    const char* storePath = argc > 4 ? argv [4] : NULL;
+
+    if (numEmulators <= 0 || numEmulators > UINT32_MAX || rounds <= 0 || cyclesPerTurn <= 0)
+    {
+        fprintf (stderr, "Usage: %s [number of emulators] [rounds] [cycles per turn] [snapshot store]\n", argv [0]);
+        return 1;
+    }
+
+    crisp8SnapshotStore store = NULL;
+    if (storePath && crisp8SnapshotStoreOpen (&store, storePath, numEmulators, CRISP8_MEMORY_SIZE) < 0)
+    {
+        fprintf (stderr, "Could not open %s as a snapshot store of %ld slots\n", storePath, numEmulators);
+        return 1;
+    }
+
+    chip8* fleet = malloc (numEmulators * sizeof (chip8));
+    if (!fleet)
+    {
+        fputs ("Out of memory\n", stderr);
+        crisp8SnapshotStoreClose (&store);
+        return 1;
+    }
+
+    for (long i = 0; i < numEmulators; i++)
+    {
+        crisp8Init (&fleet [i]);
+        crisp8SetFramerate (fleet [i], 600);
+        crisp8SetAudioCallbackWithData (fleet [i], audioCallback, NULL);
+        crisp8SetInputCallbackWithData (fleet [i], inputCallback, NULL);
+        crisp8SetRandomSeed (fleet [i], i);
+        crisp8InitializeProgram (fleet [i], program, sizeof (program));
+    }
+
+    struct timespec start;
+    struct timespec end;
+
+    if (store)
+    {
+        long resumed = 0;
+
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        for (long i = 0; i < numEmulators; i++)
+        {
+            resumed += crisp8SnapshotStoreRestore (store, i, fleet [i]) == 0;
+        }
+        clock_gettime (CLOCK_MONOTONIC, &end);
+
+        printf ("Resumed %ld of %ld emulators from %s in %.3f ms\n", resumed, numEmulators, storePath,
+                elapsed (&start, &end) * 1e3);
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    for (long round = 0; round < rounds; round++)
+    {
+        for (long i = 0; i < numEmulators; i++)
+        {
+            crisp8RunCycles (fleet [i], cyclesPerTurn, NULL);
+        }
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &end);
+
+    double seconds = elapsed (&start, &end);
+    double instructions = (double)numEmulators * rounds * cyclesPerTurn;
+
+    printf ("%ld emulators, %ld rounds of %ld cycles: %.3f s, %.1f ns per instruction, %.1f million instructions/s\n",
+            numEmulators, rounds, cyclesPerTurn, seconds, seconds * 1e9 / instructions, instructions / seconds / 1e6);
+
+    if (store)
+    {
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        for (long i = 0; i < numEmulators; i++)
+        {
+            crisp8SnapshotStoreCommit (store, i, fleet [i]);
+        }
+        clock_gettime (CLOCK_MONOTONIC, &end);
+
+        struct timespec synced;
+        int8_t syncResult = crisp8SnapshotStoreSync (store);
+        clock_gettime (CLOCK_MONOTONIC, &synced);
+
+        printf ("Checkpointed %ld emulators in %.3f ms, %s to disk in %.3f ms\n", numEmulators,
+                elapsed (&start, &end) * 1e3, syncResult < 0 ? "failed to sync" : "synced",
+                elapsed (&end, &synced) * 1e3);
+
+        crisp8SnapshotStoreClose (&store);
+    }
+
+    for (long i = 0; i < numEmulators; i++)
+    {
+        crisp8Destroy (&fleet [i]);
+    }
+
+    free (fleet);
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Prints the state an emulator publishes through an exporter (see export.h): its registers, stack and display as text.
+//
+// Usage: crisp8-peek <shared memory name> [interval in ms]
+//
+// Without an interval the latest snapshot is printed once. With one, a snapshot is printed every time a new one has
+// been published, checking at that interval, until the tool is interrupted.
+
+#include "export.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Prints a snapshot
+//
+// Parameters:
+//  snapshot: the snapshot to print
+static void printSnapshot (const struct crisp8ExportSnapshot* snapshot)
+{
+    printf ("snapshot %llu  cycle %llu  PC=%03X  I=%03X  DT=%02X  ST=%02X%s%s\n",
+            (unsigned long long)snapshot->sequence, (unsigned long long)snapshot->cycleCount, snapshot->PC,
+            snapshot->I, snapshot->delayTimer, snapshot->soundTimer, snapshot->soundPlaying ? "  sound" : "",
+            snapshot->exited ? "  exited" : "");
+
+    for (int i = 0; i < 16; i++)
+    {
+        printf ("V%X=%02X%c", i, snapshot->V [i], i == 15 ? '\n' : ' ');
+    }
+
+    printf ("stack:");
+    for (int i = 0; i < snapshot->stackDepth && i < 16; i++)
+    {
+        printf (" %03X", snapshot->stack [i]);
+    }
+    putchar ('\n');
+
+    // Pixels on the first plane are drawn as #, on the second as +, and on both as @
+    for (int y = 0; y < snapshot->displayHeight; y++)
+    {
+        for (int x = 0; x < snapshot->displayWidth; x++)
+        {
+            int on = 0;
+            for (int plane = 0; plane < CRISP8_DISPLAY_PLANES; plane++)
+            {
+                on |= ((snapshot->displayRows [plane][y][x / 64] >> (63 - x % 64)) & 1) << plane;
+            }
+
+            putchar (" #+@" [on]);
+        }
+
+        putchar ('\n');
+    }
+
+    fflush (stdout);
+}
+
+int main (int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf (stderr, "Usage: %s <shared memory name> [interval in ms]\n", argv [0]);
+        return 1;
+    }
+
+    long interval = argc > 2 ? strtol (argv [2], NULL, 10) : 0;
+
+    crisp8ExportReader reader;
+    if (crisp8ExportReaderOpen (&reader, argv [1]) < 0)
+    {
+        fprintf (stderr, "%s is not a crisp8 export\n", argv [1]);
+        return 1;
+    }
+
+    struct crisp8ExportSnapshot snapshot;
+
+    do
+    {
+        int8_t result = crisp8ExportReaderRead (reader, &snapshot);
+        if (result < 0 && interval <= 0)
+        {
+            fprintf (stderr, "No snapshot has been published to %s\n", argv [1]);
+            crisp8ExportReaderClose (&reader);
+            return 1;
+        }
+
+        if (result > 0)
+        {
+            printSnapshot (&snapshot);
+        }
+
+        if (interval > 0)
+        {
+            struct timespec sleep = { interval / 1000, (interval % 1000) * 1000000 };
+            nanosleep (&sleep, NULL);
+        }
+    } while (interval > 0);
+
+    crisp8ExportReaderClose (&reader);
+    return 0;
+}
@@ -0,0 +1,303 @@
+// Converts recordings written by a crisp8Recorder (see record.h).
+//
+// Usage: crisp8-recording <recording> info
+//        crisp8-recording <recording> png <file name prefix> [scale]
+//        crisp8-recording <recording> raw <output file or -> [scale]
+//
+// info prints the number of frames and how well they compressed. png writes every frame to <prefix>NNNNNN.png at its
+// own resolution. raw writes every frame as 8 bit RGBA to a single file (or standard output), always 128x64 pixels
+// times the scale so the frame size doesn't change when a program switches resolution; low resolution frames are
+// doubled. Feed it to ffmpeg with -f rawvideo -pix_fmt rgba -video_size <width>x<height> -framerate 60.
+//
+// The PNG files are written uncompressed, so the tool needs no libraries besides crisp8.
+
+#include "record.h"
+#include "render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// White on black, with the second XO-CHIP plane in red and pixels on in both planes in yellow
+static const uint32_t palette [4] = {0x000000FF, 0xFFFFFFFF, 0xFF0000FF, 0xFFFF00FF};
+
+static uint32_t crcTable [256];
+
+static void buildCrcTable (void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+        }
+
+        crcTable [i] = crc;
+    }
+}
+
+static uint32_t updateCrc (uint32_t crc, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = crcTable [(crc ^ data [i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+static void writeBigEndian32 (uint8_t* out, uint32_t value)
+{
+    out [0] = value >> 24;
+    out [1] = value >> 16;
+    out [2] = value >> 8;
+    out [3] = value;
+}
+
+// Writes a PNG chunk
+//
+// Parameters:
+//  file: the PNG file
+//  type: the four letter chunk type
+//  data: the contents of the chunk
+//  size: the size of the contents
+static void writeChunk (FILE* file, const char* type, const uint8_t* data, uint32_t size)
+{
+    uint8_t buffer [4];
+
+    writeBigEndian32 (buffer, size);
+    fwrite (buffer, 4, 1, file);
+    fwrite (type, 4, 1, file);
+
+    uint32_t crc = updateCrc (0xFFFFFFFF, (const uint8_t*)type, 4);
+    if (size)
+    {
+        fwrite (data, size, 1, file);
+        crc = updateCrc (crc, data, size);
+    }
+
+    crc ^= 0xFFFFFFFF;
+    writeBigEndian32 (buffer, crc);
+    fwrite (buffer, 4, 1, file);
+}
+
+// Writes an RGBA image as a PNG file using stored (uncompressed) deflate blocks
+//
+// Parameters:
+//  path: the file to write
+//  pixels: width * height pixels of 8 bit RGBA
+//  width: the width of the image
+//  height: the height of the image
+//
+// Return value:
+//  False if the file could not be written
+static bool writePng (const char* path, const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    FILE* file = fopen (path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    static const uint8_t signature [8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite (signature, sizeof (signature), 1, file);
+
+    uint8_t header [13];
+    writeBigEndian32 (header, width);
+    writeBigEndian32 (header + 4, height);
+    header [8] = 8;     // Bits per channel
+    header [9] = 6;     // RGBA
+    header [10] = 0;    // Deflate
+    header [11] = 0;    // Adaptive filtering (every row uses filter 0, none)
+    header [12] = 0;    // Not interlaced
+    writeChunk (file, "IHDR", header, sizeof (header));
+
+    // Every row starts with its filter type
+    size_t rowSize = (size_t)width * 4 + 1;
+    size_t rawSize = rowSize * height;
+    size_t numBlocks = (rawSize + 65534) / 65535;
+    size_t dataSize = 2 + rawSize + numBlocks * 5 + 4;
+
+    uint8_t* data = malloc (dataSize);
+    if (!data)
+    {
+        fclose (file);
+        return false;
+    }
+
+    size_t out = 0;
+    data [out++] = 0x78;    // zlib header: deflate with a 32K window, no dictionary
+    data [out++] = 0x01;
+
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+    size_t blockLeft = 0;
+    size_t rawLeft = rawSize;
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (size_t x = 0; x < rowSize; x++)
+        {
+            if (blockLeft == 0)
+            {
+                blockLeft = rawLeft < 65535 ? rawLeft : 65535;
+                data [out++] = rawLeft == blockLeft;    // Final block flag, stored block type
+                data [out++] = blockLeft & 0xFF;
+                data [out++] = blockLeft >> 8;
+                data [out++] = ~blockLeft & 0xFF;
+                data [out++] = (~blockLeft >> 8) & 0xFF;
+            }
+
+            uint8_t byte = x == 0 ? 0 : pixels [(size_t)y * width * 4 + x - 1];
+            data [out++] = byte;
+
+            adlerA = (adlerA + byte) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+            blockLeft--;
+            rawLeft--;
+        }
+    }
+
+    writeBigEndian32 (data + out, (adlerB << 16) | adlerA);
+    out += 4;
+
+    writeChunk (file, "IDAT", data, out);
+    writeChunk (file, "IEND", NULL, 0);
+    free (data);
+
+    return fclose (file) == 0;
+}
+
+// Renders a frame into 8 bit RGBA
+//
+// Parameters:
+//  renderer: a renderer for RGBA8888
+//  frame: the decoded frame
+//  width: the width of the display in the frame
+//  height: the height of the display in the frame
+//  scale: the scaling factor
+//  pixels: a buffer of 32 bit pixels for the renderer to draw into
+//  rgba: filled in with the bytes of the image
+static void renderFrame (const struct crisp8Renderer* renderer, const uint64_t* frame, uint8_t width, uint8_t height,
+                         uint8_t scale, uint32_t* pixels, uint8_t* rgba)
+{
+    size_t pitch = (size_t)width * scale * 4;
+    crisp8RenderPacked (renderer, frame, width, height, scale, pixels, pitch);
+
+    // The renderer writes 0xRRGGBBAA words, PNG and raw video want the bytes in that order in memory
+    for (size_t i = 0; i < (size_t)width * scale * height * scale; i++)
+    {
+        rgba [i * 4] = pixels [i] >> 24;
+        rgba [i * 4 + 1] = pixels [i] >> 16;
+        rgba [i * 4 + 2] = pixels [i] >> 8;
+        rgba [i * 4 + 3] = pixels [i];
+    }
+}
+
+int main (int argc, char** argv)
+{
+    if (argc < 3 || (strcmp (argv [2], "info") != 0 && argc < 4))
+    {
+        fprintf (stderr, "Usage: %s <recording> info\n"
+                         "       %s <recording> png <file name prefix> [scale]\n"
+                         "       %s <recording> raw <output file or -> [scale]\n", argv [0], argv [0], argv [0]);
+        return 1;
+    }
+
+    int scale = argc > 4 ? atoi (argv [4]) : 1;
+    if (scale < 1 || scale * 2 > CRISP8_RENDER_MAX_SCALE)
+    {
+        fprintf (stderr, "The scale has to be between 1 and %d\n", CRISP8_RENDER_MAX_SCALE / 2);
+        return 1;
+    }
+
+    buildCrcTable ();
+
+    FILE* file = fopen (argv [1], "rb");
+    if (!file)
+    {
+        perror (argv [1]);
+        return 1;
+    }
+
+    crisp8RecordingReader reader;
+    if (crisp8RecordingOpen (&reader, file) < 0)
+    {
+        fprintf (stderr, "%s is not a recording this version of crisp8 can read\n", argv [1]);
+        fclose (file);
+        return 1;
+    }
+
+    struct crisp8Renderer renderer;
+    crisp8RendererInit (&renderer, CRISP8_PIXEL_RGBA8888, palette, CRISP8_RENDER_INDEXED, 255);
+
+    size_t maxPixels = (size_t)CRISP8_DISPLAY_HIRES_WIDTH * scale * CRISP8_DISPLAY_HIRES_HEIGHT * scale;
+    uint32_t* pixels = malloc (maxPixels * 4);
+    uint8_t* rgba = malloc (maxPixels * 4);
+
+    FILE* raw = NULL;
+    if (strcmp (argv [2], "raw") == 0)
+    {
+        raw = strcmp (argv [3], "-") == 0 ? stdout : fopen (argv [3], "wb");
+        if (!raw)
+        {
+            perror (argv [3]);
+            return 1;
+        }
+    }
+    else if (strcmp (argv [2], "png") != 0 && strcmp (argv [2], "info") != 0)
+    {
+        fprintf (stderr, "Unknown command %s\n", argv [2]);
+        return 1;
+    }
+
+    uint64_t frame [CRISP8_RECORDING_FRAME_SIZE / 8];
+    uint8_t width;
+    uint8_t height;
+    uint64_t numFrames = 0;
+
+    while (crisp8RecordingRead (reader, frame, &width, &height))
+    {
+        if (raw)
+        {
+            int frameScale = width == CRISP8_DISPLAY_HIRES_WIDTH ? scale : scale * 2;
+            renderFrame (&renderer, frame, width, height, frameScale, pixels, rgba);
+            fwrite (rgba, maxPixels * 4, 1, raw);
+        }
+        else if (strcmp (argv [2], "png") == 0)
+        {
+            char path [4096];
+            snprintf (path, sizeof (path), "%s%06llu.png", argv [3], (unsigned long long)numFrames);
+
+            renderFrame (&renderer, frame, width, height, scale, pixels, rgba);
+            if (!writePng (path, rgba, width * scale, height * scale))
+            {
+                perror (path);
+                return 1;
+            }
+        }
+
+        numFrames++;
+    }
+
+    if (strcmp (argv [2], "info") == 0)
+    {
+        long size = ftell (file);
+        printf ("%llu frames, %ld bytes (%.1f bytes per frame, %.1f%% of raw frames)\n", (unsigned long long)numFrames,
+                size, numFrames ? (double)size / numFrames : 0.0,
+                numFrames ? 100.0 * size / ((double)numFrames * CRISP8_RECORDING_FRAME_SIZE) : 0.0);
+    }
+
+    if (raw && raw != stdout)
+    {
+        fclose (raw);
+    }
+
+    free (rgba);
+    free (pixels);
+    crisp8RecordingClose (&reader);
+    fclose (file);
+
+    return 0;
+}
@@ -0,0 +1,433 @@
+// Runs a program without a display, for batch jobs and scripts.
+//
+// Usage: crisp8-run [options] <rom>
+//
+//   -f frames     the number of 60 Hz frames to run (600 by default)
+//   -s speed      instructions per second (600 by default)
+//   -e events     stop at the first of these events, comma separated: fault, keywait, sound, frame, timer
+//   -k file       scripted key input (see below)
+//   -q quirk=old|new
+//                 sets a quirk (see config.h): shift, jump or memory. May be given more than once
+//   -m bytes      the size of memory. 4096 by default, or the XO-CHIP memory size if the program doesn't fit in that
+//   -r seed       the seed of the random number generator (0 by default)
+//   -t            turbo: run as fast as possible instead of in real time
+//
+// The run ends after the given number of frames, at the first event asked for with -e or when the program exits
+// (00FD). The final state is then printed to standard output as "name value" lines: the number of frames and
+// instructions run, why the run stopped, PC, the state and frame hashes (see state.h) and the timing. The exit status
+// is 0 unless the tool couldn't run the program at all.
+//
+// The key file holds lines of the form "<frame> <keys>": from that frame on, the keys (hex digits, or - for none) are
+// held down, until the next line. Lines must be in frame order; everything after a # is ignored. For example:
+//
+//   0    -
+//   120  5      # press 5 at two seconds
+//   125  -
+//   300  46     # hold 4 and 6
+
+#include "config.h"
+#include "crisp8.h"
+#include "defs.h"
+#include "fusion.h"
+#include "rom.h"
+#include "state.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// The key state from a given frame on
+struct keyChange
+{
+    uint64_t frame;
+    uint32_t keys;
+};
+
+struct runner
+{
+    struct keyChange* keyChanges;
+    size_t numKeyChanges;
+    size_t nextKeyChange;
+
+    // The key state the input callback reports
+    uint32_t keys;
+};
+
+static uint32_t inputCallback (void* userdata)
+{
+    return ((struct runner*)userdata)->keys;
+}
+
+static void audioCallback (void* userdata)
+{
+}
+
+// Reads a key file
+//
+// Parameters:
+//  runner: gets the key changes
+//  path: the file to read
+//
+// Return value:
+//  Negative if the file couldn't be read or has a mistake in it, which is reported
+static int loadKeys (struct runner* runner, const char* path)
+{
+    FILE* file = fopen (path, "r");
+    if (!file)
+    {
+        perror (path);
+        return -1;
+    }
+
+    char line [256];
+    int lineNumber = 0;
+    size_t capacity = 0;
+
+    while (fgets (line, sizeof (line), file))
+    {
+        lineNumber++;
+
+        char* comment = strchr (line, '#');
+        if (comment)
+        {
+            *comment = '\0';
+        }
+
+        unsigned long long frame;
+        char keys [64];
+        int fields = sscanf (line, "%llu %63s", &frame, keys);
+        if (fields <= 0)
+        {
+            continue;
+        }
+
+        struct keyChange change = {frame, 0};
+        bool valid = fields == 2 &&
+                     (runner->numKeyChanges == 0 || frame >= runner->keyChanges [runner->numKeyChanges - 1].frame);
+
+        if (valid && strcmp (keys, "-") != 0)
+        {
+            for (const char* key = keys; *key && valid; key++)
+            {
+                const char* digit = strchr ("0123456789abcdef", *key >= 'A' && *key <= 'F' ? *key - 'A' + 'a' : *key);
+                valid = digit != NULL;
+                change.keys |= valid ? 1 << (digit - "0123456789abcdef") : 0;
+            }
+        }
+
+        if (!valid)
+        {
+            fprintf (stderr, "%s:%d: expected \"<frame> <keys>\" in frame order\n", path, lineNumber);
+            fclose (file);
+            return -1;
+        }
+
+        if (runner->numKeyChanges == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            struct keyChange* grown = realloc (runner->keyChanges, capacity * sizeof (struct keyChange));
+            if (!grown)
+            {
+                fputs ("Out of memory\n", stderr);
+                fclose (file);
+                return -1;
+            }
+
+            runner->keyChanges = grown;
+        }
+
+        runner->keyChanges [runner->numKeyChanges++] = change;
+    }
+
+    fclose (file);
+    return 0;
+}
+
+// Parses the list of events given to -e
+//
+// Parameters:
+//  list: the comma separated names
+//  mask: set to the events
+//
+// Return value:
+//  Negative if a name isn't known
+static int parseEvents (char* list, uint32_t* mask)
+{
+    static const struct
+    {
+        const char* name;
+        uint32_t event;
+    } names [] = {{"fault", CRISP8_EVENT_FAULT}, {"keywait", CRISP8_EVENT_KEY_WAIT}, {"sound", CRISP8_EVENT_SOUND},
+                  {"frame", CRISP8_EVENT_FRAME}, {"timer", CRISP8_EVENT_TIMER}};
+
+    for (char* name = strtok (list, ","); name; name = strtok (NULL, ","))
+    {
+        size_t i = 0;
+        while (i < sizeof (names) / sizeof (names [0]) && strcmp (names [i].name, name) != 0)
+        {
+            i++;
+        }
+
+        if (i == sizeof (names) / sizeof (names [0]))
+        {
+            fprintf (stderr, "Unknown event %s\n", name);
+            return -1;
+        }
+
+        *mask |= names [i].event;
+    }
+
+    return 0;
+}
+
+// Parses a quirk setting given to -q and applies it
+//
+// Parameters:
+//  setting: the setting, quirk=old or quirk=new
+//  emulator: the emulator to configure
+//
+// Return value:
+//  Negative if the setting isn't understood
+static int applyQuirk (const char* setting, chip8 emulator)
+{
+    const char* value = strchr (setting, '=');
+    if (!value || (strcmp (value + 1, "old") != 0 && strcmp (value + 1, "new") != 0))
+    {
+        fprintf (stderr, "Expected quirk=old or quirk=new, got %s\n", setting);
+        return -1;
+    }
+
+    enum crisp8ConfigValue behaviour = strcmp (value + 1, "old") == 0 ? OLD : NEW;
+    size_t length = value - setting;
+
+    if (length == 5 && strncmp (setting, "shift", length) == 0)
+    {
+        crisp8ConfigSetShift (behaviour, emulator);
+    }
+    else if (length == 4 && strncmp (setting, "jump", length) == 0)
+    {
+        crisp8ConfigSetJumpOffset (behaviour, emulator);
+    }
+    else if (length == 6 && strncmp (setting, "memory", length) == 0)
+    {
+        crisp8ConfigSetStoreLoadMemory (behaviour, emulator);
+    }
+    else
+    {
+        fprintf (stderr, "Unknown quirk %.*s\n", (int)length, setting);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void usage (const char* program)
+{
+    fprintf (stderr,
+             "Usage: %s [-f frames] [-s speed] [-e events] [-k key file] [-q quirk=old|new]... [-m memory size]\n"
+             "          [-r seed] [-t] <rom>\n",
+             program);
+}
+
+static double secondsBetween (const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main (int argc, char** argv)
+{
+    unsigned long long frames = 600;
+    long speed = 600;
+    uint32_t stopEvents = 0;
+    const char* keyFile = NULL;
+    const char* quirks [16];
+    int numQuirks = 0;
+    long memorySize = 0;
+    unsigned long long seed = 0;
+    bool turbo = false;
+
+    int option;
+    while ((option = getopt (argc, argv, "f:s:e:k:q:m:r:t")) != -1)
+    {
+        switch (option)
+        {
+            case 'f':
+                frames = strtoull (optarg, NULL, 0);
+                break;
+            case 's':
+                speed = atol (optarg);
+                break;
+            case 'e':
+                if (parseEvents (optarg, &stopEvents) < 0)
+                {
+                    return 1;
+                }
+                break;
+            case 'k':
+                keyFile = optarg;
+                break;
+            case 'q':
+                if (numQuirks == sizeof (quirks) / sizeof (quirks [0]))
+                {
+                    fputs ("Too many quirks\n", stderr);
+                    return 1;
+                }
+                quirks [numQuirks++] = optarg;
+                break;
+            case 'm':
+                memorySize = strtol (optarg, NULL, 0);
+                break;
+            case 'r':
+                seed = strtoull (optarg, NULL, 0);
+                break;
+            case 't':
+                turbo = true;
+                break;
+            default:
+                usage (argv [0]);
+                return 1;
+        }
+    }
+
+    // crisp8SetFramerate takes the speed, which has to be a whole number of instructions per frame here
+    if (optind != argc - 1 || speed < 60 || speed > 65535 || memorySize < 0)
+    {
+        usage (argv [0]);
+        return 1;
+    }
+
+    uint32_t cyclesPerFrame = speed / 60;
+
+    crisp8Rom rom;
+    if (crisp8RomOpen (&rom, argv [optind]) < 0)
+    {
+        fprintf (stderr, "Could not load %s\n", argv [optind]);
+        return 1;
+    }
+
+    if (!memorySize)
+    {
+        memorySize = crisp8RomGetSize (rom) <= CRISP8_MEMORY_SIZE - 0x200 ? CRISP8_MEMORY_SIZE : CRISP8_XO_MEMORY_SIZE;
+    }
+
+    chip8 emulator;
+    if (crisp8InitWithMemorySize (&emulator, memorySize) < 0)
+    {
+        fprintf (stderr, "Invalid memory size %ld\n", memorySize);
+        crisp8RomClose (&rom);
+        return 1;
+    }
+
+    struct runner runner = {0};
+    int status = 1;
+
+    if (keyFile && loadKeys (&runner, keyFile) < 0)
+    {
+        goto cleanup;
+    }
+
+    for (int i = 0; i < numQuirks; i++)
+    {
+        if (applyQuirk (quirks [i], emulator) < 0)
+        {
+            goto cleanup;
+        }
+    }
+
+    crisp8SetFramerate (emulator, cyclesPerFrame * 60);
+    crisp8SetAudioCallbackWithData (emulator, audioCallback, NULL);
+    crisp8SetInputCallbackWithData (emulator, inputCallback, &runner);
+    crisp8SetRandomSeed (emulator, seed);
+    crisp8SetEventMask (emulator, stopEvents);
+    crisp8SetHeadless (emulator, true);
+    crisp8FusionEnable (emulator);
+
+    if (crisp8AttachRom (emulator, rom) < 0)
+    {
+        fprintf (stderr, "%s doesn't fit in %ld bytes of memory\n", argv [optind], memorySize);
+        goto cleanup;
+    }
+
+    struct timespec start;
+    struct timespec end;
+    struct timespec deadline;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    const char* reason = "frames";
+    uint64_t instructions = 0;
+    uint64_t frame = 0;
+
+    for (; frame < frames; frame++)
+    {
+        while (runner.nextKeyChange < runner.numKeyChanges && runner.keyChanges [runner.nextKeyChange].frame <= frame)
+        {
+            runner.keys = runner.keyChanges [runner.nextKeyChange++].keys;
+        }
+
+        if (stopEvents)
+        {
+            struct crisp8Event event;
+            crisp8RunUntilEvent (emulator, cyclesPerFrame, &event);
+            instructions += event.cyclesExecuted;
+
+            if (event.type != CRISP8_EVENT_NONE)
+            {
+                reason = event.type == CRISP8_EVENT_FAULT    ? "fault"
+                         : event.type == CRISP8_EVENT_KEY_WAIT ? "keywait"
+                         : event.type == CRISP8_EVENT_SOUND    ? "sound"
+                         : event.type == CRISP8_EVENT_FRAME    ? "frame"
+                                                               : "timer";
+                frame++;
+                break;
+            }
+        }
+        else
+        {
+            crisp8RunCycles (emulator, cyclesPerFrame, NULL);
+            instructions += cyclesPerFrame;
+        }
+
+        if (crisp8HasExited (emulator))
+        {
+            reason = "exit";
+            frame++;
+            break;
+        }
+
+        if (!turbo)
+        {
+            // Worked out from the frame number, since adding a period rounded to whole nanoseconds would drift
+            uint64_t offset = (frame + 1) * 1000000000 / 60 + start.tv_nsec;
+            deadline.tv_sec = start.tv_sec + offset / 1000000000;
+            deadline.tv_nsec = offset % 1000000000;
+
+            clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        }
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &end);
+    double seconds = secondsBetween (&start, &end);
+
+    struct crisp8Debug debug;
+    crisp8InitDebugStruct (&debug, emulator);
+
+    printf ("frames %llu\n", (unsigned long long)frame);
+    printf ("instructions %llu\n", (unsigned long long)instructions);
+    printf ("stop %s\n", reason);
+    printf ("pc 0x%03X\n", *debug.PC);
+    printf ("state-hash %016llx\n", (unsigned long long)crisp8StateHash (emulator));
+    printf ("frame-hash %016llx\n", (unsigned long long)crisp8FrameHash (emulator));
+    printf ("seconds %.6f\n", seconds);
+    printf ("instructions-per-second %.0f\n", seconds > 0 ? instructions / seconds : 0);
+    printf ("realtime-factor %.2f\n", seconds > 0 ? frame / 60.0 / seconds : 0);
+    status = 0;
+
+cleanup:
+    crisp8Destroy (&emulator);
+    crisp8RomClose (&rom);
+    free (runner.keyChanges);
+
+    return status;
+}
@@ -0,0 +1,99 @@
+// Decodes a binary trace written by crisp8TraceDump into text, one instruction per line.
+//
+// Usage: crisp8-trace <trace file> [number of records]
+//
+// If a number of records is given, only that many of the most recent records are printed.
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Prints a single record
+//
+// Parameters:
+//  record: the record to print
+static void printRecord (const struct crisp8TraceRecord* record)
+{
+    printf ("%12llu  %03X  %04X  I=%03X", (unsigned long long)record->cycle, record->PC, record->opcode, record->I);
+
+    for (int i = 0; i < 16; i++)
+    {
+        if (record->changedRegisters & (1 << i))
+        {
+            printf ("  V%X=%02X", i, record->V [i]);
+        }
+    }
+
+    printf ("  VF=%02X\n", record->V [0xF]);
+}
+
+int main (int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf (stderr, "Usage: %s <trace file> [number of records]\n", argv [0]);
+        return 1;
+    }
+
+    FILE* file = fopen (argv [1], "rb");
+    if (!file)
+    {
+        perror (argv [1]);
+        return 1;
+    }
+
+    struct crisp8TraceFileHeader header;
+    if (fread (&header, sizeof (header), 1, file) != 1 ||
+        memcmp (header.magic, CRISP8_TRACE_FILE_MAGIC, sizeof (CRISP8_TRACE_FILE_MAGIC)) != 0)
+    {
+        fprintf (stderr, "%s is not a crisp8 trace file\n", argv [1]);
+        fclose (file);
+        return 1;
+    }
+
+    if (header.version != CRISP8_TRACE_FILE_VERSION || header.byteOrderMark != 0x0102 ||
+        header.recordSize != sizeof (struct crisp8TraceRecord))
+    {
+        fprintf (stderr, "%s was written by an incompatible version of crisp8 or on a machine with a different byte "
+                         "order\n", argv [1]);
+        fclose (file);
+        return 1;
+    }
+
+    uint64_t skip = 0;
+    if (argc > 2)
+    {
+        uint64_t wanted = strtoull (argv [2], NULL, 0);
+        if (wanted < header.numRecords)
+        {
+            skip = header.numRecords - wanted;
+        }
+    }
+
+    if (fseek (file, (long)(skip * sizeof (struct crisp8TraceRecord)), SEEK_CUR) != 0)
+    {
+        perror (argv [1]);
+        fclose (file);
+        return 1;
+    }
+
+    printf ("%12s  %3s  %4s  %s\n", "cycle", "PC", "op", "state");
+
+    struct crisp8TraceRecord record;
+    for (uint64_t i = skip; i < header.numRecords; i++)
+    {
+        if (fread (&record, sizeof (record), 1, file) != 1)
+        {
+            fprintf (stderr, "%s is truncated\n", argv [1]);
+            fclose (file);
+            return 1;
+        }
+
+        printRecord (&record);
+    }
+
+    fclose (file);
+    return 0;
+}